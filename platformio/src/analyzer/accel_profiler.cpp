@@ -0,0 +1,135 @@
+#include "accel_profiler.h"
+
+#include "acquisition.h"
+
+namespace accel_profiler {
+
+// Speed is computed over windows of whole steps with at least this
+// duration, in ADC ticks (20ms). Shorter windows amplify the step
+// timing jitter in the acceleration and jerk values.
+static constexpr uint32_t kMinWindowTicks = acquisition::TicksPerSecond / 50;
+
+// Max number of step intervals to process per loop() call. Bounds
+// the time we block the main loop.
+static constexpr uint16_t kMaxIntervalsPerLoop = 1024;
+
+static constexpr float kSecsPerTick = 1.0f / acquisition::TicksPerSecond;
+
+struct Vars {
+  Stats stats;
+
+  // The window in progress.
+  uint32_t window_steps = 0;
+  uint32_t window_ticks = 0;
+
+  // Number of completed windows in the current segment, up to 2.
+  // Acceleration requires one previous window, jerk two.
+  uint8_t num_windows = 0;
+  // Speed of the last window, in steps/sec.
+  float last_speed = 0;
+  // Duration of the last window, in ticks.
+  uint32_t last_window_ticks = 0;
+  // Acceleration between the centers of the last two windows, in
+  // steps/sec^2.
+  float last_accel = 0;
+  // Time between the centers of the last two windows, in secs.
+  float last_speed_dt = 0;
+};
+
+static Vars vars;
+
+static void reset_segment() {
+  vars.window_steps = 0;
+  vars.window_ticks = 0;
+  vars.num_windows = 0;
+}
+
+void reset() {
+  memset(&vars.stats, 0, sizeof(vars.stats));
+  reset_segment();
+}
+
+const Stats& stats() { return vars.stats; }
+
+static void track_accel(float accel) {
+  Stats& stats = vars.stats;  // alias
+
+  if (accel > stats.max_accel) {
+    stats.max_accel = accel;
+  } else if (-accel > stats.max_decel) {
+    stats.max_decel = -accel;
+  }
+
+  uint32_t bucket_index = abs(accel) / kAccelBucketStepsPerSec2;
+  if (bucket_index >= kNumAccelBuckets) {
+    bucket_index = kNumAccelBuckets - 1;
+  }
+  stats.accel_bucket_ticks[bucket_index] += vars.window_ticks;
+}
+
+// Called when the window in progress is long enough. Speed is
+// associated with the center of each window, acceleration with the
+// midpoint between two window centers.
+static void process_window() {
+  const float speed = (float)vars.window_steps *
+                      acquisition::TicksPerSecond / vars.window_ticks;
+
+  if (vars.num_windows == 0) {
+    vars.stats.segments++;
+  } else {
+    // Time between the centers of the last two windows.
+    const float speed_dt =
+        (vars.last_window_ticks + vars.window_ticks) * (kSecsPerTick / 2);
+    const float accel = (speed - vars.last_speed) / speed_dt;
+    track_accel(accel);
+
+    if (vars.num_windows >= 2) {
+      // Time between the last two acceleration points.
+      const float accel_dt = (vars.last_speed_dt + speed_dt) / 2;
+      const float jerk = abs(accel - vars.last_accel) / accel_dt;
+      if (jerk > vars.stats.max_jerk) {
+        vars.stats.max_jerk = jerk;
+      }
+    }
+    vars.last_accel = accel;
+    vars.last_speed_dt = speed_dt;
+  }
+
+  if (vars.num_windows < 2) {
+    vars.num_windows++;
+  }
+  vars.last_speed = speed;
+  vars.last_window_ticks = vars.window_ticks;
+  vars.window_steps = 0;
+  vars.window_ticks = 0;
+}
+
+void loop() {
+  uint16_t bfr[64];
+  uint16_t intervals_processed = 0;
+
+  while (intervals_processed < kMaxIntervalsPerLoop) {
+    const uint16_t n = acquisition::consume_step_intervals(
+        bfr, sizeof(bfr) / sizeof(bfr[0]));
+    if (n == 0) {
+      return;
+    }
+    intervals_processed += n;
+
+    for (uint16_t i = 0; i < n; i++) {
+      const uint16_t ticks = bfr[i];
+      // A partial window at the end of a segment is ignored.
+      if (ticks == acquisition::kStepIntervalBreak) {
+        reset_segment();
+        continue;
+      }
+      vars.window_steps++;
+      vars.window_ticks += ticks;
+      if (vars.window_ticks >= kMinWindowTicks) {
+        process_window();
+      }
+    }
+  }
+}
+
+}  // namespace accel_profiler
@@ -0,0 +1,42 @@
+// Background analysis of the step intervals collected by the
+// acquisition module. Computes the speed, acceleration and jerk of
+// each continuous motion segment and collects their statistics.
+// Runs in the main loop, not in the interrupt routine.
+
+#pragma once
+
+#include <Arduino.h>
+
+namespace accel_profiler {
+
+// Number of acceleration histogram buckets.
+constexpr int kNumAccelBuckets = 20;
+
+// Each acceleration bucket represents a range of 2000 steps/sec^2
+// of absolute acceleration, starting from zero. Overflow values are
+// aggregated in the last bucket.
+constexpr uint32_t kAccelBucketStepsPerSec2 = 2000;
+
+struct Stats {
+  // Time spent in each absolute acceleration range, in ADC ticks.
+  uint64_t accel_bucket_ticks[kNumAccelBuckets];
+  // Max speed increase and decrease rates, in steps/sec^2.
+  float max_accel;
+  float max_decel;
+  // Max absolute rate of acceleration change, in steps/sec^3.
+  float max_jerk;
+  // Number of continuous motion segments analyzed.
+  uint32_t segments;
+};
+
+// Call frequently from the main loop. Consumes the pending step
+// intervals of the acquisition module and updates the stats.
+extern void loop();
+
+// Clears the stats.
+extern void reset();
+
+// Current stats. Valid until next call to loop() or reset().
+extern const Stats& stats();
+
+}  // namespace accel_profiler
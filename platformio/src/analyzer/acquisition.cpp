@@ -8,10 +8,13 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "adaptive_threshold.h"
+#include "config.h"
 #include "filters.h"
 #include "hal/adc.h"
 #include "hal/dma.h"
 #include "hal/gpio.h"
+#include "hal/tim.h"
 
 namespace acquisition {
 
@@ -19,6 +22,12 @@ namespace acquisition {
 // state the UI can use.
 static State sampled_state;
 
+// Updated by sample_moves().
+static MoveRecords sampled_moves;
+
+// Updated by sample_stall_events().
+static StallEvents sampled_stall_events;
+
 // 12 bit -> 4096 counts. 3.3V full scale.
 // 0.4V per AMP (for +/- 2.5A sensor).
 constexpr float kCountsPerAmp = 0.4 * 4096 / 3.3;
@@ -37,6 +46,64 @@ constexpr float kMilliampsPerCount = 1000 / kCountsPerAmp;
 constexpr uint16_t kNonEnergizedThresholdCounts = 50;
 constexpr uint16_t kEnergizedThresholdCounts = 150;
 
+// A move ends if no step transition occurs for this number of
+// ticks (100ms).
+constexpr uint32_t kMoveDwellTicks = TicksPerSecond / 10;
+
+// Stall detection. A current collapse is reported if the squared
+// current vector magnitude stays below 1/2^n of its peak in the move
+// for this number of ticks (2ms).
+constexpr int kCollapseMagnitudeSqBits = 2;
+constexpr uint16_t kCollapseTicks = TicksPerSecond / 500;
+// A step is distorted if its min squared current vector magnitude
+// is below 1/2^n of its max.
+constexpr int kDistortionMagnitudeSqBits = 2;
+// The signal filters spread a jump of the coil currents over a few
+// ticks, so it seldom skips a quadrant within a single tick. A jump is
+// also reported if two steps in the same direction are this number of
+// ticks or less apart (40us, far above the max step rate), or if a
+// move is cut by a loss of the energized state for up to this number
+// of ticks, as when the current vector jumps across zero.
+constexpr uint16_t kQuadrantJumpTicks = 4;
+
+// The two channels of an axis are converted one after the other, so
+// channel 2 is sampled one ADC conversion after channel 1. With ADC
+// clock of 84Mhz/4 and 3 + 12 cycles per conversion this is ~714ns, or
+// ~7% of a tick. We compensate by interpolating channel 2 between its
+// previous and current samples, to the sample time of channel 1. This
+// is the weight of the previous sample, in 1/2^16 units.
+constexpr uint32_t kAdcConversionNanos = 714;
+constexpr int32_t kChannel2SkewQ16 =
+    (kAdcConversionNanos << 16) / (kUsecsPerTick * 1000);
+
+// The decoder accepts ADC samples with this number of additional
+// fraction bits. These are the sums of kOversamplingFactor samples in
+// the oversampling mode, and single samples shifted left otherwise.
+constexpr int kScaledSampleFractionBits = 2;
+static_assert((1 << kScaledSampleFractionBits) == kOversamplingFactor,
+              "Inconsistent oversampling factor");
+static_assert(dma::kDmaAdcPointBufferSize % kOversamplingFactor == 0,
+              "DMA buffer should have whole oversampling groups");
+
+// Resonance map. The squared current vector magnitude is scaled
+// down by 2^n before the ripple tracking, to at most 15 bits, so the
+// per step sums don't overflow within kMaxTicksInStep ticks, and the
+// bucket sums of squares don't overflow within 2^34 ticks (47 hours)
+// of full scale current. Longer steps are not added to the histogram.
+constexpr int kRippleMagnitudeSqShift = 10;
+
+// Step peak current percentiles. Each estimate moves up by
+// kPercentileUpSteps[p] when a step is at or above it and down by
+// kPercentileTotalSteps - kPercentileUpSteps[p] otherwise. This
+// converges to the point where the fraction of steps below the
+// estimate is kPercentileUpSteps[p] / kPercentileTotalSteps. In
+// ADC counts << kPeakPercentileFractionBits.
+constexpr uint16_t kPercentileTotalSteps = 20;
+constexpr uint16_t kPercentileUpSteps[] = {1, 10, 19};
+static_assert(sizeof(kPercentileUpSteps) / sizeof(kPercentileUpSteps[0]) ==
+                  NUM_PEAK_PERCENTILES,
+              "Inconsistent percentiles table");
+
 // Hysteresis for determining quadrant transitions. In
 // milliamps and in ADC counts.
 // constexpr int kQuadrantHisteresisMilliamps = 100;
@@ -55,6 +122,10 @@ constexpr uint16_t kEnergizedThresholdCounts = 150;
 constexpr int kMinOffset = 0;
 constexpr int kMaxOffset = 4095;  // 12 bits max
 
+// This is an arbitrary number of divided samples that we allow
+// to wait for a trigger event.
+constexpr uint32_t kCapturePreTriggerItems = 500;
+
 enum CaptureState {
   // Filling half of the capture buffer.
   CAPTURE_HALF_FILL,
@@ -68,31 +139,148 @@ enum CaptureState {
   CAPTURE_IDLE,
 };
 
-// This data is accessed from interrupt and thus should
-// be access from main() with IRQ disabled.
-struct IsrData {
+// The decoder of a single axis, i.e. a single motor with its pair of
+// coil current channels. Accessed from interrupt, see IsrData.
+//
+// The fields that are accessed on each sample come first, followed
+// by the state with the histogram, and the buffers last. This keeps
+// the hot fields at small offsets from the axis base address.
+struct AxisDecoder {
+  // We use these filters to reduce internal and external noise.
+  //
+  // NOTE: these filters slow the interrupt handling. Consider
+  // to eliminate if free CPU time is insufficient.
+  filters::Adc12BitsLowPassFilter<700> signal1_filter;
+  filters::Adc12BitsLowPassFilter<400> signal2_filter;
+  // The previous scaled channel 2 sample, for the sampling time
+  // compensation. See kChannel2SkewQ16.
+  uint16_t prev_scaled_v2 = 0;
+
+  // Adaptive threshold tracking.
+  adaptive_threshold::AdaptiveThreshold adaptive_threshold;
+
+  // Stall detection.
+  // Peak of v1^2 + v2^2 in the move in progress. Decays slowly, like
+  // the adaptive threshold peak current.
+  uint32_t peak_magnitude_sq = 0;
+  // Consecutive ticks with collapsed current magnitude.
+  uint16_t collapse_ticks = 0;
+  // Min/max of v1^2 + v2^2 in the current step.
+  uint32_t step_min_magnitude_sq = 0;
+  uint32_t step_max_magnitude_sq = 0;
+  // Sum and sum of squares of the scaled v1^2 + v2^2 in the current
+  // step. The sample count is state.ticks_in_step.
+  uint32_t step_ripple_sum = 0;
+  uint64_t step_ripple_sum_sq = 0;
+  // True if a move was cut by a loss of the energized state, at the
+  // tick_count move_cut_tick, and the axis was not energized since.
+  bool move_cut = false;
+  uint32_t move_cut_tick = 0;
+
+  // Move segmentation.
+  // True if a move is in progress.
+  bool move_active = false;
+  // Direction of the move in progress.
+  Direction move_direction = UNKNOWN_DIRECTION;
+  // The move in progress. Valid if move_active.
+  MoveRecord move;
+
   // The state visible to users.
   State state;
+  // The step speed histogram, with the layout of state.histogram_scale.
+  HistogramBucket buckets[kNumHistogramBuckets] = {};
+
+  // True if step intervals were dropped since the buffer was full. A
+  // break is inserted when space becomes available.
+  bool step_intervals_overflow = false;
+  // Intervals of recent steps, for background analysis.
+  CircularBuffer<uint16_t, kStepIntervalsBufferSize> step_intervals;
+  // Completed moves.
+  MoveRecords moves;
+  // Detected stall events.
+  StallEvents stall_events;
+};
+
+// Tracks the min and max of a signal over a peak detect interval
+// and the order in which they occurred.
+struct PeakTracker {
+  int16_t min;
+  int16_t max;
+  // True if the max occurred after the min.
+  bool max_is_last;
 
+  PeakTracker() { reset(); }
+
+  inline void reset() {
+    min = INT16_MAX;
+    max = INT16_MIN;
+    max_is_last = false;
+  }
+
+  inline void add(int16_t v) {
+    if (v < min) {
+      min = v;
+      max_is_last = false;
+    }
+    if (v > max) {
+      max = v;
+      max_is_last = true;
+    }
+  }
+
+  inline int16_t first() const { return max_is_last ? min : max; }
+  inline int16_t last() const { return max_is_last ? max : min; }
+};
+
+// This data is accessed from interrupt and thus should
+// be access from main() with IRQ disabled.
+struct IsrData {
   // Current settings.
   Settings settings;
 
-  // Signal capturing.
+  // The per axis decoders.
+  AxisDecoder axes[config::kNumAxes];
+
+  // The axis that is reported by the sample_*() functions and that
+  // is captured. Changed by select_axis().
+  uint8_t selected_axis = 0;
+
+  // Signal capturing. There is a single capture buffer, of the
+  // selected axis, to save RAM.
   // Time out for waiting for trigger in divided ADC ticks.
   uint32_t capture_pre_trigger_items_left = 0;
-  // Factor to divide ADC ticks. Only every n'th sample is captured.
-  uint16_t capture_divider = 1;
-  // Up counter for capturing only every n'th samples.
-  uint16_t capture_divider_counter = 0;
+  // Number of ADC ticks per capture interval. This is the divider,
+  // or twice the divider in the peak detect mode which captures two
+  // items per interval.
+  uint16_t capture_interval = 1;
+  CaptureMode capture_mode = CAPTURE_MODE_SAMPLE;
+  // Up counter of the ADC ticks in the current interval.
+  uint16_t capture_interval_counter = 0;
+  // Sums of the samples of the current interval, for the average mode.
+  int32_t capture_sum1 = 0;
+  int32_t capture_sum2 = 0;
+  // Extremes of the current interval, for the peak detect mode.
+  PeakTracker capture_peak1;
+  PeakTracker capture_peak2;
   // Capturing state.
   CaptureState capture_state = CAPTURE_IDLE;
   // The capture buffer itself. Updated by ISR when state != CAPTURE_IDLE
   // and accessible by the UI (ready only) when state = CAPTURE_IDLE.
   CaptureBuffer capture_buffer;
+
+  // In the roll mode the capture state is CAPTURE_IDLE and the items
+  // go to the roll buffer instead.
+  bool roll_enabled = false;
+  CircularBuffer<CaptureItem, kRollBufferSize> roll_items;
 };
 
 static IsrData isr_data;
 
+// The decoder of the selected axis. Call with irq disabled.
+static inline AxisDecoder& selected_axis_decoder() {
+  return isr_data.axes[isr_data.selected_axis];
+}
+
 extern bool is_capture_ready() {
   CaptureState capture_state;
   __disable_irq();
@@ -101,54 +289,261 @@ extern bool is_capture_ready() {
   return capture_state == CAPTURE_IDLE;
 }
 
-extern void start_capture(uint16_t divider) {
+// Start a new capture interval. Called from isr or with IRQ
+// disabled.
+static inline void isr_reset_capture_interval() {
+  isr_data.capture_interval_counter = 0;
+  isr_data.capture_sum1 = 0;
+  isr_data.capture_sum2 = 0;
+  isr_data.capture_peak1.reset();
+  isr_data.capture_peak2.reset();
+}
+
+// Set the capture divider and mode and start a new interval. Called
+// with IRQ disabled.
+static void isr_set_capture_interval(uint16_t divider, CaptureMode mode) {
   // Force a reasonable range.
   if (divider < 1) {
     divider = 1;
-  } else if (divider > 1000) {
-    divider = 1000;
+  } else if (divider > kMaxCaptureDivider) {
+    divider = kMaxCaptureDivider;
   }
+  isr_data.capture_interval =
+      mode == CAPTURE_MODE_PEAK_DETECT ? 2 * divider : divider;
+  isr_data.capture_mode = mode;
+  isr_reset_capture_interval();
+}
+
+extern void start_capture(uint16_t divider, CaptureMode mode) {
 
   // Since capture may be active, data can co-access by ISR.
   __disable_irq();
   {
     isr_data.capture_buffer.items.clear();
     isr_data.capture_buffer.trigger_found = false;
-    // This is an arbitrary number of divided samples that we allow
-    // to wait for a trigger event.
-    isr_data.capture_pre_trigger_items_left = 500;
-    isr_data.capture_divider = divider;
-    isr_data.capture_divider_counter = 0;
+    isr_data.capture_buffer.divider = divider;
+    isr_data.capture_buffer.mode = mode;
+    isr_data.capture_pre_trigger_items_left = kCapturePreTriggerItems;
+    isr_set_capture_interval(divider, mode);
+    isr_data.roll_enabled = false;
     isr_data.capture_state = CAPTURE_HALF_FILL;
   }
   __enable_irq();
 }
 
+void start_roll(uint16_t divider, CaptureMode mode) {
+  __disable_irq();
+  {
+    // The partial content of a capture in progress is not valid.
+    isr_data.capture_buffer.items.clear();
+    isr_data.capture_buffer.trigger_found = false;
+    isr_data.capture_state = CAPTURE_IDLE;
+    isr_set_capture_interval(divider, mode);
+    isr_data.roll_items.clear();
+    isr_data.roll_enabled = true;
+  }
+  __enable_irq();
+}
+
+bool is_rolling() {
+  bool result;
+  __disable_irq();
+  { result = isr_data.roll_enabled; }
+  __enable_irq();
+  return result;
+}
+
+bool is_idle() {
+  bool result;
+  __disable_irq();
+  {
+    result = isr_data.capture_state == CAPTURE_IDLE && !isr_data.roll_enabled;
+    for (int i = 0; result && i < config::kNumAxes; i++) {
+      result = !isr_data.axes[i].state.is_energized;
+    }
+  }
+  __enable_irq();
+  return result;
+}
+
+uint16_t consume_roll_items(CaptureItem* bfr, uint16_t max_count) {
+  uint16_t count;
+  __disable_irq();
+  {
+    CircularBuffer<CaptureItem, kRollBufferSize>& items =
+        isr_data.roll_items;  // alias
+    count = min(items.size(), max_count);
+    for (uint16_t i = 0; i < count; i++) {
+      bfr[i] = *items.get(i);
+    }
+    items.remove_oldest(count);
+  }
+  __enable_irq();
+  return count;
+}
+
 // Users are expected to read this buffer only when capturing
 // is not active.
 const CaptureBuffer* capture_buffer() { return &isr_data.capture_buffer; }
 
 const State* sample_state() {
   __disable_irq();
-  sampled_state = isr_data.state;
+  sampled_state = selected_axis_decoder().state;
   __enable_irq();
   return &sampled_state;
 }
 
+void sample_histogram_bucket(int index, HistogramBucket* bucket) {
+  if (index < 0 || index >= kNumHistogramBuckets) {
+    memset(bucket, 0, sizeof(*bucket));
+    return;
+  }
+  __disable_irq();
+  *bucket = selected_axis_decoder().buckets[index];
+  __enable_irq();
+}
+
+int64_t sample_full_steps() {
+  __disable_irq();
+  const int64_t full_steps = selected_axis_decoder().state.full_steps;
+  __enable_irq();
+  return full_steps;
+}
+
+uint16_t consume_step_intervals(uint16_t* bfr, uint16_t max_count) {
+  uint16_t count;
+  __disable_irq();
+  {
+    CircularBuffer<uint16_t, kStepIntervalsBufferSize>& intervals =
+        selected_axis_decoder().step_intervals;  // alias
+    count = min(intervals.size(), max_count);
+    for (uint16_t i = 0; i < count; i++) {
+      bfr[i] = *intervals.get(i);
+    }
+    intervals.remove_oldest(count);
+  }
+  __enable_irq();
+  return count;
+}
+
+const MoveRecords* sample_moves() {
+  __disable_irq();
+  sampled_moves = selected_axis_decoder().moves;
+  __enable_irq();
+  return &sampled_moves;
+}
+
+float bucket_ripple_percent(const HistogramBucket& bucket) {
+  if (!bucket.total_ticks_in_steps || !bucket.total_ripple_sum) {
+    return 0;
+  }
+  // The isr only accumulates, the division is done here. In double
+  // since the variance is a small difference of large values.
+  const double n = bucket.total_ticks_in_steps;
+  const double mean = bucket.total_ripple_sum / n;
+  const double variance = bucket.total_ripple_sum_sq / n - mean * mean;
+  if (variance <= 0) {
+    return 0;
+  }
+  // Relative variance of the squared magnitude. Since (m(1 + e))^2 ~
+  // m^2 (1 + 2e) for small e, the relative deviation of the magnitude
+  // is half of that of the squared magnitude.
+  return 50 * sqrt(variance) / mean;
+}
+
+int bucket_peak_current_percentile(const HistogramBucket& bucket,
+                                   PeakPercentile percentile) {
+  if (!bucket.total_steps) {
+    return 0;
+  }
+  return bucket.step_peak_current_percentiles[percentile] >>
+         kPeakPercentileFractionBits;
+}
+
+uint32_t move_peak_steps_per_sec(const MoveRecord& move) {
+  return move.min_ticks_in_step < 0xffff
+             ? TicksPerSecond / move.min_ticks_in_step
+             : 0;
+}
+
+const StallEvents* sample_stall_events() {
+  __disable_irq();
+  sampled_stall_events = selected_axis_decoder().stall_events;
+  __enable_irq();
+  return &sampled_stall_events;
+}
+
+// Clear the data of a single axis. Called with irq disabled.
+static void reset_axis_state(AxisDecoder& axis) {
+  axis.state.reset_tick_count = axis.state.tick_count;
+  axis.state.non_energized_count = 0;
+  axis.state.full_steps = 0;
+  axis.state.total_full_steps = 0;
+  axis.state.max_full_steps = 0;
+  axis.state.max_retraction_steps = 0;
+  axis.state.quadrature_errors = 0;
+  memset(axis.buckets, 0, sizeof(axis.buckets));
+  axis.step_intervals.clear();
+  axis.step_intervals_overflow = false;
+  axis.move_active = false;
+  axis.moves.items.clear();
+  axis.moves.total_moves = 0;
+  axis.stall_events.items.clear();
+  memset(axis.stall_events.counts, 0, sizeof(axis.stall_events.counts));
+}
+
 void reset_state() {
   __disable_irq();
   {
-    isr_data.state.tick_count = 0;
-    isr_data.state.non_energized_count = 0;
-    isr_data.state.full_steps = 0;
-    isr_data.state.max_full_steps = 0;
-    isr_data.state.max_retraction_steps = 0;
-    isr_data.state.quadrature_errors = 0;
-    memset(isr_data.state.buckets, 0, sizeof(isr_data.state.buckets));
+    for (AxisDecoder& axis : isr_data.axes) {
+      reset_axis_state(axis);
+    }
+  }
+  __enable_irq();
+}
+
+uint64_t reset_tick_count() {
+  uint64_t result;
+  __disable_irq();
+  { result = selected_axis_decoder().state.reset_tick_count; }
+  __enable_irq();
+  return result;
+}
+
+void select_axis(uint8_t axis_index) {
+  if (axis_index >= config::kNumAxes) {
+    axis_index = 0;
+  }
+  __disable_irq();
+  {
+    if (axis_index != isr_data.selected_axis) {
+      isr_data.selected_axis = axis_index;
+      // Restart a capture in progress so it doesn't mix the two axes.
+      if (isr_data.capture_state != CAPTURE_IDLE) {
+        isr_data.capture_buffer.items.clear();
+        isr_data.capture_buffer.trigger_found = false;
+        isr_data.capture_pre_trigger_items_left = kCapturePreTriggerItems;
+        isr_reset_capture_interval();
+        isr_data.capture_state = CAPTURE_HALF_FILL;
+      }
+      // Restart the roll so it doesn't mix the two axes.
+      if (isr_data.roll_enabled) {
+        isr_reset_capture_interval();
+        isr_data.roll_items.clear();
+      }
+      // Not meaningful for the new axis.
+      selected_axis_decoder().step_intervals.clear();
+      selected_axis_decoder().step_intervals_overflow = false;
+    }
   }
   __enable_irq();
 }
 
+uint8_t selected_axis() {
+  // Single byte read, no need to disable irq.
+  return isr_data.selected_axis;
+}
+
 int adc_value_to_milliamps(int adc_value) {
   return (int)(adc_value * kMilliampsPerCount);
 }
@@ -160,8 +555,10 @@ float adc_value_to_amps(int adc_value) {
 void calibrate_zeros() {
   __disable_irq();
   {
-    isr_data.settings.offset1 += isr_data.state.v1;
-    isr_data.settings.offset2 += isr_data.state.v2;
+    for (int i = 0; i < config::kNumAxes; i++) {
+      isr_data.settings.offsets[i].offset1 += isr_data.axes[i].state.v1;
+      isr_data.settings.offsets[i].offset2 += isr_data.axes[i].state.v2;
+    }
   }
   __enable_irq();
 }
@@ -172,6 +569,61 @@ void set_direction(bool reverse_direction) {
   __enable_irq();
 }
 
+// Set the energized thresholds based on current settings and
+// measurements. Called from the isr and also with irq disabled.
+static inline void isr_update_thresholds(AxisDecoder& axis) {
+  State& isr_state = axis.state;  // alias
+
+  if (!isr_data.settings.adaptive_threshold) {
+    isr_state.energized_threshold = kEnergizedThresholdCounts;
+    isr_state.non_energized_threshold = kNonEnergizedThresholdCounts;
+    return;
+  }
+
+  axis.adaptive_threshold.update(&isr_state.energized_threshold,
+                                 &isr_state.non_energized_threshold);
+}
+
+// Decay the peak current vector magnitude so it can follow a
+// lower driver current. Called periodically from the isr.
+static inline void isr_decay_peak_magnitude(AxisDecoder& axis) {
+  axis.peak_magnitude_sq -= axis.peak_magnitude_sq >>
+                            adaptive_threshold::kPeakDecayBits;
+}
+
+void set_adaptive_threshold(bool adaptive_threshold) {
+  __disable_irq();
+  {
+    isr_data.settings.adaptive_threshold = adaptive_threshold;
+    for (AxisDecoder& axis : isr_data.axes) {
+      isr_update_thresholds(axis);
+    }
+  }
+  __enable_irq();
+}
+
+void set_oversampling(bool oversampling) {
+  oversampling = oversampling && kOversamplingSupported;
+  __disable_irq();
+  {
+    isr_data.settings.oversampling = oversampling;
+    tim::set_trigger_rate_factor(oversampling ? kOversamplingFactor : 1);
+  }
+  __enable_irq();
+}
+
+void set_histogram_scale(histogram::Scale histogram_scale) {
+  __disable_irq();
+  {
+    isr_data.settings.histogram_scale = histogram_scale;
+    for (AxisDecoder& axis : isr_data.axes) {
+      axis.state.histogram_scale = histogram_scale;
+      memset(axis.buckets, 0, sizeof(axis.buckets));
+    }
+  }
+  __enable_irq();
+}
+
 void get_settings(Settings* settings) {
   __disable_irq();
   { *settings = isr_data.settings; }
@@ -180,31 +632,40 @@ void get_settings(Settings* settings) {
 
 void dump_sampled_state() {
   // Remember last tick count and report only diff.
-  static uint32_t last_tick_count = 0;
+  static uint64_t last_tick_count = 0;
 
+  // NOTE: steps are printed as 32 bits values since the printf
+  // we use doesn't support 64 bits values.
   Serial.printf(
-      "[%lu][er:%lu] [%5d, %5d] [en:%d %lu] s:%d/%d  steps:%d max_steps:%d\n",
-      sampled_state.tick_count - last_tick_count,
+      "[%lu][er:%lu] [%5d, %5d] [en:%d %lu %hu/%hu] s:%d/%d  steps:%ld "
+      "max_steps:%ld\n",
+      (uint32_t)(sampled_state.tick_count - last_tick_count),
       sampled_state.quadrature_errors, sampled_state.v1, sampled_state.v2,
       sampled_state.is_energized, sampled_state.non_energized_count,
-      sampled_state.quadrant, sampled_state.last_step_direction,
-      sampled_state.full_steps, sampled_state.max_full_steps);
+      sampled_state.energized_threshold,
+      sampled_state.non_energized_threshold, sampled_state.quadrant,
+      sampled_state.last_step_direction, (int32_t)sampled_state.full_steps,
+      (int32_t)sampled_state.max_full_steps);
 
   last_tick_count = sampled_state.tick_count;
 
-  for (int i = 0; i < acquisition::kNumHistogramBuckets; i++) {
-    Serial.print(sampled_state.buckets[i].total_ticks_in_steps);
+  const int num_buckets = histogram::num_buckets(sampled_state.histogram_scale);
+
+  HistogramBucket bucket;
+  for (int i = 0; i < num_buckets; i++) {
+    sample_histogram_bucket(i, &bucket);
+    Serial.print(bucket.total_ticks_in_steps);
     Serial.print(" ");
   }
   Serial.println();
 
   Serial.println("...");
 
-  for (int i = 0; i < acquisition::kNumHistogramBuckets; i++) {
+  for (int i = 0; i < num_buckets; i++) {
+    sample_histogram_bucket(i, &bucket);
     const uint32_t avg_peak_current =
-        sampled_state.buckets[i].total_steps
-            ? (sampled_state.buckets[i].total_step_peak_currents /
-               sampled_state.buckets[i].total_steps)
+        bucket.total_steps
+            ? (bucket.total_step_peak_currents / bucket.total_steps)
             : 0;
     Serial.print(avg_peak_current);
 
@@ -228,9 +689,57 @@ void dump_capture(const CaptureBuffer& buffer) {
   }
 }
 
+// Update the min, max and percentile estimates of the step peak
+// current of a histogram bucket. Called from isr before the step is
+// added to the bucket.
+static inline void isr_track_peak_current_distribution(
+    HistogramBucket& bucket, uint32_t max_current_in_step) {
+  const uint16_t peak = max_current_in_step;
+  const uint16_t scaled_peak = peak << kPeakPercentileFractionBits;
+
+  // First step in this bucket.
+  if (!bucket.total_steps) {
+    bucket.min_step_peak_current = peak;
+    bucket.max_step_peak_current = peak;
+    for (int p = 0; p < NUM_PEAK_PERCENTILES; p++) {
+      bucket.step_peak_current_percentiles[p] = scaled_peak;
+    }
+    return;
+  }
+
+  if (peak < bucket.min_step_peak_current) {
+    bucket.min_step_peak_current = peak;
+  } else if (peak > bucket.max_step_peak_current) {
+    bucket.max_step_peak_current = peak;
+  }
+
+  // Move each estimate toward the new value, without crossing it.
+  for (int p = 0; p < NUM_PEAK_PERCENTILES; p++) {
+    uint16_t& estimate = bucket.step_peak_current_percentiles[p];
+    if (scaled_peak >= estimate) {
+      const uint16_t up = kPercentileUpSteps[p];
+      estimate = (scaled_peak - estimate > up) ? estimate + up : scaled_peak;
+    } else {
+      const uint16_t down = kPercentileTotalSteps - kPercentileUpSteps[p];
+      estimate =
+          (estimate - scaled_peak > down) ? estimate - down : scaled_peak;
+    }
+  }
+}
+
+// Add the ripple sums of a completed step to its bucket. The sample
+// count is the ticks_in_step that is added to the bucket. No
+// divisions, see bucket_ripple_percent(). Called from isr.
+static inline void isr_record_step_ripple(const AxisDecoder& axis,
+                                          HistogramBucket& bucket) {
+  bucket.total_ripple_sum += axis.step_ripple_sum;
+  bucket.total_ripple_sum_sq += axis.step_ripple_sum_sq;
+}
+
 // Maybe add step's information to the histogram.
 // Called from isr on step transition.
-inline void isr_add_step_to_histogram(int quadrant, Direction entry_direction,
+inline void isr_add_step_to_histogram(AxisDecoder& axis, int quadrant,
+                                      Direction entry_direction,
                                       Direction exit_direction,
                                       uint32_t ticks_in_step,
                                       uint32_t max_current_in_step) {
@@ -240,24 +749,197 @@ inline void isr_add_step_to_histogram(int quadrant, Direction entry_direction,
       entry_direction == UNKNOWN_DIRECTION) {
     return;
   }
-  uint32_t steps_per_sec =
-      TicksPerSecond / ticks_in_step;  // speed in steps per second
-  if (steps_per_sec < 10) {
-    return;  // ignore very slow steps as they dominate the time.
-  }
-  uint32_t bucket_index = steps_per_sec / kBucketStepsPerSecond;
-  if (bucket_index >= kNumHistogramBuckets) {
-    bucket_index = kNumHistogramBuckets - 1;
+  const int bucket_index =
+      histogram::bucket_index(axis.state.histogram_scale, ticks_in_step);
+  if (bucket_index < 0) {
+    return;
   }
-  HistogramBucket& bucket = isr_data.state.buckets[bucket_index];
+  HistogramBucket& bucket = axis.buckets[bucket_index];
+  isr_track_peak_current_distribution(bucket, max_current_in_step);
   bucket.total_ticks_in_steps += ticks_in_step;
   bucket.total_step_peak_currents += max_current_in_step;
   bucket.total_steps++;
+  isr_record_step_ripple(axis, bucket);
+}
+
+// Buffer a step interval or a break for background analysis.
+// Called from isr.
+static inline void isr_push_step_interval(AxisDecoder& axis, uint16_t value) {
+  CircularBuffer<uint16_t, kStepIntervalsBufferSize>& intervals =
+      axis.step_intervals;  // alias
+
+  if (axis.step_intervals_overflow) {
+    // Need room for the break and the value.
+    if (intervals.size() + 2 > intervals.capacity()) {
+      return;
+    }
+    *intervals.insert() = kStepIntervalBreak;
+    axis.step_intervals_overflow = false;
+  } else if (intervals.is_full()) {
+    axis.step_intervals_overflow = true;
+    return;
+  }
+
+  *intervals.insert() = value;
+}
+
+// Buffer the interval of a completed step. Steps that were not entered
+// and exited in the same direction break the motion. Called from isr.
+static inline void isr_add_step_interval(AxisDecoder& axis,
+                                         Direction entry_direction,
+                                         Direction exit_direction,
+                                         uint32_t ticks_in_step) {
+  if (entry_direction != exit_direction ||
+      entry_direction == UNKNOWN_DIRECTION) {
+    isr_push_step_interval(axis, kStepIntervalBreak);
+    return;
+  }
+  isr_push_step_interval(axis, ticks_in_step < 0xffff ? ticks_in_step : 0xffff);
+}
+
+// Complete the move in progress, if any. Called from isr.
+static inline void isr_end_move(AxisDecoder& axis) {
+  if (!axis.move_active) {
+    return;
+  }
+  axis.move_active = false;
+  // If the buffer is full this drops the oldest move.
+  *axis.moves.items.insert() = axis.move;
+  axis.moves.total_moves++;
+}
+
+// Track moves. Called from isr on a full step transition.
+static inline void isr_track_move_step(AxisDecoder& axis, int increment,
+                                       Direction entry_direction,
+                                       Direction exit_direction,
+                                       uint32_t ticks_in_step,
+                                       uint32_t max_current_in_step) {
+  // Direction change ends the current move.
+  if (axis.move_active && exit_direction != axis.move_direction) {
+    isr_end_move(axis);
+  }
+
+  MoveRecord& move = axis.move;  // alias
+
+  if (!axis.move_active) {
+    axis.move_active = true;
+    axis.move_direction = exit_direction;
+    move.start_tick = axis.state.tick_count;
+    move.steps = 0;
+    move.total_step_peak_currents = 0;
+    move.min_ticks_in_step = 0xffff;
+    move.quadrature_errors = 0;
+  }
+
+  move.duration_ticks = axis.state.tick_count - move.start_tick;
+  move.steps += isr_data.settings.reverse_direction ? -increment : increment;
+  move.total_step_peak_currents += max_current_in_step;
+  // Only steps that were entered and exited in the move direction
+  // have a meaningful duration.
+  if (entry_direction == exit_direction &&
+      ticks_in_step < move.min_ticks_in_step) {
+    move.min_ticks_in_step = ticks_in_step;
+  }
+}
+
+// Record a stall event. Called from isr.
+static inline void isr_add_stall_event(AxisDecoder& axis, StallEventType type) {
+  // If the buffer is full this drops the oldest event.
+  StallEvent* event = axis.stall_events.items.insert();
+  event->tick = axis.state.tick_count;
+  event->full_steps = axis.state.full_steps;
+  event->type = type;
+  axis.stall_events.counts[type]++;
+}
+
+// Track the current vector magnitude for collapse while moving.
+// Called from isr on each energized sample.
+static inline void isr_track_current_collapse(AxisDecoder& axis,
+                                              uint32_t magnitude_sq) {
+  // The peak restarts with each move, so it excludes the power up
+  // transient of the filters and the currents of previous moves.
+  if (!axis.move_active) {
+    axis.peak_magnitude_sq = magnitude_sq;
+    axis.collapse_ticks = 0;
+    return;
+  }
+
+  if (magnitude_sq > axis.peak_magnitude_sq) {
+    axis.peak_magnitude_sq = magnitude_sq;
+  }
+
+  if (magnitude_sq >= (axis.peak_magnitude_sq >> kCollapseMagnitudeSqBits)) {
+    axis.collapse_ticks = 0;
+    return;
+  }
+
+  // Report once per collapse.
+  if (++axis.collapse_ticks == kCollapseTicks) {
+    isr_add_stall_event(axis, STALL_CURRENT_COLLAPSE);
+  }
+}
+
+// Start tracking the magnitude range and ripple of a new step. Called
+// from isr.
+static inline void isr_start_step_magnitude(AxisDecoder& axis,
+                                            uint32_t magnitude_sq) {
+  axis.step_min_magnitude_sq = magnitude_sq;
+  axis.step_max_magnitude_sq = magnitude_sq;
+  const uint32_t x = magnitude_sq >> kRippleMagnitudeSqShift;
+  axis.step_ripple_sum = x;
+  axis.step_ripple_sum_sq = (uint64_t)x * x;
+}
+
+// Add a sample to the ripple tracking of the current step. Called
+// from isr on each sample, so just accumulates.
+static inline void isr_track_step_ripple(AxisDecoder& axis,
+                                         uint32_t magnitude_sq) {
+  const uint32_t x = magnitude_sq >> kRippleMagnitudeSqShift;
+  axis.step_ripple_sum += x;
+  axis.step_ripple_sum_sq += (uint64_t)x * x;
+}
+
+// Check the magnitude range of a completed step. Only steps that
+// were entered and exited in the same direction are checked. Called
+// from isr.
+static inline void isr_check_step_distortion(AxisDecoder& axis,
+                                             Direction entry_direction,
+                                             Direction exit_direction) {
+  if (entry_direction != exit_direction) {
+    return;
+  }
+  if (axis.step_min_magnitude_sq <
+      (axis.step_max_magnitude_sq >> kDistortionMagnitudeSqBits)) {
+    isr_add_stall_event(axis, STALL_DISTORTED_STEP);
+  }
+}
+
+// Check for a quadrant jump that the signal filters spread over two
+// steps. Called from isr on a step transition, before the new step
+// starts.
+static inline void isr_check_fast_steps(AxisDecoder& axis,
+                                        Direction exit_direction) {
+  if (axis.state.last_step_direction == exit_direction &&
+      axis.state.ticks_in_step <= kQuadrantJumpTicks) {
+    isr_add_stall_event(axis, STALL_QUADRANT_JUMP);
+  }
+}
+
+// Check for a quadrant jump that the signal filters passed as a short
+// loss of the energized state. Called from isr when becoming energized.
+static inline void isr_check_move_cut(AxisDecoder& axis) {
+  if (axis.move_cut &&
+      (uint32_t)axis.state.tick_count - axis.move_cut_tick <=
+          kQuadrantJumpTicks) {
+    isr_add_stall_event(axis, STALL_QUADRANT_JUMP);
+  }
+  axis.move_cut = false;
 }
 
 // A helper for the isr function.
-static inline void isr_update_full_steps_counter(int increment) {
-  State& isr_state = isr_data.state;  // alias
+static inline void isr_update_full_steps_counter(AxisDecoder& axis,
+                                                 int increment) {
+  State& isr_state = axis.state;  // alias
 
   // Update step counter based on direction setting.
   if (isr_data.settings.reverse_direction) {
@@ -265,122 +947,201 @@ static inline void isr_update_full_steps_counter(int increment) {
   } else {
     isr_state.full_steps += increment;
   }
+  isr_state.total_full_steps++;
 
   // Track retraction.
   if (isr_state.full_steps > isr_state.max_full_steps) {
     isr_state.max_full_steps = isr_state.full_steps;
   }
-  const int retraction_steps = isr_state.max_full_steps - isr_state.full_steps;
+  const int64_t retraction_steps =
+      isr_state.max_full_steps - isr_state.full_steps;
   if (retraction_steps > isr_state.max_retraction_steps) {
     isr_state.max_retraction_steps = retraction_steps;
   }
 }
 
-// NOTE: these four filters slow the interrupt handling. Consider
-// to eliminate if free CPU time is insufficient.
-//
-// We use these filters to reduce internal and external noise.
-static filters::Adc12BitsLowPassFilter<700> signal1_filter;
-static filters::Adc12BitsLowPassFilter<400> signal2_filter;
-
 // Slow filter, for display purposes.
 // static filters::Adc12BitsLowPassFilter<1023> display1_filter;
 // static filters::Adc12BitsLowPassFilter<1023> display2_filter;
 
+// Add an item to the roll buffer, or to the capture buffer and
+// advance the capture state. Called from isr while capturing.
+static inline void isr_capture_item(int16_t v1, int16_t v2) {
+  if (isr_data.roll_enabled) {
+    // If the buffer is full it drops the oldest item.
+    CaptureItem* roll_item = isr_data.roll_items.insert();
+    roll_item->v1 = v1;
+    roll_item->v2 = v2;
+    return;
+  }
+
+  // Insert sample to circular buffer. If the buffer is full it drops
+  // the oldest item.
+  CaptureItem* capture_item = isr_data.capture_buffer.items.insert();
+  capture_item->v1 = v1;
+  capture_item->v2 = v2;
+
+  switch (isr_data.capture_state) {
+    // In this sate we blindly fill half of the buffer.
+    case CAPTURE_HALF_FILL:
+      if (isr_data.capture_buffer.items.size() >= kCaptureBufferSize / 2) {
+        isr_data.capture_state = CAPTURE_PRE_TRIGGER;
+      }
+      break;
+
+    // In this state we look for a trigger event or a pre trigger timeout.
+    case CAPTURE_PRE_TRIGGER: {
+      // Pre trigger timeout?
+      if (isr_data.capture_pre_trigger_items_left == 0) {
+        // NOTE: if the buffer is full here we could terminate
+        // the capture but we go through the normal motions for simplicity.
+        isr_data.capture_state = CAPTURE_POST_TRIGER;
+        isr_data.capture_buffer.trigger_found = false;
+
+        break;
+      }
+      isr_data.capture_pre_trigger_items_left--;
+      // Trigger event?
+      const int16_t old_v1 = isr_data.capture_buffer.items.get_reversed(5)->v1;
+      // Trigger criteria, up crossing of the zero line.
+      if (old_v1 < -10 && v1 >= 0) {
+        // Keep only the last n/2 points. This way the trigger will
+        // always be in the middle of the buffer.
+        isr_data.capture_buffer.items.keep_at_most(kCaptureBufferSize / 2);
+        isr_data.capture_buffer.trigger_found = true;
+        isr_data.capture_state = CAPTURE_POST_TRIGER;
+      }
+    } break;
+
+    // In this state we blindly fill the rest of the buffer.
+    case CAPTURE_POST_TRIGER:
+      if (isr_data.capture_buffer.items.is_full()) {
+        isr_data.capture_state = CAPTURE_IDLE;
+      }
+      break;
+
+    // This one is non reachable but makes the compiler happy.
+    case CAPTURE_IDLE:
+      break;
+  }
+}
+
+// True if capturing or rolling. Called from isr.
+static inline bool isr_is_capturing() {
+  return isr_data.capture_state != CAPTURE_IDLE || isr_data.roll_enabled;
+}
+
+// Add a sample of the selected axis to the capture or the roll, if
+// active. Called from isr.
+static inline void isr_capture_sample(int16_t v1, int16_t v2) {
+  if (!isr_is_capturing()) {
+    return;
+  }
+  switch (isr_data.capture_mode) {
+    case CAPTURE_MODE_AVERAGE:
+      isr_data.capture_sum1 += v1;
+      isr_data.capture_sum2 += v2;
+      break;
+    case CAPTURE_MODE_PEAK_DETECT:
+      isr_data.capture_peak1.add(v1);
+      isr_data.capture_peak2.add(v2);
+      break;
+    default:
+      break;
+  }
+  if (++isr_data.capture_interval_counter < isr_data.capture_interval) {
+    return;
+  }
+
+  switch (isr_data.capture_mode) {
+    case CAPTURE_MODE_AVERAGE:
+      // One division per item, every divider samples.
+      isr_capture_item(isr_data.capture_sum1 / isr_data.capture_interval,
+                       isr_data.capture_sum2 / isr_data.capture_interval);
+      break;
+    case CAPTURE_MODE_PEAK_DETECT:
+      isr_capture_item(isr_data.capture_peak1.first(),
+                       isr_data.capture_peak2.first());
+      // The first item may have completed the capture.
+      if (isr_is_capturing()) {
+        isr_capture_item(isr_data.capture_peak1.last(),
+                         isr_data.capture_peak2.last());
+      }
+      break;
+    default:
+      isr_capture_item(v1, v2);
+      break;
+  }
+  isr_reset_capture_interval();
+}
+
 // This function performs the bulk of the IRQ processing. It accepts
-// one pair of ADC1, ADC2 readings, analyzes it, and updates the
-// state.
-void isr_handle_one_sample(const uint16_t raw_v1, const uint16_t raw_v2) {
-  isr_data.state.tick_count++;
+// one pair of ADC readings of an axis, with kScaledSampleFractionBits
+// fraction bits, analyzes it, and updates the state of the axis.
+void isr_handle_one_sample(AxisDecoder& axis, const AxisOffsets& offsets,
+                           const uint16_t scaled_v1,
+                           const uint16_t scaled_v2) {
+  axis.state.tick_count++;
+
+  // Periodic update of the energized thresholds.
+  if ((axis.state.tick_count &
+       ((1 << adaptive_threshold::kUpdateTicksBits) - 1)) == 0) {
+    isr_update_thresholds(axis);
+    isr_decay_peak_magnitude(axis);
+  }
 
-  // Fast filtering for signal analysis.
+  // Align channel 2 to the sampling time of channel 1, with rounding.
+  const uint16_t aligned_scaled_v2 = filters::interpolate_q16(
+      axis.prev_scaled_v2, scaled_v2, kChannel2SkewQ16);
+  axis.prev_scaled_v2 = scaled_v2;
+
+  // Fast filtering for signal analysis. The filters drop the fraction
+  // bits of the scaled samples.
   const int16_t v1 =
-      (uint16_t)signal1_filter.update(raw_v1) - isr_data.settings.offset1;
+      (uint16_t)axis.signal1_filter.update_14_bits(scaled_v1) -
+      offsets.offset1;
   const int16_t v2 =
-      (uint16_t)signal2_filter.update(raw_v2) - isr_data.settings.offset2;
+      (uint16_t)axis.signal2_filter.update_14_bits(aligned_scaled_v2) -
+      offsets.offset2;
 
   // Slower filtering for display purposes.
-  isr_data.state.v1 = v1;
-  //   (uint16_t)display1_filter.update(raw_v1) - isr_data.settings.offset1;
-  isr_data.state.v2 = v2;
-  // (uint16_t)display2_filter.update(raw_v2) - isr_data.settings.offset2;
+  axis.state.v1 = v1;
+  //   (uint16_t)display1_filter.update(scaled_v1) - offsets.offset1;
+  axis.state.v2 = v2;
+  // (uint16_t)display2_filter.update(scaled_v2) - offsets.offset2;
 
   // Handle signal capturing.
   // Release: 220ns, Debug: 1100ns.  (TODO: update timing for current code)
-  if (isr_data.capture_state != CAPTURE_IDLE &&
-      ++isr_data.capture_divider_counter >= isr_data.capture_divider) {
-    isr_data.capture_divider_counter = 0;
-    // Insert sample to circular buffer. If the buffer is full it drops
-    // the oldest item.
-    CaptureItem* capture_item = isr_data.capture_buffer.items.insert();
-    capture_item->v1 = v1;
-    capture_item->v2 = v2;
-
-    switch (isr_data.capture_state) {
-      // In this sate we blindly fill half of the buffer.
-      case CAPTURE_HALF_FILL:
-        if (isr_data.capture_buffer.items.size() >= kCaptureBufferSize / 2) {
-          isr_data.capture_state = CAPTURE_PRE_TRIGGER;
-        }
-        break;
-
-      // In this state we look for a trigger event or a pre trigger timeout.
-      case CAPTURE_PRE_TRIGGER: {
-        // Pre trigger timeout?
-        if (isr_data.capture_pre_trigger_items_left == 0) {
-          // NOTE: if the buffer is full here we could terminate
-          // the capture but we go through the normal motions for simplicity.
-          isr_data.capture_state = CAPTURE_POST_TRIGER;
-          isr_data.capture_buffer.trigger_found = false;
-
-          break;
-        }
-        isr_data.capture_pre_trigger_items_left--;
-        // Trigger event?
-        const int16_t old_v1 =
-            isr_data.capture_buffer.items.get_reversed(5)->v1;
-        // Trigger criteria, up crossing of the zero line.
-        if (old_v1 < -10 && v1 >= 0) {
-          // Keep only the last n/2 points. This way the trigger will
-          // always be in the middle of the buffer.
-          isr_data.capture_buffer.items.keep_at_most(kCaptureBufferSize / 2);
-          isr_data.capture_buffer.trigger_found = true;
-          isr_data.capture_state = CAPTURE_POST_TRIGER;
-        }
-      } break;
-
-      // In this state we blindly fill the rest of the buffer.
-      case CAPTURE_POST_TRIGER:
-        if (isr_data.capture_buffer.items.is_full()) {
-          isr_data.capture_state = CAPTURE_IDLE;
-        }
-        break;
-
-      // This one is non reachable but makes the compiler happy.
-      case CAPTURE_IDLE:
-        break;
-    }
+  if (&axis == &selected_axis_decoder()) {
+    isr_capture_sample(v1, v2);
   }
 
   // Determine if motor is energized. Use hysteresis for noise rejection.
   // Release: 200ns. Debug: 600ns.
-  const bool old_is_energized = isr_data.state.is_energized;
+  const bool old_is_energized = axis.state.is_energized;
   const uint16_t total_current = abs(v1) + abs(v2);
   // Using histeresis.
-  const uint16_t energized_threshold = old_is_energized
-                                           ? kNonEnergizedThresholdCounts
-                                           : kEnergizedThresholdCounts;
-  const bool new_is_energized = total_current > energized_threshold;
-  isr_data.state.is_energized = new_is_energized;
+  const bool new_is_energized = adaptive_threshold::is_energized(
+      old_is_energized, total_current, axis.state.energized_threshold,
+      axis.state.non_energized_threshold);
+  axis.state.is_energized = new_is_energized;
+
+  // Track the noise floor for the adaptive thresholds.
+  axis.adaptive_threshold.track_total_current(
+      total_current, axis.state.non_energized_threshold);
 
   // Handle the non energized case. No need to go through quadrant decoding.
   // Pass through case: Release: 110ns. Debug: 250ns.
   if (!new_is_energized) {
     if (old_is_energized) {
       // Becoming non energized.
-      isr_data.state.last_step_direction = UNKNOWN_DIRECTION;
-      isr_data.state.ticks_in_step = 0;
-      isr_data.state.non_energized_count++;
+      axis.state.last_step_direction = UNKNOWN_DIRECTION;
+      axis.state.ticks_in_step = 0;
+      axis.state.non_energized_count++;
+      isr_push_step_interval(axis, kStepIntervalBreak);
+      axis.move_cut = axis.move_active;
+      axis.move_cut_tick = axis.state.tick_count;
+      isr_end_move(axis);
     } else {
       // Staying non energized
     }
@@ -439,56 +1200,126 @@ void isr_handle_one_sample(const uint16_t raw_v1, const uint16_t raw_v2) {
     }
   }
 
-  const int8_t old_quadrant = isr_data.state.quadrant;  // old quadrant [0, 3]
-  isr_data.state.quadrant = new_quadrant;
+  // Track the peak current for the adaptive thresholds.
+  axis.adaptive_threshold.track_max_current(max_current);
+
+  // Stall detection by the current vector magnitude.
+  const uint32_t magnitude_sq = (int32_t)v1 * v1 + (int32_t)v2 * v2;
+  isr_track_current_collapse(axis, magnitude_sq);
+
+  const int8_t old_quadrant = axis.state.quadrant;  // old quadrant [0, 3]
+  axis.state.quadrant = new_quadrant;
 
   // Track quadrant transitions and update steps.
   if (!old_is_energized) {
     // Case 1: motor just became energized. Direction is still not known.
-    isr_data.state.last_step_direction = UNKNOWN_DIRECTION;
-    isr_data.state.ticks_in_step = 1;
-    isr_data.state.max_current_in_step = max_current;
+    axis.state.last_step_direction = UNKNOWN_DIRECTION;
+    axis.state.ticks_in_step = 1;
+    axis.state.max_current_in_step = max_current;
+    isr_start_step_magnitude(axis, magnitude_sq);
+    isr_check_move_cut(axis);
   } else if (new_quadrant == old_quadrant) {
     // Case 2: staying in same quadrant
-    isr_data.state.ticks_in_step++;
-    if (max_current > isr_data.state.max_current_in_step) {
-      isr_data.state.max_current_in_step = max_current;
+    axis.state.ticks_in_step++;
+    if (axis.state.ticks_in_step == kMoveDwellTicks) {
+      isr_end_move(axis);
+    }
+    if (max_current > axis.state.max_current_in_step) {
+      axis.state.max_current_in_step = max_current;
     }
+    if (magnitude_sq < axis.step_min_magnitude_sq) {
+      axis.step_min_magnitude_sq = magnitude_sq;
+    } else if (magnitude_sq > axis.step_max_magnitude_sq) {
+      axis.step_max_magnitude_sq = magnitude_sq;
+    }
+    isr_track_step_ripple(axis, magnitude_sq);
   } else if (new_quadrant == ((old_quadrant + 1) & 0x03)) {
     // Case 3: Moved to next quadrant.
-    isr_update_full_steps_counter(+1);
-    isr_add_step_to_histogram(old_quadrant, isr_data.state.last_step_direction,
-                              FORWARD, isr_data.state.ticks_in_step,
-                              isr_data.state.max_current_in_step);
-    isr_data.state.last_step_direction = FORWARD;
-    isr_data.state.ticks_in_step = 1;
-    isr_data.state.max_current_in_step = max_current;
+    isr_update_full_steps_counter(axis, +1);
+    isr_add_step_to_histogram(axis, old_quadrant,
+                              axis.state.last_step_direction, FORWARD,
+                              axis.state.ticks_in_step,
+                              axis.state.max_current_in_step);
+    isr_add_step_interval(axis, axis.state.last_step_direction, FORWARD,
+                          axis.state.ticks_in_step);
+    isr_track_move_step(axis, +1, axis.state.last_step_direction, FORWARD,
+                        axis.state.ticks_in_step,
+                        axis.state.max_current_in_step);
+    isr_check_step_distortion(axis, axis.state.last_step_direction, FORWARD);
+    isr_check_fast_steps(axis, FORWARD);
+    axis.state.last_step_direction = FORWARD;
+    axis.state.ticks_in_step = 1;
+    axis.state.max_current_in_step = max_current;
+    isr_start_step_magnitude(axis, magnitude_sq);
   } else if (new_quadrant == ((old_quadrant - 1) & 0x03)) {
     // Case 4: Moved to previous quadrant.
-    isr_update_full_steps_counter(-1);
-    isr_add_step_to_histogram(old_quadrant, isr_data.state.last_step_direction,
-                              BACKWARD, isr_data.state.ticks_in_step,
-                              isr_data.state.max_current_in_step);
-    isr_data.state.last_step_direction = BACKWARD;
-    isr_data.state.ticks_in_step = 1;
-    isr_data.state.max_current_in_step = max_current;
+    isr_update_full_steps_counter(axis, -1);
+    isr_add_step_to_histogram(axis, old_quadrant,
+                              axis.state.last_step_direction, BACKWARD,
+                              axis.state.ticks_in_step,
+                              axis.state.max_current_in_step);
+    isr_add_step_interval(axis, axis.state.last_step_direction, BACKWARD,
+                          axis.state.ticks_in_step);
+    isr_track_move_step(axis, -1, axis.state.last_step_direction, BACKWARD,
+                        axis.state.ticks_in_step,
+                        axis.state.max_current_in_step);
+    isr_check_step_distortion(axis, axis.state.last_step_direction, BACKWARD);
+    isr_check_fast_steps(axis, BACKWARD);
+    axis.state.last_step_direction = BACKWARD;
+    axis.state.ticks_in_step = 1;
+    axis.state.max_current_in_step = max_current;
+    isr_start_step_magnitude(axis, magnitude_sq);
   } else {
     // Case 5: Invalid quadrant transition.
     // TODO: count and report errors.
-    isr_data.state.quadrature_errors++;
-    isr_data.state.last_step_direction = UNKNOWN_DIRECTION;
-    isr_data.state.ticks_in_step = 1;
-    isr_data.state.max_current_in_step = max_current;
+    axis.state.quadrature_errors++;
+    isr_push_step_interval(axis, kStepIntervalBreak);
+    if (axis.move_active) {
+      axis.move.quadrature_errors++;
+    }
+    isr_add_stall_event(axis, STALL_QUADRANT_JUMP);
+    axis.state.last_step_direction = UNKNOWN_DIRECTION;
+    axis.state.ticks_in_step = 1;
+    axis.state.max_current_in_step = max_current;
+    isr_start_step_magnitude(axis, magnitude_sq);
   }
 }
 
 // Handle the first or second ADC/DMA buffer with collected
-// samples.
+// samples. Each point has a pair of samples per axis. The LED2 pulse
+// width is the time it takes to decode a tick of all the axes.
 void isr_handle_dma_buffer(const dma::AdcPoint* bfr, int n) {
+  // Oversampling mode. Each tick decodes the sums of a group of
+  // points.
+  if (isr_data.settings.oversampling) {
+    for (int i = 0; i < n; i += kOversamplingFactor) {
+      LED2_ON;
+      for (int a = 0; a < config::kNumAxes; a++) {
+        uint16_t sum1 = 0;
+        uint16_t sum2 = 0;
+        for (int j = i; j < i + kOversamplingFactor; j++) {
+          const dma::AxisSamples& samples = bfr[j].axes[a];
+          sum1 += samples.v1;
+          sum2 += samples.v2;
+        }
+        isr_handle_one_sample(isr_data.axes[a], isr_data.settings.offsets[a],
+                              sum1, sum2);
+      }
+      LED2_OFF;
+    }
+    return;
+  }
+
+  // Normal mode. Each tick decodes a single point.
   for (int i = 0; i < n; i++) {
     LED2_ON;
     const dma::AdcPoint& adc_point = bfr[i];
-    isr_handle_one_sample(adc_point.v1, adc_point.v2);
+    for (int a = 0; a < config::kNumAxes; a++) {
+      const dma::AxisSamples& samples = adc_point.axes[a];
+      isr_handle_one_sample(isr_data.axes[a], isr_data.settings.offsets[a],
+                            samples.v1 << kScaledSampleFractionBits,
+                            samples.v2 << kScaledSampleFractionBits);
+    }
     LED2_OFF;
   }
 }
@@ -513,8 +1344,17 @@ static int clip_offset(int requested_offset) {
 // Call once on program initialization.
 void setup(const Settings& settings) {
   isr_data.settings = settings;
-  isr_data.settings.offset1 = clip_offset(isr_data.settings.offset1);
-  isr_data.settings.offset2 = clip_offset(isr_data.settings.offset2);
+  for (int i = 0; i < config::kNumAxes; i++) {
+    AxisOffsets& offsets = isr_data.settings.offsets[i];  // alias
+    offsets.offset1 = clip_offset(offsets.offset1);
+    offsets.offset2 = clip_offset(offsets.offset2);
+    isr_data.axes[i].state.histogram_scale = isr_data.settings.histogram_scale;
+    isr_update_thresholds(isr_data.axes[i]);
+  }
+  isr_data.settings.oversampling =
+      isr_data.settings.oversampling && kOversamplingSupported;
+  tim::set_trigger_rate_factor(
+      isr_data.settings.oversampling ? kOversamplingFactor : 1);
 }
 
 // This involves floating point operations and thus slow. Do not
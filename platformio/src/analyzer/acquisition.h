@@ -7,27 +7,52 @@
 #include <Arduino.h>
 #include <stdio.h>
 #include <string.h>
+#include "analyzer/histogram.h"
+#include "config.h"
 #include "misc/circular_buffer.h"
 
 namespace acquisition {
 
-// This is set in the Settings page.
-struct Settings {
-  // Offsets to substract from the ADC readings to have zero reading
-  // when the current is zero.
-  // Typically around ~1900 which represents ~1.5V from the current
-  // sensors.
+// Offsets to substract from the ADC readings of an axis to have zero
+// reading when the current is zero.
+// Typically around ~1900 which represents ~1.5V from the current
+// sensors.
+struct AxisOffsets {
   int16_t offset1;
   int16_t offset2;
+};
+
+// This is set in the Settings page.
+struct Settings {
+  // Per axis zero current offsets.
+  AxisOffsets offsets[config::kNumAxes];
   // If true, reverse interpretation of forward/backward movement.
   bool reverse_direction;
+  // If true, the energized/non-energized thresholds are derived from
+  // the measured peak coil current and noise floor instead of the
+  // fixed defaults.
+  bool adaptive_threshold;
+  // If true, the ADC samples at kOversamplingFactor times the tick
+  // rate and the samples of each tick are averaged. Ignored if
+  // kOversamplingSupported is false.
+  bool oversampling;
+  // Layout of the step speed histogram buckets.
+  histogram::Scale histogram_scale;
 };
 
 // Number of pairs of ADC readings to capture for the signal 
-// capture page. The capture logic try to sync a ch1 up crossing
+// capture pages. The capture logic try to sync a ch1 up crossing
 // the horizontal axis at the middle of the buffer for better
-// visual stability. 
-constexpr int kCaptureBufferSize = 200;
+// visual stability. The size is a power of 2 to allow spectrum
+// analysis and deep enough for the oscilloscope zoom.
+constexpr int kCaptureBufferSize = 1024;
+
+// Number of capture items displayed by the time domain capture
+// pages, centered around the middle of the capture buffer where the
+// trigger point is.
+constexpr int kCaptureDisplaySize = 200;
+constexpr int kCaptureDisplayStart =
+    (kCaptureBufferSize - kCaptureDisplaySize) / 2;
 
 // A single captured item. These are the signed values
 // in adc counts of the two curent sensing channels.
@@ -36,6 +61,24 @@ struct CaptureItem {
   int16_t v2;
 };
 
+// How a capture item represents the divider ADC samples it spans.
+// See start_capture().
+enum CaptureMode {
+  // The last sample of each interval. The other samples are dropped.
+  CAPTURE_MODE_SAMPLE,
+  // The average of the samples of each interval, a boxcar low pass
+  // filter. Used as the anti alias filter of the narrow spectrum span.
+  CAPTURE_MODE_AVERAGE,
+  // The min and max of each channel over each pair of intervals,
+  // as two consecutive items, in the order they occurred. Keeps short
+  // spikes visible at slow timebases, without increasing the item
+  // size.
+  CAPTURE_MODE_PEAK_DETECT,
+};
+
+// Max capture divider. Each capture item then spans 20ms.
+constexpr uint16_t kMaxCaptureDivider = 2000;
+
 // A circular array with captured signals. Using a circular array
 // allow to capture data before the trigger point.
 typedef CircularBuffer<CaptureItem, kCaptureBufferSize> CaptureItems;
@@ -47,7 +90,87 @@ struct CaptureBuffer {
   // is always at a fixed index at the middle of the returned
   // captured range.
   bool trigger_found;
+  // The divider and mode this buffer was captured with. See
+  // start_capture().
+  uint16_t divider;
+  CaptureMode mode;
+};
+
+// Max number of capture items buffered in the roll mode. See
+// consume_roll_items().
+constexpr uint16_t kRollBufferSize = 64;
+
+// Max number of step intervals buffered for background analysis.
+// See consume_step_intervals().
+constexpr uint16_t kStepIntervalsBufferSize = 512;
+
+// A step intervals value that marks a discontinuity in the
+// motion, e.g. a direction change, de-energized coils, quadrature
+// error or buffer overflow.
+constexpr uint16_t kStepIntervalBreak = 0;
+
+// A summary of a single move. A move starts with a full step
+// transition and ends on direction change, dwell, or de-energized coils.
+struct MoveRecord {
+  // The tick_count of the first step transition.
+  uint64_t start_tick;
+  // Ticks from the first to the last step transitions.
+  uint32_t duration_ticks;
+  // Signed distance in full steps.
+  int32_t steps;
+  // Sum of the max current of the steps, in ADC counts. Used to
+  // compute the average peak current.
+  uint32_t total_step_peak_currents;
+  // Duration of the shortest full step, in ticks. This is a proxy for
+  // the peak speed. 0xffff if the move had no complete steps.
+  uint16_t min_ticks_in_step;
+  // Quadrature errors during the move.
+  uint16_t quadrature_errors;
+};
+
+// Number of most recent moves to keep.
+constexpr int kNumMoveRecords = 16;
+
+struct MoveRecords {
+  // Most recent completed moves. Older moves are dropped.
+  CircularBuffer<MoveRecord, kNumMoveRecords> items;
+  // Total moves since last reset, including dropped moves.
+  uint32_t total_moves;
+};
 
+// Types of probable stall or missed step events.
+enum StallEventType : uint8_t {
+  // An invalid quadrant transition. Since there are four quadrants,
+  // this is a jump of two quadrants which can't be classified as
+  // forward or backward. Also two steps in the same direction within
+  // 40us, which is how the signal filters pass most of the jumps.
+  STALL_QUADRANT_JUMP,
+  // The current vector magnitude dropped to less than half of its
+  // peak in the move, for at least 2ms.
+  STALL_CURRENT_COLLAPSE,
+  // The current vector magnitude varied by more than 2:1 within a
+  // single full step, typically due to a high back-EMF.
+  STALL_DISTORTED_STEP,
+  NUM_STALL_EVENT_TYPES,
+};
+
+struct StallEvent {
+  // The tick_count when the event was detected.
+  uint64_t tick;
+  // The full_steps value when the event was detected.
+  int64_t full_steps;
+  StallEventType type;
+};
+
+// Number of most recent stall events to keep.
+constexpr int kNumStallEvents = 16;
+
+struct StallEvents {
+  // Most recent events. Older events are dropped.
+  CircularBuffer<StallEvent, kNumStallEvents> items;
+  // Total events since last reset, by type, including
+  // dropped events.
+  uint32_t counts[NUM_STALL_EVENT_TYPES];
 };
 
 // Step direction classification. The analyzer classifies
@@ -57,24 +180,43 @@ enum Direction { UNKNOWN_DIRECTION, FORWARD, BACKWARD };
 
 // Sampling rate is 100K samplings/sec. Should match TIM1 settings
 // in ../hal/tim.cc. Each sample captures a pair of values, one from
-// each channel.
+// each channel, of each axis.
 constexpr int kUsecsPerTick = 10;
 constexpr int TicksPerSecond = 1000000 / kUsecsPerTick;
+static_assert(TicksPerSecond == histogram::kTicksPerSecond,
+              "Inconsistent sampling rate");
+
+// In the oversampling mode, the ADC is triggered this number of times
+// per tick and the decoder processes the average of each group of
+// samples. This reduces the ADC noise while keeping the tick rate. The
+// ADC scan of an axis takes ~1.4us so the 2.5us trigger period allows
+// only a single axis.
+constexpr int kOversamplingFactor = 4;
+constexpr bool kOversamplingSupported = config::kNumAxes == 1;
 
 // Max range when using ACS70331EESATR-2P5B3 (+/- 2.5A).
 // Double this if using the +/-5A current sensor variant.
 constexpr int kMaxMilliamps = 2500;
 
-// Number of histogram buckets, each bucket represents
-// a band of step speeds.
-constexpr int kNumHistogramBuckets = 20;
+// Max number of histogram buckets, each bucket represents
+// a band of step speeds. The number of buckets actually in use
+// depends on the histogram scale. See histogram.h.
+constexpr int kNumHistogramBuckets = histogram::kMaxNumBuckets;
+
+// Percentiles of the step peak current that are tracked per
+// histogram bucket.
+enum PeakPercentile : uint8_t {
+  PEAK_P5,
+  PEAK_P50,
+  PEAK_P95,
+  NUM_PEAK_PERCENTILES
+};
 
-// Each histogram bucket represents a speed range of 100
-// steps/sec, starting from zero. Overflow speeds are
-// aggregated in the last bucket.
-const int kBucketStepsPerSecond = 100;
+// Number of fraction bits of the percentile estimates.
+constexpr int kPeakPercentileFractionBits = 4;
 
-// A single histogram bucket
+// A single histogram bucket. Each axis has kNumHistogramBuckets of
+// these, so the fields are ordered by size to avoid padding.
 struct HistogramBucket {
   // Total adc samples in steps in this bucket. This is a proxy
   // for time spent in this speed range.
@@ -82,35 +224,56 @@ struct HistogramBucket {
   // Total max step current in ADC counts. Used 
   // to compute the average max coil curent by speed range. 
   uint64_t total_step_peak_currents;  
+  // Sum and sum of squares of the current vector magnitude squared
+  // (v1^2 + v2^2, scaled down) over the total_ticks_in_steps samples
+  // of the steps in this bucket. See bucket_ripple_percent().
+  uint64_t total_ripple_sum;
+  uint64_t total_ripple_sum_sq;
    // Total steps. This is a proxy for the distance (in either direction)
    // done in this speed range.
   uint32_t total_steps;              
+  // Min and max step peak current in ADC counts. Valid if
+  // total_steps > 0.
+  uint16_t min_step_peak_current;
+  uint16_t max_step_peak_current;
+  // Streaming estimates of percentiles of the step peak current, in
+  // ADC counts << kPeakPercentileFractionBits. Valid if
+  // total_steps > 0. See bucket_peak_current_percentile().
+  uint16_t step_peak_current_percentiles[NUM_PEAK_PERCENTILES];
 };
 
+static_assert(sizeof(HistogramBucket) == 48, "Unexpected bucket padding");
+
 // Analyzer data, other than the capture buffer, this is the only
 // data that the interrupt routine updates.
 struct State {
  public:
   State()
       : tick_count(0),
+        reset_tick_count(0),
         v1(0),
         v2(0),
         is_energized(false),
         non_energized_count(0),
         quadrant(0),
         full_steps(0),
+        total_full_steps(0),
         max_full_steps(0),
         max_retraction_steps(0),
         quadrature_errors(0),
         last_step_direction(UNKNOWN_DIRECTION),
         max_current_in_step(0),
-        ticks_in_step(0) {
-    memset(buckets, 0, sizeof(buckets));
-  }
-
-  // Number of ADC pair samples since last data reset. This is
-  // also a proxy for the time passed.
-  uint32_t tick_count;
+        ticks_in_step(0),
+        energized_threshold(0),
+        non_energized_threshold(0),
+        histogram_scale(histogram::SCALE_LINEAR) {}
+
+  // Number of ADC pair samples since program start. This is
+  // also a proxy for the time passed. Monotonic, 64 bits so it never
+  // wraps around, and not cleared by reset_state().
+  uint64_t tick_count;
+  // The tick_count at the last data reset. See job_ticks().
+  uint64_t reset_tick_count;
   // Signed current values in ADC count units.  When the stepper 
   // is energized, these values together with the quadrant value 
   // below can be used to compute the fractional step value.
@@ -126,13 +289,17 @@ struct State {
   int8_t quadrant;
   // Total (forward - backward) full steps. This is a proxy
   // for the overall distance.
-  int full_steps;
+  int64_t full_steps;
+  // Total full steps in either direction. Unlike full_steps, back
+  // and forth steps don't cancel out, so this is a proxy for the
+  // wear.
+  uint64_t total_full_steps;
   // Max value of full_steps so far. Momentary retraction value
   // can computed as max(0, max_full_steps - full_steps).
-  int max_full_steps;
+  int64_t max_full_steps;
   // Max value of (max_full_steps - full_steps). As of Jan 2021,
   // this value is computed but not used.
-  int max_retraction_steps;
+  int64_t max_retraction_steps;
   // Total invalid quadrant transitions. Typically indicate
   // distorted stepper coils current patterns.
   uint32_t quadrature_errors;
@@ -144,8 +311,14 @@ struct State {
   // Time in current state, in 100Khz ADC sample time unit. This is 
   // a proxy for the time in current step.
   uint32_t ticks_in_step;
-  // Histogram, each bucket represents a range of steps/sec speeds.
-  HistogramBucket buckets[kNumHistogramBuckets];
+  // The current energized/non-energized hysteresis thresholds in ADC
+  // counts of |v1| + |v2|. Fixed unless adaptive_threshold is set.
+  uint16_t energized_threshold;
+  uint16_t non_energized_threshold;
+  // Layout of the histogram buckets. Only the first
+  // histogram::num_buckets(histogram_scale) buckets are used. The
+  // buckets are not part of the state, see sample_histogram_bucket().
+  histogram::Scale histogram_scale;
 };
 
 // Helpers for dumping aquisition sate. For debugging.
@@ -155,6 +328,16 @@ extern void dump_capture(const CaptureBuffer& capture_buffer);
 // Called once during program initialization.
 extern void setup(const Settings& settings);
 
+// Select the axis whose data is returned by the sample_*(),
+// consume_step_intervals() and reset_tick_count() functions and that
+// is captured by start_capture(). All the axes are decoded regardless
+// of the selection. A capture in progress is restarted if the selection
+// changes. Out of range values select axis 0.
+extern void select_axis(uint8_t axis_index);
+
+// Return the selected axis, in the range [0, config::kNumAxes).
+extern uint8_t selected_axis();
+
 // Is the capture buffer full with data?
 extern bool is_capture_ready();
 
@@ -163,19 +346,98 @@ extern bool is_capture_ready();
 extern const CaptureBuffer* capture_buffer();
 
 // Start signal capturing. Data is ready when
-// is_capture_ready() is true. If divider > 1,
-// only one every n ADC samples is captured.
-extern void start_capture(uint16_t divider);
+// is_capture_ready() is true. If divider > 1, each
+// capture item spans n ADC samples and mode determines how
+// they are reduced to a single item. The divider is clamped
+// to [1, kMaxCaptureDivider].
+extern void start_capture(uint16_t divider,
+                          CaptureMode mode = CAPTURE_MODE_SAMPLE);
+
+// Start streaming capture items, as with start_capture(), to a small
+// buffer that is read with consume_roll_items(). There is no trigger.
+// Stops a capture in progress and clears the capture buffer. Rolling
+// stops when start_capture() is called.
+extern void start_roll(uint16_t divider, CaptureMode mode);
+
+extern bool is_rolling();
+
+// True if no axis is energized and no capture or roll is in progress,
+// so a CPU stall, e.g. of a flash erase, loses no meaningful data.
+extern bool is_idle();
+
+// Move up to max_count of the oldest roll items to bfr and return the
+// number of items moved. If not consumed in time, the oldest items are
+// dropped.
+extern uint16_t consume_roll_items(CaptureItem* bfr, uint16_t max_count);
 
 // Sample the current state to an internal buffer and return 
 // a const ptr to it. Values are stable until next time
 // this method is called.
 extern const State* sample_state();
 
-// Clears state data. This resets counters, min/max values, 
-// histograms, etc.
+// Copy a histogram bucket of the selected axis to *bucket. Each
+// bucket represents a range of steps/sec speeds, per the
+// histogram_scale of the state. The buckets are sampled one at a time
+// rather than with sample_state(), so there is no second copy of the
+// whole histogram and the interrupts are disabled only briefly.
+extern void sample_histogram_bucket(int index, HistogramBucket* bucket);
+
+// Returns the current full_steps of the state. Cheaper than
+// sample_state() and can be called at high rate.
+extern int64_t sample_full_steps();
+
+// Move up to max_count of the oldest buffered step intervals to bfr
+// and return the number of values moved. Each value is either the
+// duration in ticks of a step that was entered and exited in the
+// same direction, or kStepIntervalBreak. Should be called
+// frequently enough to avoid buffer overflow.
+extern uint16_t consume_step_intervals(uint16_t* bfr, uint16_t max_count);
+
+// Sample the recent moves to an internal buffer and return a const
+// ptr to it. Values are stable until next time this method is called.
+extern const MoveRecords* sample_moves();
+
+// Sample the recent stall events to an internal buffer and return a
+// const ptr to it. Values are stable until next time this method is
+// called.
+extern const StallEvents* sample_stall_events();
+
+// Clears state data of all axes. This resets counters, min/max values, 
+// histograms, etc. The tick_count is not cleared, instead its
+// current value is recorded in reset_tick_count.
 extern void reset_state();
 
+// Return the tick_count of the last data reset. Cheaper than
+// sample_state() for users of the moves and stall events that
+// need the time since the data reset.
+extern uint64_t reset_tick_count();
+
+// Return the ticks since the last data reset of the given state.
+inline uint64_t job_ticks(const State& state) {
+  return state.tick_count - state.reset_tick_count;
+}
+
+// Convert ticks to milliseconds.
+inline uint64_t ticks_to_millis(uint64_t ticks) {
+  return ticks / (TicksPerSecond / 1000);
+}
+
+// Return the peak speed of a move, in steps/sec, or zero if not
+// available.
+extern uint32_t move_peak_steps_per_sec(const MoveRecord& move);
+
+// Return the ripple of the current vector magnitude in the steps of a
+// histogram bucket, as a percentage of the magnitude. This is the
+// standard deviation of the magnitude over all the samples of the
+// steps, over its mean, so it includes the step to step variation.
+// Returns zero if not available.
+extern float bucket_ripple_percent(const HistogramBucket& bucket);
+
+// Return the estimated percentile of the step peak current of a
+// histogram bucket, in ADC counts. Returns zero if not available.
+extern int bucket_peak_current_percentile(const HistogramBucket& bucket,
+                                          PeakPercentile percentile);
+
 // Return the steps value of the given state.
 extern double state_steps(const State& state);
 
@@ -186,13 +448,26 @@ extern int adc_value_to_milliamps(int adc_value);
 extern float adc_value_to_amps(int adc_value);
 
 // Call this when the coil current is known to be zero to
-// calibrate the internal offset1 and offset2. 
+// calibrate the internal offset1 and offset2 of all axes. 
 extern void calibrate_zeros();
 
 // Set direction. This updates the current settings.
 // Controlled by the user in the Settings screen.
 extern void set_direction(bool reverse_direction);
 
+// Enable/disable adaptive energized thresholds. This updates the
+// current settings. Controlled by the user in the Settings screen.
+extern void set_adaptive_threshold(bool adaptive_threshold);
+
+// Enable/disable the oversampling mode. This updates the current
+// settings. Controlled by the user in the Settings screen.
+extern void set_oversampling(bool oversampling);
+
+// Set the histogram buckets layout. This updates the current settings
+// and clears the histogram. Controlled by the user in the Settings
+// screen.
+extern void set_histogram_scale(histogram::Scale histogram_scale);
+
 // Return a copy of the internal settings. Used after 
 // calibrate_zeros() to save the current settings in the 
 // EEPROM.
@@ -0,0 +1,101 @@
+// Adaptive energized/non energized thresholds of an axis. Used by the
+// acquisition interrupt routine and thus optimized for speed. Has no
+// hardware dependencies.
+//
+// The energized threshold is half of the running peak coil current
+// and the non energized threshold is half of that. Both are kept above
+// the measured noise floor.
+//
+// Since |v1| + |v2| is never below the peak coil current when
+// energized, this also tolerates drivers that reduce the current
+// by 50% when idle.
+//
+// The noise floor is the average |v1| + |v2| of the samples that are
+// below the non energized threshold, regardless of the energized
+// state. This way, a noise or a transient that latches the energized
+// state doesn't stop the noise tracking, which would lock the
+// thresholds near the noise peaks. The noise floor starts at a value
+// that gives the fixed thresholds and adapts from there.
+
+#pragma once
+
+#include <stdint.h>
+
+namespace adaptive_threshold {
+
+// Min margin above 4x the noise floor, in ADC counts.
+constexpr uint16_t kMarginCounts = 30;
+// Thresholds are updated once every 2^n ADC ticks (~10ms).
+constexpr int kUpdateTicksBits = 10;
+// Peak current decays by 1/2^n on each update so it can follow
+// a lower driver current. Halves in about 220ms.
+constexpr int kPeakDecayBits = 5;
+// Time constant of the noise floor filter, in 2^n ticks.
+constexpr int kNoiseFloorFilterBits = 4;
+// Initial noise floor in ADC counts. Gives initial thresholds of 150
+// and 75, same as the fixed energized threshold.
+constexpr uint16_t kInitialNoiseFloorCounts = 30;
+
+// The energized state of a sample with the given |v1| + |v2|, with
+// hysteresis.
+inline bool is_energized(bool was_energized, uint16_t total_current,
+                         uint16_t energized_threshold,
+                         uint16_t non_energized_threshold) {
+  return total_current > (was_energized ? non_energized_threshold
+                                        : energized_threshold);
+}
+
+class AdaptiveThreshold {
+ public:
+  AdaptiveThreshold()
+      : peak_current_(0),
+        scaled_noise_floor_(kInitialNoiseFloorCounts
+                            << kNoiseFloorFilterBits) {}
+
+  // Track the |v1| + |v2| of a sample. Called on each sample.
+  inline void track_total_current(uint16_t total_current,
+                                  uint16_t non_energized_threshold) {
+    if (total_current <= non_energized_threshold) {
+      scaled_noise_floor_ +=
+          total_current - (scaled_noise_floor_ >> kNoiseFloorFilterBits);
+    }
+  }
+
+  // Track the max coil current of an energized sample.
+  inline void track_max_current(uint32_t max_current) {
+    if (max_current > peak_current_) {
+      peak_current_ = max_current;
+    }
+  }
+
+  // Compute the thresholds. Called once every 2^kUpdateTicksBits
+  // samples. Also decays the peak current.
+  inline void update(uint16_t* energized_threshold,
+                     uint16_t* non_energized_threshold) {
+    const uint32_t min_threshold = noise_floor() * 4 + kMarginCounts;
+    uint32_t threshold = peak_current_ >> 1;
+    if (threshold < min_threshold) {
+      threshold = min_threshold;
+    }
+    *energized_threshold = threshold;
+    *non_energized_threshold = threshold >> 1;
+
+    // Let the peak follow a lower driver current.
+    peak_current_ -= peak_current_ >> kPeakDecayBits;
+  }
+
+  // The noise floor in ADC counts.
+  inline uint32_t noise_floor() const {
+    return scaled_noise_floor_ >> kNoiseFloorFilterBits;
+  }
+
+ private:
+  // Running peak of the max coil current, in ADC counts. Decays
+  // slowly.
+  uint32_t peak_current_;
+  // Average |v1| + |v2| of the noise samples, in ADC counts <<
+  // kNoiseFloorFilterBits.
+  uint32_t scaled_noise_floor_;
+};
+
+}  // namespace adaptive_threshold
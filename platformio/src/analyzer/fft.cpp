@@ -0,0 +1,136 @@
+#include "fft.h"
+
+#include <math.h>
+
+namespace fft {
+
+// Quarter wave sine table. sine_table[i] = sin(2 * kPi * i / kMaxSize)
+// in Q15.
+static int16_t sine_table[kMaxSize / 4 + 1];
+
+// Input samples are shifted left by this number of bits to use the Q15
+// range. 12 bits signed -> 15 bits signed.
+static constexpr int kInputShift = 3;
+
+// Power of a full scale 12 bit sine in the output bins, in tenths of dB
+// per power_to_db10(). A Q15 sine of amplitude 2^14 with a Hann window
+// gain of 1/2 has a bin amplitude of 2^13 -> power of 2^26.
+static constexpr int32_t kFullScaleDb10 = 783;
+
+static constexpr double kPi = 3.14159265358979323846;
+
+void setup() {
+  for (int i = 0; i <= kMaxSize / 4; i++) {
+    sine_table[i] = (int16_t)round(32767 * sin(2 * kPi * i / kMaxSize));
+  }
+}
+
+// Returns sin(2 * kPi * i / kMaxSize) in Q15.
+static inline int16_t sin_q15(int i) {
+  i &= (kMaxSize - 1);
+  if (i <= kMaxSize / 4) {
+    return sine_table[i];
+  }
+  if (i <= kMaxSize / 2) {
+    return sine_table[kMaxSize / 2 - i];
+  }
+  if (i <= 3 * kMaxSize / 4) {
+    return -sine_table[i - kMaxSize / 2];
+  }
+  return -sine_table[kMaxSize - i];
+}
+
+// Returns cos(2 * PI * i / kMaxSize) in Q15.
+static inline int16_t cos_q15(int i) { return sin_q15(i + kMaxSize / 4); }
+
+// Approximated 10 * log10(p) in tenths of dB, using the position of
+// the most significant bit and the following 8 bits as a linear
+// fraction. Max error is about 0.3dB.
+static int32_t power_to_db10(uint64_t p) {
+  if (p == 0) {
+    return kMinDb10 + kFullScaleDb10;
+  }
+  const int msb = 63 - __builtin_clzll(p);
+  const uint32_t fraction = (uint32_t)((p << (63 - msb)) >> 55) & 0xff;
+  const int32_t log2_q8 = (msb << 8) + fraction;
+  // 10 * log10(2) / 256 = 7707 / 2^16 tenths of dB.
+  return (log2_q8 * 7707) >> 16;
+}
+
+// In place complex FFT of m points in interleaved re, im Q15 format.
+// The result is scaled by 1/m.
+static void complex_fft(int16_t* data, int m) {
+  // Bit reversal permutation.
+  for (int i = 1, j = 0; i < m; i++) {
+    int bit = m >> 1;
+    for (; j & bit; bit >>= 1) {
+      j ^= bit;
+    }
+    j ^= bit;
+    if (i < j) {
+      const int16_t re = data[2 * i];
+      const int16_t im = data[2 * i + 1];
+      data[2 * i] = data[2 * j];
+      data[2 * i + 1] = data[2 * j + 1];
+      data[2 * j] = re;
+      data[2 * j + 1] = im;
+    }
+  }
+
+  // Radix 2 decimation in time butterflies.
+  for (int len = 2; len <= m; len <<= 1) {
+    const int half = len >> 1;
+    const int twiddle_step = kMaxSize / len;
+    for (int k = 0; k < half; k++) {
+      const int32_t wr = cos_q15(k * twiddle_step);
+      const int32_t wi = -sin_q15(k * twiddle_step);
+      for (int i = k; i < m; i += len) {
+        int16_t* const a = &data[2 * i];
+        int16_t* const b = &data[2 * (i + half)];
+        const int32_t tr = (wr * b[0] - wi * b[1]) >> 15;
+        const int32_t ti = (wr * b[1] + wi * b[0]) >> 15;
+        b[0] = (a[0] - tr) >> 1;
+        b[1] = (a[1] - ti) >> 1;
+        a[0] = (a[0] + tr) >> 1;
+        a[1] = (a[1] + ti) >> 1;
+      }
+    }
+  }
+}
+
+void power_spectrum_db10(int16_t* samples, int n, int16_t* db10) {
+  // Hann window, in place.
+  const int window_step = kMaxSize / n;
+  for (int i = 0; i < n; i++) {
+    const int32_t w = (32767 - cos_q15(i * window_step)) >> 1;
+    samples[i] = ((int32_t)(samples[i] << kInputShift) * w) >> 15;
+  }
+
+  // The n real samples are processed as a complex signal of m = n/2
+  // points z[i] = x[2i] + j * x[2i + 1].
+  const int m = n >> 1;
+  complex_fft(samples, m);
+
+  // Split the even and odd parts and combine to the spectrum of the
+  // real signal. X[k] = E[k] + W^k * O[k], where W = exp(-2 * PI * j / n).
+  for (int k = 0; k < m; k++) {
+    const int32_t a = samples[2 * k];
+    const int32_t b = samples[2 * k + 1];
+    const int mk = (m - k) & (m - 1);
+    const int32_t c = samples[2 * mk];
+    const int32_t d = samples[2 * mk + 1];
+    const int32_t er = (a + c) >> 1;
+    const int32_t ei = (b - d) >> 1;
+    const int32_t or_ = (b + d) >> 1;
+    const int32_t oi = (c - a) >> 1;
+    const int32_t wr = cos_q15(k * window_step);
+    const int32_t ws = sin_q15(k * window_step);
+    const int32_t xr = er + ((or_ * wr + oi * ws) >> 15);
+    const int32_t xi = ei + ((oi * wr - or_ * ws) >> 15);
+    const uint64_t p = (int64_t)xr * xr + (int64_t)xi * xi;
+    const int32_t v = power_to_db10(p) - kFullScaleDb10;
+    db10[k] = v < kMinDb10 ? kMinDb10 : v;
+  }
+}
+
+}  // namespace fft
@@ -0,0 +1,32 @@
+// Fixed point (Q15) real FFT for spectrum analysis of captured
+// signals. Uses integer math only, with a scaling by 1/2 in each
+// butterfly stage to avoid overflow.
+
+#pragma once
+
+#include <stdint.h>
+
+namespace fft {
+
+// Max number of real samples. Must be a power of 2.
+constexpr int kMaxSize = 1024;
+
+// Min number of real samples.
+constexpr int kMinSize = 16;
+
+// Min output value, in tenths of dB relative to a full scale 12 bit
+// sine. Lower values are clipped to it.
+constexpr int16_t kMinDb10 = -900;
+
+// Call once before using the other functions. Computes the twiddle table.
+extern void setup();
+
+// Compute the power spectrum of n real 12 bit signed samples, with a Hann
+// window. n must be a power of 2 in [kMinSize, kMaxSize]. 'samples' is
+// also used as the work buffer and its content is destroyed. Writes n/2
+// values to 'db10', in tenths of dB relative to a full scale 12 bit sine,
+// clipped at kMinDb10. Value i represents the frequency i *
+// sample_rate / n.
+extern void power_spectrum_db10(int16_t* samples, int n, int16_t* db10);
+
+}  // namespace fft
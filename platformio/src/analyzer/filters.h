@@ -2,8 +2,21 @@
 
 #pragma once
 
+#include <stdint.h>
+
 namespace filters {
 
+// Linear interpolation between the previous and the current value of
+// a signal, with rounding. previous_weight_q16 is the weight of the
+// previous value in 1/2^16 units. Used by the acquisition interrupt
+// routine, so uses integers only.
+inline uint16_t interpolate_q16(uint16_t previous, uint16_t current,
+                                int32_t previous_weight_q16) {
+  return current + ((((int32_t)previous - current) * previous_weight_q16 +
+                     (1 << 15)) >>
+                    16);
+}
+
 // K is in the range (0, 1024). The higher the value of K, the more the filter
 // smooths the signal. We use fixed point integers for efficiency since
 // this filter is used by the acquisition interrut routine.
@@ -21,6 +34,16 @@ class Adc12BitsLowPassFilter {
     return scaled_12bit_value_ >> 10;
   }
 
+  // Same as update() but the input has 2 additional fraction bits, e.g.
+  // a sum of 4 oversampled 12 bit samples. The returned value is still
+  // a 12 bit value.
+  inline uint16_t update_14_bits(uint16_t adc_14_bit_value) {
+    const uint32_t t1 = ((uint32_t)adc_14_bit_value) << 8;
+    const uint32_t t2 = (t1 * (1024 - k)) + (scaled_12bit_value_ * k);
+    scaled_12bit_value_ = t2 >> 10;
+    return scaled_12bit_value_ >> 10;
+  }
+
  private:
   // The current value with additional 10 bits representing the
   // fraction.
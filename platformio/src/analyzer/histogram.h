@@ -0,0 +1,175 @@
+// Mapping of step durations to histogram buckets. Used by the
+// acquisition interrupt routine and thus optimized for speed.
+//
+// Two bucket layouts are supported:
+//
+// LINEAR - The legacy 20 buckets of 100 steps/sec each. Speeds above
+//   1900 steps/sec are aggregated in the last bucket. The bucket index
+//   is found with a branchless search in a precomputed table of step
+//   durations, no divisions.
+//
+// LOG - HDR style buckets with 8 sub buckets per octave of
+//   ticks_in_step, covering 10 to 50,000 steps/sec with a resolution
+//   of 12.5% or better. The bucket index is computed with a CLZ
+//   instruction and a few shifts, no divisions.
+//
+// In both layouts, bucket indexes are in increasing speed order.
+
+#pragma once
+
+#include <Arduino.h>
+
+namespace histogram {
+
+enum Scale : uint8_t { SCALE_LINEAR, SCALE_LOG };
+
+// Sampling rate. Should match acquisition::TicksPerSecond.
+constexpr uint32_t kTicksPerSecond = 100000;
+
+// Steps longer than this, in ticks, are ignored since they
+// dominate the time and are typically not a movement. 10 steps/sec.
+constexpr uint32_t kMaxTicksInStep = kTicksPerSecond / 10;
+
+// ----- LINEAR layout.
+
+constexpr int kLinearNumBuckets = 20;
+
+// Each linear bucket represents a speed range of 100
+// steps/sec, starting from zero.
+constexpr int kLinearBucketStepsPerSecond = 100;
+
+// Reference mapping of ticks_in_step to a linear bucket. Uses two
+// divisions and thus not used by the isr. See linear_bucket_index().
+constexpr int linear_bucket_index_by_division(uint32_t ticks_in_step) {
+  const uint32_t steps_per_sec = kTicksPerSecond / ticks_in_step;
+  const uint32_t index = steps_per_sec / kLinearBucketStepsPerSecond;
+  return index < kLinearNumBuckets ? index : kLinearNumBuckets - 1;
+}
+
+// Steps of this number of ticks or more are in bucket 0. The
+// shorter ones have a table entry each.
+constexpr uint32_t kLinearTableSize =
+    kTicksPerSecond / kLinearBucketStepsPerSecond + 1;
+
+// The linear bucket of each ticks_in_step below kLinearTableSize.
+// Entry 0 is bucket 0, for the longer steps. 1KB of flash.
+struct LinearBucketTable {
+  uint8_t bucket_index[kLinearTableSize];
+
+  constexpr LinearBucketTable() : bucket_index() {
+    for (uint32_t t = 1; t < kLinearTableSize; t++) {
+      bucket_index[t] = linear_bucket_index_by_division(t);
+    }
+  }
+};
+
+constexpr LinearBucketTable kLinearBucketTable;
+
+// Division free mapping of ticks_in_step to a linear bucket. A
+// compare, a conditional select and a single table load.
+constexpr int linear_bucket_index(uint32_t ticks_in_step) {
+  return kLinearBucketTable
+      .bucket_index[ticks_in_step < kLinearTableSize ? ticks_in_step : 0];
+}
+
+// Compile time exhaustive check that the table lookup matches the
+// division based mapping for all the step durations we track.
+constexpr bool linear_bucket_index_matches(uint32_t max_ticks_in_step) {
+  for (uint32_t t = 1; t <= max_ticks_in_step; t++) {
+    if (linear_bucket_index(t) != linear_bucket_index_by_division(t)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static_assert(linear_bucket_index_matches(kMaxTicksInStep + 1),
+              "Linear bucket table mismatch");
+
+// ----- LOG layout.
+
+// Number of sub bucket bits per octave of ticks_in_step.
+constexpr int kLogSubBucketBits = 3;
+constexpr uint32_t kLogSubBuckets = 1 << kLogSubBucketBits;
+
+// Shortest step that has its own bucket, in ticks. 50,000 steps/sec.
+// Shorter steps are aggregated in the fastest bucket.
+constexpr uint32_t kLogMinTicksInStep = 2;
+
+// Returns the HDR index of a ticks_in_step value. Values below
+// kLogSubBuckets are mapped one to one, above that each octave
+// is split to kLogSubBuckets sub buckets. Monotonic in ticks.
+constexpr int log_ticks_index(uint32_t ticks) {
+  if (ticks < kLogSubBuckets) {
+    return ticks;
+  }
+  const int shift = (31 - __builtin_clz(ticks)) - kLogSubBucketBits;
+  return ((shift + 1) << kLogSubBucketBits) +
+         ((ticks >> shift) & (kLogSubBuckets - 1));
+}
+
+// Inverse of log_ticks_index(). Returns the smallest ticks
+// value that is mapped to the given HDR index.
+constexpr uint32_t log_index_min_ticks(int index) {
+  if (index < (int)kLogSubBuckets) {
+    return index;
+  }
+  return (kLogSubBuckets + (index & (kLogSubBuckets - 1)))
+         << ((index >> kLogSubBucketBits) - 1);
+}
+
+// HDR indexes of the longest and shortest steps we track.
+constexpr int kLogMaxTicksIndex = log_ticks_index(kMaxTicksInStep);
+constexpr int kLogMinTicksIndex = kLogMinTicksInStep;
+
+constexpr int kLogNumBuckets = kLogMaxTicksIndex - kLogMinTicksIndex + 1;
+
+static_assert(log_index_min_ticks(kLogMaxTicksIndex) <= kMaxTicksInStep &&
+                  log_index_min_ticks(kLogMaxTicksIndex + 1) > kMaxTicksInStep,
+              "Inconsistent log histogram range");
+
+// ----- Common.
+
+// Storage size for the largest layout.
+constexpr int kMaxNumBuckets =
+    kLogNumBuckets > kLinearNumBuckets ? kLogNumBuckets : kLinearNumBuckets;
+
+inline int num_buckets(Scale scale) {
+  return scale == SCALE_LOG ? kLogNumBuckets : kLinearNumBuckets;
+}
+
+// Returns the bucket index of a step with given duration, or -1
+// if the step should be ignored. Called from the isr on each step.
+inline int bucket_index(Scale scale, uint32_t ticks_in_step) {
+  if (ticks_in_step > kMaxTicksInStep) {
+    return -1;  // ignore very slow steps as they dominate the time.
+  }
+
+  if (scale == SCALE_LOG) {
+    if (ticks_in_step < kLogMinTicksInStep) {
+      ticks_in_step = kLogMinTicksInStep;
+    }
+    return kLogMaxTicksIndex - log_ticks_index(ticks_in_step);
+  }
+
+  return linear_bucket_index(ticks_in_step);
+}
+
+// Returns the lowest speed, in steps/sec, of the given bucket.
+// Not for use in the isr.
+inline uint32_t bucket_min_steps_per_sec(Scale scale, int index) {
+  if (scale == SCALE_LOG) {
+    // Longest step in this bucket is one tick less than the
+    // shortest step in the next slower bucket, but not longer than
+    // the longest step we track.
+    uint32_t max_ticks =
+        log_index_min_ticks(kLogMaxTicksIndex - index + 1) - 1;
+    if (max_ticks > kMaxTicksInStep) {
+      max_ticks = kMaxTicksInStep;
+    }
+    return kTicksPerSecond / max_ticks;
+  }
+  return index * kLinearBucketStepsPerSecond;
+}
+
+}  // namespace histogram
@@ -0,0 +1,45 @@
+#include "min_max_pyramid.h"
+
+#include "misc/decimation.h"
+
+static_assert(
+    acquisition::kCaptureBufferSize % (1 << MinMaxPyramid::kLastLevel) == 0,
+    "Capture size should be a multiple of the coarsest node");
+
+void MinMaxPyramid::compute(const acquisition::CaptureBuffer& capture_buffer) {
+  num_items_ = capture_buffer.items.size();
+
+  // The first level, from the capture items.
+  const uint16_t n = level_size(kFirstLevel);
+  if (n == 0) {
+    return;
+  }
+  const acquisition::CaptureItems& items = capture_buffer.items;
+  MinMaxNode* nodes = &nodes_[level_offset(kFirstLevel)];
+  decimation::decimate<int16_t>(
+      n << kFirstLevel, n, [&](uint32_t j) { return items.get(j)->v1; },
+      [&](uint16_t i, const decimation::Envelope<int16_t>& envelope) {
+        nodes[i].min1 = envelope.min;
+        nodes[i].max1 = envelope.max;
+      });
+  decimation::decimate<int16_t>(
+      n << kFirstLevel, n, [&](uint32_t j) { return items.get(j)->v2; },
+      [&](uint16_t i, const decimation::Envelope<int16_t>& envelope) {
+        nodes[i].min2 = envelope.min;
+        nodes[i].max2 = envelope.max;
+      });
+
+  // Each other level from pairs of nodes of the level below it.
+  for (int level = kFirstLevel + 1; level <= kLastLevel; level++) {
+    const uint16_t n = level_size(level);
+    for (uint16_t i = 0; i < n; i++) {
+      const MinMaxNode& a = get(level - 1, 2 * i);
+      const MinMaxNode& b = get(level - 1, 2 * i + 1);
+      MinMaxNode& node = nodes_[level_offset(level) + i];
+      node.min1 = a.min1 < b.min1 ? a.min1 : b.min1;
+      node.max1 = a.max1 > b.max1 ? a.max1 : b.max1;
+      node.min2 = a.min2 < b.min2 ? a.min2 : b.min2;
+      node.max2 = a.max2 > b.max2 ? a.max2 : b.max2;
+    }
+  }
+}
@@ -0,0 +1,60 @@
+// A min/max pyramid of a capture buffer. Each level l summarizes the
+// capture with nodes of 2^l items, with the min and max of each
+// channel. Allows to render any zoom level of the capture in a time
+// that is proportional to the number of displayed points rather than
+// to the number of capture items.
+
+#pragma once
+
+#include "acquisition.h"
+
+// The min and max of the two channels over a range of capture items.
+struct MinMaxNode {
+  int16_t min1;
+  int16_t max1;
+  int16_t min2;
+  int16_t max2;
+};
+
+// Index of the first node of a level in the nodes array of a pyramid
+// whose first level is first_level.
+constexpr int min_max_level_offset(int first_level, int level) {
+  return level <= first_level
+             ? 0
+             : min_max_level_offset(first_level, level - 1) +
+                   (acquisition::kCaptureBufferSize >> (level - 1));
+}
+
+class MinMaxPyramid {
+ public:
+  // The range of the levels that are kept. Finer levels are not needed
+  // by the oscilloscope zoom and coarser levels are cheap to compute
+  // from the kept ones.
+  static constexpr int kFirstLevel = 2;
+  static constexpr int kLastLevel = 3;
+
+  MinMaxPyramid() { clear(); }
+
+  void clear() { num_items_ = 0; }
+
+  // Recompute from a capture buffer. O(n).
+  void compute(const acquisition::CaptureBuffer& capture_buffer);
+
+  // Number of nodes of a level. Zero if there is no data.
+  uint16_t level_size(int level) const { return num_items_ >> level; }
+
+  // Returns node i of a level, i < level_size(level). The node
+  // summarizes the capture items [i * 2^level, (i + 1) * 2^level).
+  const MinMaxNode& get(int level, uint16_t i) const {
+    return nodes_[level_offset(level) + i];
+  }
+
+ private:
+  static constexpr int level_offset(int level) {
+    return min_max_level_offset(kFirstLevel, level);
+  }
+
+  // Number of capture items the nodes were computed from.
+  uint16_t num_items_;
+  MinMaxNode nodes_[min_max_level_offset(kFirstLevel, kLastLevel + 1)];
+};
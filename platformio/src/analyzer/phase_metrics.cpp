@@ -0,0 +1,145 @@
+#include "phase_metrics.h"
+
+namespace phase_metrics {
+
+// Zero crossing hysteresis in ADC counts. Matches the capture trigger.
+static constexpr int16_t kCrossingHysteresis = 10;
+
+// Min number of samples per cycle for meaningful metrics.
+static constexpr int kMinCycleSamples = 8;
+
+// Returns the index of the first v1 up crossing at or after 'start',
+// or -1 if not found.
+static int find_up_crossing(const acquisition::CaptureItems& items,
+                            int start) {
+  bool armed = false;
+  for (int i = start; i < items.size(); i++) {
+    const int16_t v1 = items.get(i)->v1;
+    if (v1 < -kCrossingHysteresis) {
+      armed = true;
+    } else if (armed && v1 >= 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// The k'th DFT bin of a window of n samples, computed with the
+// Goertzel algorithm. The bins of both channels are computed in a
+// single pass.
+struct Bins {
+  float re1, im1;
+  float re2, im2;
+};
+
+static void goertzel(const acquisition::CaptureItems& items, int start, int n,
+                     int k, Bins* bins) {
+  const float w = 2 * PI * k / n;
+  const float cos_w = cos(w);
+  const float sin_w = sin(w);
+  const float coeff = 2 * cos_w;
+  float s1a = 0, s2a = 0;
+  float s1b = 0, s2b = 0;
+  for (int i = start; i < start + n; i++) {
+    const acquisition::CaptureItem* item = items.get(i);
+    const float sa = item->v1 + coeff * s1a - s2a;
+    s2a = s1a;
+    s1a = sa;
+    const float sb = item->v2 + coeff * s1b - s2b;
+    s2b = s1b;
+    s1b = sb;
+  }
+  bins->re1 = s1a - s2a * cos_w;
+  bins->im1 = s2a * sin_w;
+  bins->re2 = s1b - s2b * cos_w;
+  bins->im2 = s2b * sin_w;
+}
+
+bool compute(const acquisition::CaptureBuffer& capture_buffer,
+             PhaseMetrics* metrics) {
+  const acquisition::CaptureItems& items = capture_buffer.items;
+
+  const int start = find_up_crossing(items, 0);
+  if (start < 0) {
+    return false;
+  }
+  const int end = find_up_crossing(items, start + 1);
+  if (end < 0) {
+    return false;
+  }
+  const int n = end - start;
+  if (n < kMinCycleSamples) {
+    return false;
+  }
+  metrics->cycle_samples = n;
+
+  // Current vector magnitude ripple.
+  float min_magnitude = 1e9;
+  float max_magnitude = 0;
+  float sum_magnitude = 0;
+  for (int i = start; i < end; i++) {
+    const acquisition::CaptureItem* item = items.get(i);
+    const float magnitude =
+        sqrt((float)item->v1 * item->v1 + (float)item->v2 * item->v2);
+    min_magnitude = min(min_magnitude, magnitude);
+    max_magnitude = max(max_magnitude, magnitude);
+    sum_magnitude += magnitude;
+  }
+  const float avg_magnitude = sum_magnitude / n;
+  metrics->magnitude_ripple_percent =
+      avg_magnitude > 0 ? 100 * (max_magnitude - min_magnitude) / avg_magnitude
+                        : 0;
+
+  // Fundamental.
+  Bins bins;
+  goertzel(items, start, n, 1, &bins);
+  const float amp1 = sqrt(bins.re1 * bins.re1 + bins.im1 * bins.im1);
+  const float amp2 = sqrt(bins.re2 * bins.re2 + bins.im2 * bins.im2);
+  const float avg_amp = (amp1 + amp2) / 2;
+  metrics->imbalance_percent = avg_amp > 0 ? 100 * (amp1 - amp2) / avg_amp : 0;
+
+  // Phase difference in (-180, 180]. The sign depends on the
+  // direction of rotation so we report the deviation of its
+  // absolute value.
+  float phase_diff =
+      (atan2(bins.im1, bins.re1) - atan2(bins.im2, bins.re2)) * (180 / PI);
+  if (phase_diff > 180) {
+    phase_diff -= 360;
+  } else if (phase_diff <= -180) {
+    phase_diff += 360;
+  }
+  metrics->phase_offset_degrees = abs(phase_diff) - 90;
+
+  // Harmonics, up to the Nyquist limit of the cycle.
+  const int max_harmonic = min(kMaxHarmonic, (n - 1) / 2);
+  float harmonics_power1 = 0;
+  float harmonics_power2 = 0;
+  for (int k = 2; k <= max_harmonic; k++) {
+    goertzel(items, start, n, k, &bins);
+    harmonics_power1 += bins.re1 * bins.re1 + bins.im1 * bins.im1;
+    harmonics_power2 += bins.re2 * bins.re2 + bins.im2 * bins.im2;
+  }
+  metrics->thd1_percent = amp1 > 0 ? 100 * sqrt(harmonics_power1) / amp1 : 0;
+  metrics->thd2_percent = amp2 > 0 ? 100 * sqrt(harmonics_power2) / amp2 : 0;
+
+  return true;
+}
+
+void dump(const PhaseMetrics& metrics) {
+  // samples, ripple [%], imbalance [%], phase offset [deg], thd1 [%],
+  // thd2 [%].
+  Serial.print("PHASE,");
+  Serial.print(metrics.cycle_samples);
+  Serial.print(',');
+  Serial.print(metrics.magnitude_ripple_percent, 1);
+  Serial.print(',');
+  Serial.print(metrics.imbalance_percent, 1);
+  Serial.print(',');
+  Serial.print(metrics.phase_offset_degrees, 1);
+  Serial.print(',');
+  Serial.print(metrics.thd1_percent, 1);
+  Serial.print(',');
+  Serial.println(metrics.thd2_percent, 1);
+}
+
+}  // namespace phase_metrics
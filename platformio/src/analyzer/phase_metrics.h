@@ -0,0 +1,42 @@
+// Quality metrics of the coil current patterns. Computed from a
+// single electrical cycle of a captured signal. Uses floating point
+// and thus should not be called from the interrupt routine.
+
+#pragma once
+
+#include "acquisition.h"
+
+namespace phase_metrics {
+
+// Max harmonic included in the THD computation.
+constexpr int kMaxHarmonic = 7;
+
+struct PhaseMetrics {
+  // Number of capture samples in the analyzed electrical cycle.
+  uint16_t cycle_samples;
+  // Peak to peak ripple of the current vector magnitude, as a
+  // percentage of its average. Zero for a perfect circle in the
+  // phase pattern.
+  float magnitude_ripple_percent;
+  // Difference between the amplitudes of the fundamentals of the
+  // two channels, as a percentage of their average.
+  float imbalance_percent;
+  // Deviation of the phase difference between the fundamentals
+  // of the two channels from 90 degrees.
+  float phase_offset_degrees;
+  // Total harmonic distortion of each channel, up to kMaxHarmonic,
+  // as a percentage of the fundamental.
+  float thd1_percent;
+  float thd2_percent;
+};
+
+// Compute the metrics of the first complete electrical cycle in the
+// capture buffer. A cycle starts and ends with v1 crossing up zero.
+// Returns false if the capture has no complete cycle.
+extern bool compute(const acquisition::CaptureBuffer& capture_buffer,
+                    PhaseMetrics* metrics);
+
+// Print the metrics as a CSV line over the USB/serial connection.
+extern void dump(const PhaseMetrics& metrics);
+
+}  // namespace phase_metrics
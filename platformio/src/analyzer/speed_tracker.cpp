@@ -12,23 +12,20 @@ bool SpeedTracker::track(const acquisition::State* state,
     return false;
   }
 
-  // This should behave well even when tick_count overflows.
-  const uint32_t delta_ticks = state->tick_count - last_ticks_;
+  // The 64 bits tick_count never overflows.
+  const uint64_t delta_ticks = state->tick_count - last_ticks_;
 
   // Expects a minimal time tick interval for good accuracy.
   if (delta_ticks < (acquisition::TicksPerSecond / 25)) {
     return false;
   }
 
-  const int32_t delta_steps = state->full_steps - last_steps_;
+  const int64_t delta_steps = state->full_steps - last_steps_;
 
-
-  // Hopefully this can't overflow. Otherwise need to compute
-  // using int64.
   if (steps_per_sec != nullptr) {
-    const int32_t result =
-        (delta_steps * (int32_t)acquisition::TicksPerSecond) / (int32_t)delta_ticks;
-    *steps_per_sec = result;
+    const int64_t result =
+        (delta_steps * acquisition::TicksPerSecond) / (int64_t)delta_ticks;
+    *steps_per_sec = (int32_t)result;
   }
 
   // Update for next cycle.
@@ -22,6 +22,6 @@ class SpeedTracker {
 
  private:
   bool has_data_;
-  uint32_t last_ticks_;
-  int32_t last_steps_;
+  uint64_t last_ticks_;
+  int64_t last_steps_;
 };
\ No newline at end of file
@@ -20,4 +20,24 @@ static constexpr bool kEnableScreenshots = false;
 // screen.
 static constexpr bool kEnableDebugEvents = false;
 
+// Number of motors that are decoded simultaneously. Each axis uses a
+// pair of ADC inputs that are sampled in the same ADC scan, see the
+// channel table in hal/adc.cpp. The reference design has a single pair
+// of current sensors, adding axes requires additional ADC inputs.
+static constexpr int kNumAxes = 1;
+
+// For developers only. When enabled, each completed move is reported
+// as a CSV line over the USB/serial connection.
+static constexpr bool kEnableMoveReports = false;
+
+// For developers only. When enabled, the Phase page reports the phase
+// metrics of each new capture as a CSV line over the USB/serial
+// connection.
+static constexpr bool kEnablePhaseMetricsReports = false;
+
+// For developers only. When enabled, the touch points of each touch
+// screen poll, while touched, are reported over the USB/serial
+// connection, in the format of the gesture detector test traces.
+static constexpr bool kEnableTouchTraces = false;
+
 }  // namespace config
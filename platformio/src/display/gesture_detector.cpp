@@ -0,0 +1,91 @@
+#include "gesture_detector.h"
+
+// A swipe should move at least this distance in pixels, within the
+// max time from the touch start.
+static constexpr int16_t kMinSwipeDistance = 100;
+static constexpr uint32_t kMaxSwipeMillis = 500;
+
+// The main direction of a swipe should be at least this factor of the
+// other direction.
+static constexpr int16_t kSwipeDirectionRatio = 2;
+
+// A pinch should change the distance between the fingers by at least
+// this ratio, kPinchRatioNum / kPinchRatioDen.
+static constexpr int32_t kPinchRatioNum = 3;
+static constexpr int32_t kPinchRatioDen = 2;
+
+static int32_t distance_sq(const touch_driver::TouchPoint& p1,
+                           const touch_driver::TouchPoint& p2) {
+  const int32_t dx = p1.x - p2.x;
+  const int32_t dy = p1.y - p2.y;
+  return dx * dx + dy * dy;
+}
+
+Gesture GestureDetector::track(uint8_t num_points,
+                               const touch_driver::TouchPoint* points,
+                               uint32_t millis_now) {
+  // A release ends the touch.
+  if (num_points == 0) {
+    state_ = STATE_IDLE;
+    return GESTURE_NONE;
+  }
+
+  if (state_ == STATE_DONE) {
+    return GESTURE_NONE;
+  }
+
+  if (state_ == STATE_IDLE) {
+    state_ = STATE_TRACKING;
+    start_millis_ = millis_now;
+    start_point_ = points[0];
+    pinch_start_distance_sq_ = 0;
+  }
+
+  // Two fingers. Can be only a pinch.
+  if (num_points >= 2) {
+    const int32_t d_sq = distance_sq(points[0], points[1]);
+    if (pinch_start_distance_sq_ == 0) {
+      // Not zero, even if the two points are the same.
+      pinch_start_distance_sq_ = d_sq + 1;
+      return GESTURE_NONE;
+    }
+    // Compare the squared distances with the squared ratio.
+    const int32_t num_sq = kPinchRatioNum * kPinchRatioNum;
+    const int32_t den_sq = kPinchRatioDen * kPinchRatioDen;
+    if (d_sq * den_sq >= pinch_start_distance_sq_ * num_sq) {
+      state_ = STATE_DONE;
+      return GESTURE_PINCH_OUT;
+    }
+    if (d_sq * num_sq <= pinch_start_distance_sq_ * den_sq) {
+      state_ = STATE_DONE;
+      return GESTURE_PINCH_IN;
+    }
+    return GESTURE_NONE;
+  }
+
+  // Here when a single finger. If it follows two fingers, it's the
+  // end of a pinch that was not recognized.
+  if (pinch_start_distance_sq_ != 0) {
+    return GESTURE_NONE;
+  }
+
+  // Too slow for a swipe. A normal touch.
+  if (millis_now - start_millis_ > kMaxSwipeMillis) {
+    state_ = STATE_DONE;
+    return GESTURE_NONE;
+  }
+
+  const int16_t dx = points[0].x - start_point_.x;
+  const int16_t dy = points[0].y - start_point_.y;
+  const int16_t abs_dx = dx < 0 ? -dx : dx;
+  const int16_t abs_dy = dy < 0 ? -dy : dy;
+  if (abs_dx >= kMinSwipeDistance && abs_dx >= kSwipeDirectionRatio * abs_dy) {
+    state_ = STATE_DONE;
+    return dx < 0 ? GESTURE_SWIPE_LEFT : GESTURE_SWIPE_RIGHT;
+  }
+  if (abs_dy >= kMinSwipeDistance && abs_dy >= kSwipeDirectionRatio * abs_dx) {
+    state_ = STATE_DONE;
+    return dy < 0 ? GESTURE_SWIPE_UP : GESTURE_SWIPE_DOWN;
+  }
+  return GESTURE_NONE;
+}
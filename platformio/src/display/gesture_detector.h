@@ -0,0 +1,59 @@
+// Detects swipe and pinch gestures from the touch points.
+//
+// Feed it with the touch points of each touch screen poll. A gesture
+// is reported once per touch, as soon as it's recognized, so the
+// touch can be excluded from the normal button processing before it
+// is released. Has no hardware dependencies.
+
+#pragma once
+
+#include "touch_driver.h"
+
+enum Gesture {
+  GESTURE_NONE,
+  GESTURE_SWIPE_LEFT,
+  GESTURE_SWIPE_RIGHT,
+  GESTURE_SWIPE_UP,
+  GESTURE_SWIPE_DOWN,
+  // Two fingers moving toward each other.
+  GESTURE_PINCH_IN,
+  // Two fingers moving away from each other.
+  GESTURE_PINCH_OUT,
+};
+
+class GestureDetector {
+ public:
+  GestureDetector() { reset(); }
+
+  void reset() {
+    state_ = STATE_IDLE;
+    start_millis_ = 0;
+    start_point_ = {0, 0};
+    pinch_start_distance_sq_ = 0;
+  }
+
+  // Track the touch points of a poll. num_points is in
+  // [0, touch_driver::kMaxTouchPoints]. Returns the gesture that was
+  // recognized, or GESTURE_NONE.
+  Gesture track(uint8_t num_points, const touch_driver::TouchPoint* points,
+                uint32_t millis_now);
+
+ private:
+  enum State {
+    // No touch.
+    STATE_IDLE,
+    // Tracking a touch.
+    STATE_TRACKING,
+    // A gesture was reported, or the touch can't be a gesture. Waiting
+    // for the release.
+    STATE_DONE,
+  };
+
+  State state_;
+  // Start time and point of a single finger touch.
+  uint32_t start_millis_;
+  touch_driver::TouchPoint start_point_;
+  // Squared distance between the two points when the second finger
+  // touched. Zero if not a two fingers touch.
+  int32_t pinch_start_distance_sq_;
+};
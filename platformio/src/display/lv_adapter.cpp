@@ -3,6 +3,8 @@
 
 #include "lv_adapter.h"
 
+#include "config.h"
+#include "gesture_detector.h"
 #include "hal/gpio.h"
 #include "lvgl.h"
 #include "tft_driver.h"
@@ -131,18 +133,72 @@ void static init_display_driver() {
   lv_disp_drv_register(&disp_drv);
 }
 
+// The touch screen input device.
+static lv_indev_t* touch_indev = nullptr;
+
+static GestureDetector gesture_detector;
+
+// The last gesture that was not consumed yet.
+static Gesture pending_gesture = GESTURE_NONE;
+
+// Report a touch screen poll, see config::kEnableTouchTraces. The
+// release that ends a touch is reported too.
+static void report_touch_trace(uint8_t num_points,
+                               const touch_driver::TouchPoint* points) {
+  static uint8_t last_num_points = 0;
+  if (num_points || last_num_points) {
+    const touch_driver::TouchPoint none = {0, 0};
+    const touch_driver::TouchPoint& p0 = num_points > 0 ? points[0] : none;
+    const touch_driver::TouchPoint& p1 = num_points > 1 ? points[1] : none;
+    Serial.printf("{%u, %u, {{%d, %d}, {%d, %d}}},\n", millis(), num_points,
+                  p0.x, p0.y, p1.x, p1.y);
+  }
+  last_num_points = num_points;
+}
+
 // This is how LVGL reads the touch screen's status.
 bool my_touch_read_cb(lv_indev_drv_t* drv, lv_indev_data_t* data) {
-  uint16_t x, y;
-  bool is_pressed;
-  touch_driver::touch_read_read(&x, &y, &is_pressed);
-  data->point.x = x;
-  data->point.y = y;
-  data->state = is_pressed ? LV_INDEV_STATE_PR : LV_INDEV_STATE_REL;
+  // Reported to LVGL also when released.
+  static touch_driver::TouchPoint last_point = {0, 0};
+
+  touch_driver::TouchPoint points[touch_driver::kMaxTouchPoints];
+  const uint8_t num_points = touch_driver::touch_read_read(points);
+  // With two fingers, LVGL stays pressed at the last single finger
+  // point.
+  if (num_points == 1) {
+    last_point = points[0];
+  }
+  data->point.x = last_point.x;
+  data->point.y = last_point.y;
+  data->state = num_points ? LV_INDEV_STATE_PR : LV_INDEV_STATE_REL;
+
+  if (config::kEnableTouchTraces) {
+    report_touch_trace(num_points, points);
+  }
+
+  const Gesture gesture =
+      gesture_detector.track(num_points, points, millis());
+  if (gesture != GESTURE_NONE) {
+    pending_gesture = gesture;
+    // Prevent a click when the gesture is released.
+    if (touch_indev) {
+      lv_indev_wait_release(touch_indev);
+    }
+  }
+
   // No buffering now so no more data read.
   return false;
 }
 
+bool consume_gesture(Gesture* gesture) {
+  if (pending_gesture == GESTURE_NONE) {
+    return false;
+  }
+  *gesture = pending_gesture;
+  pending_gesture = GESTURE_NONE;
+  return true;
+}
+
 void static init_touch_driver() {
   lv_indev_drv_t indev_drv;
   lv_indev_drv_init(&indev_drv);
@@ -150,7 +206,7 @@ void static init_touch_driver() {
   indev_drv.read_cb = my_touch_read_cb;
   // Register the driver in LVGL and save the created input device object.
   // TODO: verify result is not null (error)
-  lv_indev_drv_register(&indev_drv);
+  touch_indev = lv_indev_drv_register(&indev_drv);
 }
 
 // Called once from main on program start.
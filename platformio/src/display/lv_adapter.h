@@ -1,12 +1,16 @@
 
 #pragma once
 
+#include "gesture_detector.h"
 #include "stm32f4xx_hal.h"
 
 namespace lv_adapter {
 
 extern void setup();
 
+// Returns true and sets *gesture if a touch gesture is pending.
+extern bool consume_gesture(Gesture* gesture);
+
 // For developement.
 extern void dump_stats();
 extern void start_screen_capture();
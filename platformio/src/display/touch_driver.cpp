@@ -3,11 +3,9 @@
 // https://github.com/lvgl/lv_port_esp32/blob/ace36bf14af1ca96faa56ea9dedc3cba6fb2415a/components/lvgl_esp32_drivers/lvgl_touch/ft6x36.c
 #include "touch_driver.h"
 
-// TODO: check hal errors.
-
 #include <Arduino.h>
 
-#include "hal/i2c.h"
+#include "misc/i2c_queue.h"
 
 #define FT6236_I2C_SLAVE_ADDR 0x38
 
@@ -15,9 +13,6 @@
 #define MAX_X ((uint16_t)480)
 #define MAX_Y ((uint16_t)320)
 
-/* Max detectable simultaneous touch points */
-#define FT6X36_MAX_TOUCH_PNTS 2
-
 /* Register of the current mode */
 #define FT6X36_DEV_MODE_REG 0x00
 
@@ -134,18 +129,18 @@
 
 namespace touch_driver {
 
+// Blocking read of a single register. For initialization and
+// debugging only.
 bool ft6x06_i2c_read8(uint8_t register_addr, uint8_t* data_buf) {
-  uint8_t tx_bfr[] = {register_addr};
-
-  HAL_StatusTypeDef status = HAL_I2C_Master_Transmit(
-      &i2c::hi2c1, FT6236_I2C_SLAVE_ADDR << 1 | 0, tx_bfr, sizeof(tx_bfr), 100);
-  if (status != HAL_OK) {
-    return false;
-  }
-
-  status = HAL_I2C_Master_Receive(&i2c::hi2c1, FT6236_I2C_SLAVE_ADDR << 1 | 1,
-                                  data_buf, 1, 100);
-  return status == HAL_OK;
+  static bool ok;
+  i2c_queue::Transaction transaction;
+  transaction.device_address = FT6236_I2C_SLAVE_ADDR;
+  transaction.reg = register_addr;
+  transaction.data = data_buf;
+  transaction.size = 1;
+  transaction.callback = [](bool read_ok, void* context) { ok = read_ok; };
+  ok = false;
+  return i2c_queue::submit(transaction) && i2c_queue::wait_idle(200) && ok;
 }
 
 void test() {
@@ -173,49 +168,81 @@ void test() {
                 (uint32_t)data_buf);
 }
 
-// TODO: return last x, y in case of an error, as the ESP32 port does.
-void touch_read_read(uint16_t* x, uint16_t* y, bool* is_pressed) {
-  // uint8_t data_xy[4];         // 2 bytes X | 2 bytes Y
+bool probe() {
+  uint8_t chip_id = 0;
+  return ft6x06_i2c_read8(FT6X36_CHIPSELECT_REG, &chip_id);
+}
+
+// The touch state is read in the background by the I2C queue, with
+// a single burst read of the registers TD_STAT to P2_YL. Each
+// touch_read_read() returns the last state and starts the next read.
+static constexpr uint8_t kBurstFirstReg = FT6X36_TD_STAT_REG;
+static constexpr uint8_t kBurstSize = FT6X36_P2_YL_REG - kBurstFirstReg + 1;
 
-  static int16_t last_x = 0;
-  static int16_t last_y = 0;
+// Offset of a register in the burst.
+static constexpr uint8_t burst_offset(uint8_t reg) {
+  return reg - kBurstFirstReg;
+}
 
-  uint8_t touch_pnt_cnt;  // Number of detected touch points
+// The XH register of each touch point. The other registers of a
+// point follow it.
+static constexpr uint8_t kPointXhRegs[kMaxTouchPoints] = {FT6X36_P1_XH_REG,
+                                                          FT6X36_P2_XH_REG};
+
+struct Vars {
+  // Buffer of the read in progress.
+  uint8_t burst[kBurstSize];
+  // True if a read is in progress.
+  bool read_pending = false;
+  // The last touch state.
+  uint8_t num_points = 0;
+  TouchPoint points[kMaxTouchPoints] = {};
+};
+
+static Vars vars;
+
+static inline uint16_t burst_value12(uint8_t high_reg) {
+  const uint8_t* p = &vars.burst[burst_offset(high_reg)];
+  return ((p[0] & FT6X36_MSB_MASK) << 8) | (p[1] & FT6X36_LSB_MASK);
+}
 
-  // ft6x06_i2c_read8(current_dev_addr, FT6X36_TD_STAT_REG, &touch_pnt_cnt);
-  ft6x06_i2c_read8(FT6X36_TD_STAT_REG, &touch_pnt_cnt);
-  if (touch_pnt_cnt != 1) {  // ignore no touch & multi touch
-    *x = last_x;
-    *y = last_y;
-    *is_pressed = false;
+static void on_read_done(bool ok, void* context) {
+  vars.read_pending = false;
+  // Keep the last state in case of an error.
+  if (!ok) {
     return;
   }
+  uint8_t n =
+      vars.burst[burst_offset(FT6X36_TD_STAT_REG)] & FT6X36_TD_STAT_MASK;
+  // Values above the max are invalid.
+  if (n > kMaxTouchPoints) {
+    n = 0;
+  }
+  for (uint8_t i = 0; i < n; i++) {
+    const uint8_t xh_reg = kPointXhRegs[i];
+    // Note that we swap x, y.
+    vars.points[i].y = burst_value12(xh_reg);
+    // invert x.
+    vars.points[i].x = MAX_X - burst_value12(xh_reg + 2);
+  }
+  vars.num_points = n;
+}
 
-  uint8_t tx_bfr1[] = {FT6X36_P1_XH_REG};
-  HAL_I2C_Master_Transmit(&i2c::hi2c1, FT6236_I2C_SLAVE_ADDR << 1 | 0, tx_bfr1,
-                          sizeof(tx_bfr1), 100);
-  uint8_t rx_bfr1[2];
-  HAL_I2C_Master_Receive(&i2c::hi2c1, FT6236_I2C_SLAVE_ADDR << 1 | 1, rx_bfr1,
-                         sizeof(rx_bfr1), 100);
-  uint8_t tx_bfr2[] = {FT6X36_P1_YH_REG};
-  HAL_I2C_Master_Transmit(&i2c::hi2c1, FT6236_I2C_SLAVE_ADDR << 1 | 0, tx_bfr2,
-                          sizeof(tx_bfr2), 100);
-  uint8_t rx_bfr2[2];
-  HAL_I2C_Master_Receive(&i2c::hi2c1, FT6236_I2C_SLAVE_ADDR << 1 | 1, rx_bfr2,
-                         sizeof(rx_bfr2), 100);
-
-  // Note that we swap x, y.
-  last_y =
-      ((rx_bfr1[0] & FT6X36_MSB_MASK) << 8) | (rx_bfr1[1] & FT6X36_LSB_MASK);
-  last_x =
-      ((rx_bfr2[0] & FT6X36_MSB_MASK) << 8) | (rx_bfr2[1] & FT6X36_LSB_MASK);
-
-  // invert x.
-  last_x = MAX_X - last_x;
-  
-  *x = last_x;
-  *y = last_y;
-  *is_pressed = true;
+uint8_t touch_read_read(TouchPoint* points) {
+  if (!vars.read_pending) {
+    i2c_queue::Transaction transaction;
+    transaction.device_address = FT6236_I2C_SLAVE_ADDR;
+    transaction.reg = kBurstFirstReg;
+    transaction.data = vars.burst;
+    transaction.size = kBurstSize;
+    transaction.callback = on_read_done;
+    // If the queue is full, try again on the next call.
+    vars.read_pending = i2c_queue::submit(transaction);
+  }
+  for (uint8_t i = 0; i < vars.num_points; i++) {
+    points[i] = vars.points[i];
+  }
+  return vars.num_points;
 }
 
 }  // namespace touch_driver
@@ -4,7 +4,26 @@
 #include <Arduino.h>
 
 namespace touch_driver {
+
+// Max detectable simultaneous touch points.
+constexpr uint8_t kMaxTouchPoints = 2;
+
+// A touch point in screen coordinates.
+struct TouchPoint {
+  int16_t x;
+  int16_t y;
+};
+
 extern void test();
-extern void touch_read_read(uint16_t* x, uint16_t* y, bool* is_pressed);
+
+// Returns true if the touch controller responds. Blocking, for program
+// initialization only.
+extern bool probe();
+
+// Returns the number of the last touch points, in
+// [0, kMaxTouchPoints], and sets them in points. Starts reading the
+// next ones in the background, via the I2C queue. Does not wait for
+// the I2C bus.
+extern uint8_t touch_read_read(TouchPoint* points);
 
 }  // namespace touch_driver
@@ -2,10 +2,30 @@
 
 #include "adc.h"
 
+#include "config.h"
 #include "stm32_def.h"
 
 namespace adc {
 
+// An ADC input pin and its channel.
+struct AdcInput {
+  uint32_t channel;
+  GPIO_TypeDef* port;
+  uint16_t pin;
+};
+
+// The pair of ADC inputs of each axis, in scan order. Additional
+// axes need additional entries here and a matching GPIO clock enable
+// in MX_ADC_MspInit().
+static const AdcInput kAxisInputs[][2] = {
+    // Axis 0.
+    {{ADC_CHANNEL_8, AIN0_GPIO_Port, AIN0_Pin},
+     {ADC_CHANNEL_9, AIN1_GPIO_Port, AIN1_Pin}},
+};
+static_assert(sizeof(kAxisInputs) / sizeof(kAxisInputs[0]) ==
+                  config::kNumAxes,
+              "Inconsistent axis inputs table");
+
 
 static void MX_ADC_MspInit(ADC_HandleTypeDef* adcHandle);
 
@@ -25,7 +45,7 @@ void MX_ADC1_Init() {
   hadc1.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_RISING;
   hadc1.Init.ExternalTrigConv = ADC_EXTERNALTRIGCONV_T1_CC1;
   hadc1.Init.DataAlign = ADC_DATAALIGN_RIGHT;
-  hadc1.Init.NbrOfConversion = 2;
+  hadc1.Init.NbrOfConversion = 2 * config::kNumAxes;
   hadc1.Init.DMAContinuousRequests = ENABLE;
   hadc1.Init.EOCSelection = ADC_EOC_SEQ_CONV;
   if (HAL_ADC_Init(&hadc1) != HAL_OK) {
@@ -33,21 +53,17 @@ void MX_ADC1_Init() {
   }
 
   /** Configure for the selected ADC regular channel its corresponding rank in
-   * the sequencer and its sample time.
+   * the sequencer and its sample time. The scan converts the two channels
+   * of axis 0, then of axis 1, and so on, which is the layout of
+   * dma::AdcPoint.
    */
-  sConfig.Channel = ADC_CHANNEL_8;
-  sConfig.Rank = 1;
   sConfig.SamplingTime = ADC_SAMPLETIME_3CYCLES;
-  if (HAL_ADC_ConfigChannel(&hadc1, &sConfig) != HAL_OK) {
-    Error_Handler();
-  }
-  /** Configure for the selected ADC regular channel its corresponding rank in
-   * the sequencer and its sample time.
-   */
-  sConfig.Channel = ADC_CHANNEL_9;
-  sConfig.Rank = 2;
-  if (HAL_ADC_ConfigChannel(&hadc1, &sConfig) != HAL_OK) {
-    Error_Handler();
+  for (int i = 0; i < 2 * config::kNumAxes; i++) {
+    sConfig.Channel = kAxisInputs[i / 2][i % 2].channel;
+    sConfig.Rank = i + 1;
+    if (HAL_ADC_ConfigChannel(&hadc1, &sConfig) != HAL_OK) {
+      Error_Handler();
+    }
   }
 
   // TODO: can we let the HAL call this as done with MX Cube generated
@@ -71,10 +87,13 @@ static void MX_ADC_MspInit(ADC_HandleTypeDef* adcHandle) {
     PB0     ------> ADC1_IN8
     PB1     ------> ADC1_IN9
     */
-    GPIO_InitStruct.Pin = AIN0_Pin | AIN1_Pin;
     GPIO_InitStruct.Mode = GPIO_MODE_ANALOG;
     GPIO_InitStruct.Pull = GPIO_NOPULL;
-    HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+    for (int i = 0; i < 2 * config::kNumAxes; i++) {
+      const AdcInput& input = kAxisInputs[i / 2][i % 2];
+      GPIO_InitStruct.Pin = input.pin;
+      HAL_GPIO_Init(input.port, &GPIO_InitStruct);
+    }
 
     /* ADC1 DMA Init */
     /* ADC1 Init */
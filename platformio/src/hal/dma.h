@@ -6,17 +6,23 @@
 
 #pragma once
 
+#include "config.h"
 #include "stm32f4xx_hal.h"
 
 namespace dma {
 
-// Two consecutive half words for ADC in0 and in1 samples
+// Two consecutive half words for the two channels of an axis
 // per the confiuration of the ADC and DMA.
-struct AdcPoint {
+struct AxisSamples {
   uint16_t v1;
   uint16_t v2;
 };
 
+// The samples of a single ADC scan, a pair per axis.
+struct AdcPoint {
+  AxisSamples axes[config::kNumAxes];
+};
+
 // ADC DMA buffers. Each 32 bit word contains a pair <adc2, adc1>
 // of uint16_t with 12 bit values of ADC2 and ADC1 respectivly.
 //
@@ -0,0 +1,55 @@
+// Internal flash access.
+
+#include "flash.h"
+
+namespace flash {
+
+// The flash sectors 6 and 7 of the STM32F401CE.
+static constexpr uint32_t kSectorSize = 128 * 1024;
+static constexpr uint32_t kSectorAddresses[kNumStoreSectors] = {0x08040000,
+                                                                0x08060000};
+static constexpr uint32_t kSectorNumbers[kNumStoreSectors] = {FLASH_SECTOR_6,
+                                                              FLASH_SECTOR_7};
+
+class McuFlashSectors : public FlashSectors {
+ public:
+  virtual uint32_t sector_size() const override { return kSectorSize; }
+
+  virtual const uint8_t* sector_data(int sector) const override {
+    return (const uint8_t*)kSectorAddresses[sector];
+  }
+
+  virtual bool erase(int sector) override {
+    FLASH_EraseInitTypeDef erase_init = {0};
+    erase_init.TypeErase = FLASH_TYPEERASE_SECTORS;
+    erase_init.Sector = kSectorNumbers[sector];
+    erase_init.NbSectors = 1;
+    erase_init.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+    uint32_t sector_error = 0;
+
+    HAL_FLASH_Unlock();
+    const HAL_StatusTypeDef status =
+        HAL_FLASHEx_Erase(&erase_init, &sector_error);
+    HAL_FLASH_Lock();
+    return status == HAL_OK;
+  }
+
+  virtual bool program(int sector, uint32_t offset, const uint32_t* words,
+                       int n) override {
+    const uint32_t address = kSectorAddresses[sector] + offset;
+    bool ok = true;
+    HAL_FLASH_Unlock();
+    for (int i = 0; i < n && ok; i++) {
+      ok = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, address + 4 * i,
+                             words[i]) == HAL_OK;
+    }
+    HAL_FLASH_Lock();
+    return ok;
+  }
+};
+
+static McuFlashSectors store_sectors_;
+
+FlashSectors& store_sectors() { return store_sectors_; }
+
+}  // namespace flash
@@ -0,0 +1,18 @@
+// Internal flash access for the flash store.
+//
+// The store uses the two last 128KB sectors of the STM32F401CE flash,
+// sectors 6 and 7. The firmware size is limited accordingly, see
+// board_upload.maximum_size in platformio.ini.
+
+#pragma once
+
+#include "flash_sectors.h"
+#include "stm32f4xx_hal.h"
+
+namespace flash {
+
+// The MCU flash sectors of the store. Programming stalls the CPU for
+// ~16us per word and erasing a sector for 1-2 secs.
+extern FlashSectors& store_sectors();
+
+}  // namespace flash
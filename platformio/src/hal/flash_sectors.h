@@ -0,0 +1,32 @@
+// The abstract flash sectors of the flash store. Has no hardware
+// dependencies so the store can run over a host RAM mock.
+
+#pragma once
+
+#include <stdint.h>
+
+namespace flash {
+
+// Number of flash sectors used by the store.
+constexpr int kNumStoreSectors = 2;
+
+// An abstract pair of flash sectors.
+class FlashSectors {
+ public:
+  // Size of each sector in bytes. A multiple of 4.
+  virtual uint32_t sector_size() const = 0;
+
+  // Memory mapped read only content of a sector.
+  virtual const uint8_t* sector_data(int sector) const = 0;
+
+  // Erase a sector to all 0xff bytes. Returns true if ok.
+  virtual bool erase(int sector) = 0;
+
+  // Program n 32 bit words at the given byte offset in a sector. The
+  // offset should be word aligned and the words should be erased.
+  // Returns true if ok.
+  virtual bool program(int sector, uint32_t offset, const uint32_t* words,
+                       int n) = 0;
+};
+
+}  // namespace flash
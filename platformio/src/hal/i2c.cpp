@@ -6,9 +6,11 @@ namespace i2c {
 
 I2C_HandleTypeDef hi2c1;
 
-void MX_I2C1_Init(void) {
+void MX_I2C1_Init(uint32_t clock_speed) {
   hi2c1.Instance = I2C1;
-  hi2c1.Init.ClockSpeed = 100000;
+  hi2c1.Init.ClockSpeed = clock_speed;
+  // In fast mode, the 2:1 low/high ratio meets the 1.3us min low time
+  // of the I2C spec with any APB1 clock. 16:9 needs a multiple of 10MHz.
   hi2c1.Init.DutyCycle = I2C_DUTYCYCLE_2;
   hi2c1.Init.OwnAddress1 = 0;
   hi2c1.Init.AddressingMode = I2C_ADDRESSINGMODE_7BIT;
@@ -22,8 +24,72 @@ void MX_I2C1_Init(void) {
   }
 }
 
+void set_clock_speed(uint32_t clock_speed) {
+  HAL_I2C_DeInit(&hi2c1);
+  MX_I2C1_Init(clock_speed);
+}
+
+// Set by the HAL callbacks below, from the I2C interrupts.
+static volatile TransferStatus transfer_status = TRANSFER_OK;
+
+class Hi2c1Port : public I2cPort {
+ public:
+  virtual bool start_read(uint8_t device_address, uint8_t reg, uint8_t* data,
+                          uint16_t n) override {
+    transfer_status = TRANSFER_BUSY;
+    if (HAL_I2C_Mem_Read_IT(&hi2c1, device_address << 1, reg,
+                            I2C_MEMADD_SIZE_8BIT, data, n) != HAL_OK) {
+      transfer_status = TRANSFER_ERROR;
+      return false;
+    }
+    return true;
+  }
+
+  virtual bool start_write(uint8_t device_address, uint8_t reg,
+                           const uint8_t* data, uint16_t n) override {
+    transfer_status = TRANSFER_BUSY;
+    // The HAL does not modify the data.
+    if (HAL_I2C_Mem_Write_IT(&hi2c1, device_address << 1, reg,
+                             I2C_MEMADD_SIZE_8BIT, (uint8_t*)data,
+                             n) != HAL_OK) {
+      transfer_status = TRANSFER_ERROR;
+      return false;
+    }
+    return true;
+  }
+
+  virtual TransferStatus status() const override { return transfer_status; }
+
+  virtual void reset() override {
+    set_clock_speed(hi2c1.Init.ClockSpeed);
+    transfer_status = TRANSFER_ERROR;
+  }
+};
+
+static Hi2c1Port port_;
+
+I2cPort& port() { return port_; }
+
+// From CubeMX generated file  stm32f4xx_it.c.
+extern "C" void I2C1_EV_IRQHandler(void) { HAL_I2C_EV_IRQHandler(&hi2c1); }
+
+extern "C" void I2C1_ER_IRQHandler(void) { HAL_I2C_ER_IRQHandler(&hi2c1); }
+
 }  // namespace i2c
 
+// Called by the HAL from the I2C interrupts when a transfer ends.
+void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef* hi2c) {
+  i2c::transfer_status = i2c::TRANSFER_OK;
+}
+
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef* hi2c) {
+  i2c::transfer_status = i2c::TRANSFER_OK;
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c) {
+  i2c::transfer_status = i2c::TRANSFER_ERROR;
+}
+
 
 // Called by HAL_I2C_Init().
 void HAL_I2C_MspInit(I2C_HandleTypeDef* i2cHandle)
@@ -46,5 +112,11 @@ void HAL_I2C_MspInit(I2C_HandleTypeDef* i2cHandle)
 
     /* I2C1 clock enable */
     __HAL_RCC_I2C1_CLK_ENABLE();
+
+    // Lower priority than the ADC DMA interrupt of the acquisition.
+    HAL_NVIC_SetPriority(I2C1_EV_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(I2C1_EV_IRQn);
+    HAL_NVIC_SetPriority(I2C1_ER_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(I2C1_ER_IRQn);
   }
 }
@@ -1,12 +1,22 @@
-
 #pragma once
 
+#include "i2c_port.h"
 #include "stm32f4xx_hal.h"
 
 namespace i2c {
 extern I2C_HandleTypeDef hi2c1;
 
-void MX_I2C1_Init();
+// I2C clock speeds in Hz.
+constexpr uint32_t kStandardModeClockSpeed = 100000;
+constexpr uint32_t kFastModeClockSpeed = 400000;
 
-}  // namespace i2c
+void MX_I2C1_Init(uint32_t clock_speed = kFastModeClockSpeed);
+
+// Reinitialize I2C1 with a different clock speed. Should be called when
+// there are no transfers in progress.
+void set_clock_speed(uint32_t clock_speed);
 
+// The interrupt driven port of I2C1.
+extern I2cPort& port();
+
+}  // namespace i2c
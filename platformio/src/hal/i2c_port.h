@@ -0,0 +1,39 @@
+// The abstract I2C port of the I2C queue. Has no hardware dependencies
+// so the queue can run over a host mock.
+
+#pragma once
+
+#include <stdint.h>
+
+namespace i2c {
+
+// Status of the last transfer of an I2cPort.
+enum TransferStatus {
+  TRANSFER_BUSY,
+  TRANSFER_OK,
+  TRANSFER_ERROR,
+};
+
+// An abstract I2C master with non blocking register reads and writes
+// of devices with 8 bit register addresses.
+class I2cPort {
+ public:
+  // Start reading n bytes from consecutive registers of a device, with
+  // a 7 bit device address. data should stay valid until the transfer
+  // ends. Returns false if the transfer could not start.
+  virtual bool start_read(uint8_t device_address, uint8_t reg,
+                          uint8_t* data, uint16_t n) = 0;
+
+  // Same as start_read() but writes n bytes.
+  virtual bool start_write(uint8_t device_address, uint8_t reg,
+                           const uint8_t* data, uint16_t n) = 0;
+
+  // Status of the last started transfer.
+  virtual TransferStatus status() const = 0;
+
+  // Abort a transfer that does not end, e.g. of a stuck bus, and
+  // reinitialize the port.
+  virtual void reset() = 0;
+};
+
+}  // namespace i2c
@@ -10,6 +10,9 @@ static void HAL_TIM_MspPostInit(TIM_HandleTypeDef* timHandle);
 
 TIM_HandleTypeDef htim1;
 
+// TIM1 period at the base trigger rate. 84Mhz / 840 = 100Khz.
+static constexpr uint32_t kBasePeriod = 840;
+
 // TIM1 init function
 void MX_TIM1_Init() {
   TIM_ClockConfigTypeDef sClockSourceConfig = {0};
@@ -20,7 +23,7 @@ void MX_TIM1_Init() {
   htim1.Instance = TIM1;
   htim1.Init.Prescaler = 0;
   htim1.Init.CounterMode = TIM_COUNTERMODE_UP;
-  htim1.Init.Period = 840 - 1;
+  htim1.Init.Period = kBasePeriod - 1;
   htim1.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
   htim1.Init.RepetitionCounter = 0;
   htim1.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
@@ -76,4 +79,10 @@ static void HAL_TIM_MspPostInit(TIM_HandleTypeDef* timHandle) {
   }
 }
 
+void set_trigger_rate_factor(uint32_t factor) {
+  // Restart the count so the counter is never above the new period.
+  __HAL_TIM_SET_AUTORELOAD(&htim1, kBasePeriod / factor - 1);
+  __HAL_TIM_SET_COUNTER(&htim1, 0);
+}
+
 }  // namespace tim
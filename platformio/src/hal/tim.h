@@ -13,4 +13,8 @@ extern TIM_HandleTypeDef htim1;
 // Call this once during initialization.
 void MX_TIM1_Init();
 
+// Set the ADC trigger rate to factor times the base rate of 100Khz.
+// The factor should divide the base timer period of 840.
+void set_trigger_rate_factor(uint32_t factor);
+
 }  // namespace tim
@@ -2,18 +2,24 @@
 
 #include <Arduino.h>
 
+#include "analyzer/accel_profiler.h"
 #include "analyzer/acquisition.h"
+#include "config.h"
 #include "display/lv_adapter.h"
 #include "display/tft_driver.h"
 #include "display/touch_driver.h"
 #include "hal/adc.h"
 #include "hal/dma.h"
+#include "hal/flash.h"
 #include "hal/gpio.h"
 #include "hal/i2c.h"
 #include "hal/tim.h"
 #include "lvgl.h"
-#include "misc/config_eeprom.h"
+#include "misc/config_flash.h"
 #include "misc/elapsed.h"
+#include "misc/flash_store.h"
+#include "misc/i2c_queue.h"
+#include "misc/lifetime_stats.h"
 #include "misc/memory.h"
 #include "ui/screen_manager.h"
 
@@ -36,8 +42,48 @@ HardwareTimer tim2(TIM2);
 
 static Elapsed elapsed_from_last_dump;
 
+// For rate limiting the flash store erase attempts.
+static Elapsed elapsed_from_last_flash_erase;
+
 static void lvgl_irq_tick() { lv_tick_inc(5); }
 
+// Number of moves reported so far by report_new_moves().
+static uint32_t moves_reported = 0;
+static Elapsed elapsed_from_last_moves_report;
+
+// Report over USB/serial the moves that were completed since
+// last call. Moves that were dropped from the acquisition buffer
+// are skipped.
+static void report_new_moves() {
+  const acquisition::MoveRecords* moves = acquisition::sample_moves();
+
+  // Handle data reset.
+  if (moves->total_moves < moves_reported) {
+    moves_reported = 0;
+  }
+
+  const uint64_t reset_tick_count = acquisition::reset_tick_count();
+  const uint32_t new_moves = moves->total_moves - moves_reported;
+  const uint16_t size = moves->items.size();
+  const uint16_t first = new_moves < size ? size - new_moves : 0;
+  for (uint16_t i = first; i < size; i++) {
+    const acquisition::MoveRecord& move = *moves->items.get(i);
+    const uint32_t seq = moves->total_moves - size + i + 1;
+    const uint32_t steps = abs(move.steps);
+    const int avg_peak_milliamps = acquisition::adc_value_to_milliamps(
+        steps ? move.total_step_peak_currents / steps : 0);
+    // seq, start [ms], duration [ms], steps, peak speed [steps/sec],
+    // avg peak current [ma], quadrature errors.
+    Serial.printf("MOVE,%lu,%lu,%lu,%ld,%lu,%d,%u\n", seq,
+                  (uint32_t)acquisition::ticks_to_millis(move.start_tick -
+                                                         reset_tick_count),
+                  (uint32_t)acquisition::ticks_to_millis(move.duration_ticks),
+                  move.steps, acquisition::move_peak_steps_per_sec(move),
+                  avg_peak_milliamps, move.quadrature_errors);
+  }
+  moves_reported = moves->total_moves;
+}
+
 void setup() {
   // Init hardware.
   gpio::MX_GPIO_Init();
@@ -46,15 +92,23 @@ void setup() {
   tim::MX_TIM1_Init();
   adc::MX_ADC1_Init();
 
+  i2c_queue::setup(&i2c::port());
+  // Fall back to the I2C standard mode if the bus is too slow for the
+  // fast mode, e.g. because of weak pullups.
+  if (!touch_driver::probe()) {
+    i2c::set_clock_speed(i2c::kStandardModeClockSpeed);
+  }
+  flash_store::setup(&flash::store_sectors());
   acquisition::Settings settings;
-  config_eeprom::read_acquisition_settings(&settings);
+  config_flash::read_acquisition_settings(&settings);
   acquisition::setup(settings);
+  lifetime_stats::setup();
 
   // Since DMA is in done in 16 bit units (half words), we specify the total
   // count of 16 bit values in buffer1 + buffer2. We cas the buffer point to
   // uint32_t as expected by the API.
   HAL_ADC_Start_DMA(&adc::hadc1, (uint32_t*)dma::kDmaAdcPointBuffer1,
-                    dma::kDmaAdcPointBufferSize * 2 * 2);
+                    dma::kDmaAdcPointBufferSize * 2 * config::kNumAxes * 2);
 
   // HAL_TIM_PWM_Start(&tim::htim1, TIM_CHANNEL_1);
   HAL_TIM_PWM_Start(&tim::htim1, TIM_CHANNEL_1);
@@ -91,9 +145,33 @@ void loop() {
   // LVGL processing and rendering.
   lv_task_handler();
 
+  // Background I2C transactions, e.g. of the touch screen.
+  i2c_queue::loop();
+
+  // Background analysis of the acquired data.
+  accel_profiler::loop();
+
+  // Lifetime stats sampling and checkpoints.
+  lifetime_stats::loop();
+
+  // Erase the spare flash store sector, after a compaction, when the
+  // stall loses no data.
+  if (!flash_store::is_spare_sector_erased() &&
+      elapsed_from_last_flash_erase.elapsed_millis() >= 5000 &&
+      acquisition::is_idle()) {
+    elapsed_from_last_flash_erase.reset();
+    flash_store::erase_spare_sector();
+  }
+
   // Screen updates.
   screen_manager::loop();
 
+  if (config::kEnableMoveReports &&
+      elapsed_from_last_moves_report.elapsed_millis() >= 100) {
+    elapsed_from_last_moves_report.reset();
+    report_new_moves();
+  }
+
   // Heartbeat.
   if (millis() % 3000 < 50) {
     LED1_ON;
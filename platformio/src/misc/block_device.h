@@ -0,0 +1,34 @@
+// An abstract block storage device, e.g. an SD card or a SPI flash.
+//
+// Blocks are written in the background, e.g. by DMA, so the main loop
+// doesn't wait for the device. Used by the recorder.
+
+#pragma once
+
+#include <Arduino.h>
+
+namespace block_device {
+
+enum WriteStatus { WRITE_BUSY, WRITE_OK, WRITE_ERROR };
+
+class BlockDevice {
+ public:
+  // Size of each block in bytes, e.g. 512 for an SD card sector.
+  virtual uint32_t block_size() const = 0;
+
+  // Number of blocks in the device.
+  virtual uint32_t num_blocks() const = 0;
+
+  // Read a block to data. Blocking. Returns true if ok.
+  virtual bool read(uint32_t block, uint8_t* data) = 0;
+
+  // Start writing data to a block. The data should stay unchanged
+  // until status() is not WRITE_BUSY. If failed to start, status() is
+  // WRITE_ERROR.
+  virtual void start_write(uint32_t block, const uint8_t* data) = 0;
+
+  // The status of the last write. WRITE_OK if none.
+  virtual WriteStatus status() = 0;
+};
+
+}  // namespace block_device
@@ -52,6 +52,11 @@ class CircularBuffer {
   }
 
 
+  // Drop up to this number of oldest items.
+  inline void remove_oldest(uint16_t count) {
+    size_ = (count < size_) ? size_ - count : 0;
+  }
+
   // Keep up to this number of newest items.
   inline void keep_at_most(uint16_t max_size) {
       // Nothing to do.
@@ -2,7 +2,7 @@
 
 #include <CRC32.h>
 
-#include "hal/i2c.h"
+#include "i2c_queue.h"
 
 namespace config_eeprom {
 
@@ -12,34 +12,57 @@ static constexpr uint16_t kSettingsAddress = kSettingsCrcAddress + 4;
 // i2c device address.
 constexpr uint8_t kEepromDeviceAddress = 0x50;
 
+// Max number of axes, other than axis 0, with persistent offsets.
+constexpr int kMaxExtraAxes = 4;
+static_assert(config::kNumAxes <= 1 + kMaxExtraAxes,
+              "Not enough space for the axes offsets");
+
+// Default channel offset.
+constexpr int16_t kDefaultOffset = 1800;
+
 struct ConfigPayload {
-  // Acquisition channels offsets.
+  // Acquisition channels offsets of axis 0.
   int16_t offset1 = 0;
   int16_t offset2 = 0;
   // Acquisition direction flag.
   bool reverse_direction = false;
-  // Reserve. Always write as 0.
-  uint8_t reserved[32] = {};
+  // Acquisition adaptive threshold flag.
+  bool adaptive_threshold = false;
+  // Acquisition histogram scale. A histogram::Scale value.
+  uint8_t histogram_scale = histogram::SCALE_LINEAR;
+  // Acquisition oversampling flag.
+  bool oversampling = false;
+  // Acquisition channels offsets of axes 1 and up. Zero means not
+  // set. These bytes were reserved in older versions and thus zero.
+  acquisition::AxisOffsets extra_axes_offsets[kMaxExtraAxes] = {};
+  // Reserve. Always written as 0.
+  uint8_t reserved[13] = {};
 };
 
-// sizeof() = 40 as of Jan 2021.
 struct ConfigPacket {
   uint32_t crc;
   ConfigPayload payload;
 };
 
+// New fields take bytes from the reserved ones, so the packets of
+// older versions are still read.
+static_assert(sizeof(ConfigPacket) == 44, "Unexpected config packet size");
+
 // Use this as default package value.
 static const ConfigPayload kDefaultConfigPayload = {
-    .offset1 = 1800,
-    .offset2 = 1800,
+    .offset1 = kDefaultOffset,
+    .offset2 = kDefaultOffset,
     .reverse_direction = false,
+    .adaptive_threshold = false,
+    .histogram_scale = histogram::SCALE_LINEAR,
+    .oversampling = false,
 };
 
-static void clear_reserved(ConfigPayload* payload) {
-  memset(&payload->reserved, 0x0, sizeof(payload->reserved));
+// Return the given persistent offset or the default offset if not set.
+static int16_t offset_or_default(int16_t offset) {
+  return offset ? offset : kDefaultOffset;
 }
 
-// 'packet.reserved should be pre cleared.
 static uint32_t compute_crc(const ConfigPayload& payload) {
   // This is a light class. Ok to have on stack.
   CRC32 crc;
@@ -47,67 +70,43 @@ static uint32_t compute_crc(const ConfigPayload& payload) {
   return crc.finalize();
 }
 
-bool read_bytes(uint8_t byte_address, uint8_t* bfr, uint8_t size) {
-  // Command 1: Set eeprom internal address register using a dummy write.
-  HAL_StatusTypeDef status = HAL_I2C_Master_Transmit(
-      &i2c::hi2c1, kEepromDeviceAddress << 1 | 0, &byte_address, 1, 100);
-  if (status != HAL_OK) {
-    return false;
-  }
+// Max time to wait for a read. Reads happen only on program
+// initialization so this doesn't block the main loop.
+static constexpr uint32_t kReadTimeoutMillis = 200;
 
-  // Command 2: Read N bytes.
-  status = HAL_I2C_Master_Receive(&i2c::hi2c1, kEepromDeviceAddress << 1 | 1,
-                                  bfr, size, 100);
-  if (status != HAL_OK) {
-    return false;
-  }
-  return true;
-}
+// Set by the transaction callback.
+static bool read_ok;
 
-bool write_bytes(uint8_t byte_address, const uint8_t* data, uint8_t data_size) {
-  uint8_t bytes_written = 0;
-
-  while (bytes_written < data_size) {
-    // Writes must be in a single 8 bytes page. Determine how many
-    // bytes we have to write in the next page.
-    const uint8_t next_byte_address = byte_address + bytes_written;
-    const uint8_t bytes_left = data_size - bytes_written;
-    uint8_t bytes_in_page = 8 - (next_byte_address & 0x7);
-    if (bytes_in_page > bytes_left) {
-      bytes_in_page = bytes_left;
-    }
-
-    // Preper send buffer. Start address + one to eight bytes to write.
-    // bytes_in_page is in the range [1, 8].
-    uint8_t bfr[1 + 8];
-    bfr[0] = next_byte_address;
-    for (uint8_t i = 0; i < bytes_in_page; i++) {
-      bfr[i + 1] = data[bytes_written++];
-    }
-
-    // Send.
-    HAL_StatusTypeDef status =
-        HAL_I2C_Master_Transmit(&i2c::hi2c1, kEepromDeviceAddress << 1 | 0, bfr,
-                                bytes_in_page + 1, 100);
-
-    if (status != HAL_OK) {
-      last_status = "WRITE_ERROR";
-      return false;
-    }
-
-    // Let the eeprom finish pending writes, if any. See Twr in the datasheet.
-    delay(10);
-  }
+static void on_read_done(bool ok, void* context) { read_ok = ok; }
 
-  last_status = "WRITE_OK";
-  return true;
+// Blocking read via the I2C queue.
+bool read_bytes(uint8_t byte_address, uint8_t* bfr, uint8_t size) {
+  i2c_queue::Transaction transaction;
+  transaction.device_address = kEepromDeviceAddress;
+  transaction.reg = byte_address;
+  transaction.data = bfr;
+  transaction.size = size;
+  transaction.callback = on_read_done;
+  read_ok = false;
+  return i2c_queue::submit(transaction) &&
+         i2c_queue::wait_idle(kReadTimeoutMillis) && read_ok;
 }
 
 static void copy_settings(const ConfigPayload& payload,
                           acquisition::Settings* settings) {
-  settings->offset1 = payload.offset1;
-  settings->offset2 = payload.offset2;
+  settings->offsets[0].offset1 = payload.offset1;
+  settings->offsets[0].offset2 = payload.offset2;
+  for (int i = 1; i < config::kNumAxes; i++) {
+    const acquisition::AxisOffsets& offsets = payload.extra_axes_offsets[i - 1];
+    settings->offsets[i].offset1 = offset_or_default(offsets.offset1);
+    settings->offsets[i].offset2 = offset_or_default(offsets.offset2);
+  }
   settings->reverse_direction = payload.reverse_direction;
+  settings->adaptive_threshold = payload.adaptive_threshold;
+  settings->oversampling = payload.oversampling;
+  settings->histogram_scale = (payload.histogram_scale == histogram::SCALE_LOG)
+                                  ? histogram::SCALE_LOG
+                                  : histogram::SCALE_LINEAR;
 }
 
 const char* last_status = "NONE";
@@ -136,19 +135,4 @@ bool read_acquisition_settings(acquisition::Settings* settings) {
   return true;
 }
 
-// Returns true if written ok.
-bool write_acquisition_settings(const acquisition::Settings& settings) {
-  ConfigPacket packet;
-  // Populate payload.
-  packet.payload.offset1 = settings.offset1;
-  packet.payload.offset2 = settings.offset2;
-  packet.payload.reverse_direction = settings.reverse_direction;
-  clear_reserved(&packet.payload);
-
-  // Compute checkscum.
-  packet.crc = compute_crc(packet.payload);
-
-  return write_bytes(0, (uint8_t*)&packet, sizeof(packet));
-}
-
 }  // namespace config_eeprom
\ No newline at end of file
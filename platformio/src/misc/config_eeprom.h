@@ -1,18 +1,18 @@
 
+// The settings of older versions, in the I2C EEPROM. Read only, the
+// settings are now kept in the flash store, see config_flash.h, and
+// are read from here once, to migrate them.
+
 #pragma once
 
 #include "analyzer/acquisition.h"
 
 namespace config_eeprom {
 
-    
 // Returns true if read ok. Otherwise default settings are returned.
 extern bool read_acquisition_settings(acquisition::Settings* settings);
 
-// Returns true if written ok.
-extern bool write_acquisition_settings(const acquisition::Settings& settings);
-
-// Returns a human readable status from last read/write operation. For 
+// Returns a human readable status from last read operation. For
 // Debugging.
 extern const char* last_status;
 }  // namespace
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include "config_flash.h"
+
+#include "config_eeprom.h"
+#include "flash_store.h"
+
+namespace config_flash {
+
+// The persistent form of acquisition::Settings. A different size, e.g.
+// of a build with a different number of axes, is treated as missing.
+struct SettingsValue {
+  acquisition::AxisOffsets offsets[config::kNumAxes];
+  bool reverse_direction;
+  bool adaptive_threshold;
+  bool oversampling;
+  // A histogram::Scale value.
+  uint8_t histogram_scale;
+};
+
+const char* last_status = "NONE";
+
+bool read_acquisition_settings(acquisition::Settings* settings) {
+  SettingsValue value;
+  if (!flash_store::read(flash_store::KEY_ACQUISITION_SETTINGS, &value,
+                         sizeof(value))) {
+    // Not in the flash yet. Use the EEPROM settings, or the defaults if
+    // not available, and keep them in the flash from now on.
+    const bool eeprom_ok = config_eeprom::read_acquisition_settings(settings);
+    const bool write_ok = write_acquisition_settings(*settings);
+    last_status = (eeprom_ok && write_ok) ? "MIGRATED" : "DEFAULTS";
+    return eeprom_ok;
+  }
+
+  for (int i = 0; i < config::kNumAxes; i++) {
+    settings->offsets[i] = value.offsets[i];
+  }
+  settings->reverse_direction = value.reverse_direction;
+  settings->adaptive_threshold = value.adaptive_threshold;
+  settings->oversampling = value.oversampling;
+  settings->histogram_scale = (value.histogram_scale == histogram::SCALE_LOG)
+                                  ? histogram::SCALE_LOG
+                                  : histogram::SCALE_LINEAR;
+  last_status = "OK";
+  return true;
+}
+
+bool write_acquisition_settings(const acquisition::Settings& settings) {
+  SettingsValue value;
+  // Clear the padding so unchanged settings are not rewritten.
+  memset(&value, 0, sizeof(value));
+  for (int i = 0; i < config::kNumAxes; i++) {
+    value.offsets[i] = settings.offsets[i];
+  }
+  value.reverse_direction = settings.reverse_direction;
+  value.adaptive_threshold = settings.adaptive_threshold;
+  value.oversampling = settings.oversampling;
+  value.histogram_scale = settings.histogram_scale;
+
+  const bool ok = flash_store::write(flash_store::KEY_ACQUISITION_SETTINGS,
+                                     &value, sizeof(value));
+  last_status = ok ? "WRITE_OK" : "WRITE_ERROR";
+  return ok;
+}
+
+}  // namespace config_flash
@@ -0,0 +1,21 @@
+// Persistent settings in the internal flash. Replaces the external
+// EEPROM, whose settings are migrated on first use.
+
+#pragma once
+
+#include "analyzer/acquisition.h"
+
+namespace config_flash {
+
+// Returns true if read ok. Otherwise default settings are returned.
+// Call after flash_store::setup().
+extern bool read_acquisition_settings(acquisition::Settings* settings);
+
+// Returns true if written ok.
+extern bool write_acquisition_settings(const acquisition::Settings& settings);
+
+// Returns a human readable status from last read/write operation. For
+// Debugging.
+extern const char* last_status;
+
+}  // namespace config_flash
@@ -0,0 +1,83 @@
+// Reduces sequences of samples to columns of a chart with the min,
+// max and mean of each column. Drawing the min and max of each column
+// keeps short spikes visible regardless of the number of samples per
+// column.
+
+#pragma once
+
+#include <Arduino.h>
+
+namespace decimation {
+
+// The min, max and mean of a group of samples.
+template <class T>
+struct Envelope {
+  T min;
+  T max;
+  T mean;
+};
+
+// Accumulates samples of a single column.
+template <class T>
+class EnvelopeAccumulator {
+ public:
+  void reset() {
+    count_ = 0;
+    sum_ = 0;
+  }
+
+  inline void add(T value) {
+    if (count_ == 0) {
+      min_ = value;
+      max_ = value;
+    } else if (value < min_) {
+      min_ = value;
+    } else if (value > max_) {
+      max_ = value;
+    }
+    sum_ += value;
+    count_++;
+  }
+
+  bool is_empty() const { return count_ == 0; }
+
+  // Should not be empty.
+  Envelope<T> envelope() const {
+    return Envelope<T>{min_, max_, (T)(sum_ / (int64_t)count_)};
+  }
+
+ private:
+  T min_ = 0;
+  T max_ = 0;
+  int64_t sum_ = 0;
+  uint32_t count_ = 0;
+};
+
+// Reduces n samples to w columns, with n >= w > 0. Column i covers the
+// samples [i * n / w, (i + 1) * n / w). sample(j) returns sample j and
+// column(i, envelope) receives the envelope of column i. O(n).
+template <class T, class SampleFn, class ColumnFn>
+void decimate(uint32_t n, uint16_t w, SampleFn sample, ColumnFn column) {
+  // Column boundaries are tracked with a remainder instead of a
+  // division per column.
+  const uint32_t base = n / w;
+  const uint32_t remainder = n % w;
+  uint32_t error = 0;
+  uint32_t j = 0;
+  EnvelopeAccumulator<T> accumulator;
+  for (uint16_t i = 0; i < w; i++) {
+    uint32_t end = j + base;
+    error += remainder;
+    if (error >= w) {
+      error -= w;
+      end++;
+    }
+    accumulator.reset();
+    for (; j < end; j++) {
+      accumulator.add(sample(j));
+    }
+    column(i, accumulator.envelope());
+  }
+}
+
+}  // namespace decimation
@@ -0,0 +1,321 @@
+#include "flash_store.h"
+
+#include <CRC32.h>
+
+namespace flash_store {
+
+// Sector layout: a header with a magic word and a sequence number,
+// followed by the records. Erased flash reads as 0xff bytes.
+static constexpr uint32_t kSectorMagic = 0x53544f31;  // "STO1"
+static constexpr uint32_t kSectorHeaderSize = 8;
+
+// Record layout, in 32 bit words: a header word with the key in the
+// low 16 bits and the value size in the high 16 bits, the value padded
+// with zeros to whole words, and a CRC of the header and value words.
+// The header is programmed first so a partial record is skipped by its
+// CRC.
+static constexpr uint32_t kErasedWord = 0xffffffff;
+static constexpr uint32_t kMaxValueWords = (kMaxValueSize + 3) / 4;
+static constexpr uint32_t kMaxRecordWords = 1 + kMaxValueWords + 1;
+
+// Max number of distinct keys that are preserved on compaction.
+static constexpr int kMaxKeys = 16;
+
+// A record in the active sector.
+struct Record {
+  // Byte offset of the record header in the sector.
+  uint32_t offset;
+  uint16_t key;
+  uint16_t size;
+  // True if the CRC is ok.
+  bool valid;
+};
+
+struct Vars {
+  flash::FlashSectors* sectors = nullptr;
+  // The sector with the records, in [0, 1].
+  int active_sector = 0;
+  // Sequence number of the active sector.
+  uint32_t sequence = 0;
+  // Byte offset of the first free word in the active sector.
+  uint32_t end_offset = 0;
+  // True if the other sector is known to be erased, so compaction
+  // doesn't need to erase it.
+  bool spare_erased = false;
+};
+
+static Vars vars;
+
+static inline uint32_t value_words(uint16_t size) { return (size + 3) / 4; }
+
+static inline const uint32_t* sector_words(int sector) {
+  return (const uint32_t*)vars.sectors->sector_data(sector);
+}
+
+static uint32_t record_crc(const uint32_t* header_and_value, uint16_t size) {
+  CRC32 crc;
+  crc.update((const uint8_t*)header_and_value, 4 * (1 + value_words(size)));
+  return crc.finalize();
+}
+
+// Parse the record at the given byte offset of a sector. Returns false
+// at the end of the log, including a header that was not completely
+// programmed.
+static bool parse_record(int sector, uint32_t offset, Record* record) {
+  const uint32_t sector_size = vars.sectors->sector_size();
+  if (offset + 8 > sector_size) {
+    return false;
+  }
+  const uint32_t* words = sector_words(sector) + offset / 4;
+  const uint32_t header = words[0];
+  if (header == kErasedWord) {
+    return false;
+  }
+  record->offset = offset;
+  record->key = header & 0xffff;
+  record->size = header >> 16;
+  if (record->size == 0 || record->size > kMaxValueSize ||
+      offset + 4 * (2 + value_words(record->size)) > sector_size) {
+    return false;
+  }
+  record->valid = words[1 + value_words(record->size)] ==
+                  record_crc(words, record->size);
+  return true;
+}
+
+static inline uint32_t next_record_offset(const Record& record) {
+  return record.offset + 4 * (2 + value_words(record.size));
+}
+
+// Find the last valid record of a key in a sector. Returns false if
+// not found.
+static bool find_last_record(int sector, uint16_t key, Record* result) {
+  bool found = false;
+  Record record;
+  uint32_t offset = kSectorHeaderSize;
+  while (parse_record(sector, offset, &record)) {
+    if (record.valid && record.key == key) {
+      *result = record;
+      found = true;
+    }
+    offset = next_record_offset(record);
+  }
+  return found;
+}
+
+// Returns the byte offset of the end of the log of a sector.
+static uint32_t find_end_offset(int sector) {
+  Record record;
+  uint32_t offset = kSectorHeaderSize;
+  while (parse_record(sector, offset, &record)) {
+    offset = next_record_offset(record);
+  }
+  return offset;
+}
+
+static bool is_sector_formatted(int sector, uint32_t* sequence) {
+  const uint32_t* words = sector_words(sector);
+  if (words[0] != kSectorMagic || words[1] == kErasedWord) {
+    return false;
+  }
+  *sequence = words[1];
+  return true;
+}
+
+static bool is_sector_erased(int sector) {
+  const uint32_t* words = sector_words(sector);
+  const uint32_t n = vars.sectors->sector_size() / 4;
+  for (uint32_t i = 0; i < n; i++) {
+    if (words[i] != kErasedWord) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Make an erased sector the active sector, with no records. The
+// header is programmed by the caller, after the records.
+static void start_sector(int sector) {
+  vars.active_sector = sector;
+  vars.sequence++;
+  vars.end_offset = kSectorHeaderSize;
+}
+
+static bool program_sector_header() {
+  const uint32_t header[] = {kSectorMagic, vars.sequence};
+  return vars.sectors->program(vars.active_sector, 0, header, 2);
+}
+
+// Program a record at the end of the active sector.
+static bool append_record(uint16_t key, const void* data, uint16_t size) {
+  const uint32_t n = value_words(size);
+  uint32_t words[kMaxRecordWords];
+  words[0] = ((uint32_t)size << 16) | key;
+  words[n] = 0;  // Zero padding.
+  memcpy(&words[1], data, size);
+  words[1 + n] = record_crc(words, size);
+
+  if (vars.end_offset + 4 * (2 + n) > vars.sectors->sector_size()) {
+    return false;
+  }
+  const bool ok = vars.sectors->program(vars.active_sector, vars.end_offset,
+                                        words, 2 + n);
+  // Even if failed, the words may be partly programmed.
+  Record record;
+  if (!parse_record(vars.active_sector, vars.end_offset, &record)) {
+    // Can't append after a bad header. Force a compaction.
+    vars.end_offset = vars.sectors->sector_size();
+    return false;
+  }
+  vars.end_offset = next_record_offset(record);
+  return ok && record.valid;
+}
+
+// Copy the last value of each key to the other sector and make it
+// the active sector. If failed, the old sector stays active. Doesn't
+// erase, fails if the other sector is not erased yet.
+static bool compact() {
+  if (!vars.spare_erased) {
+    return false;
+  }
+  const int old_sector = vars.active_sector;
+
+  // Collect the keys.
+  uint16_t keys[kMaxKeys];
+  int num_keys = 0;
+  Record record;
+  uint32_t offset = kSectorHeaderSize;
+  while (parse_record(old_sector, offset, &record)) {
+    if (record.valid) {
+      int i = 0;
+      while (i < num_keys && keys[i] != record.key) {
+        i++;
+      }
+      if (i == num_keys && num_keys < kMaxKeys) {
+        keys[num_keys++] = record.key;
+      }
+    }
+    offset = next_record_offset(record);
+  }
+
+  const uint32_t old_sequence = vars.sequence;
+  const uint32_t old_end_offset = vars.end_offset;
+  start_sector(1 - old_sector);
+  // Either the old sector or a partly programmed one.
+  vars.spare_erased = false;
+  bool ok = true;
+  for (int i = 0; ok && i < num_keys; i++) {
+    if (find_last_record(old_sector, keys[i], &record)) {
+      const uint32_t* words = sector_words(old_sector) + record.offset / 4;
+      ok = append_record(record.key, &words[1], record.size);
+    }
+  }
+  // The new sector becomes valid only now, with all the values.
+  ok = ok && program_sector_header();
+
+  if (!ok) {
+    vars.active_sector = old_sector;
+    vars.sequence = old_sequence;
+    vars.end_offset = old_end_offset;
+  }
+  return ok;
+}
+
+bool setup(flash::FlashSectors* sectors) {
+  vars.sectors = sectors;
+
+  uint32_t sequences[flash::kNumStoreSectors];
+  bool formatted[flash::kNumStoreSectors];
+  for (int i = 0; i < flash::kNumStoreSectors; i++) {
+    formatted[i] = is_sector_formatted(i, &sequences[i]);
+  }
+
+  // Use the most recent formatted sector.
+  if (formatted[0] || formatted[1]) {
+    const int sector =
+        (formatted[1] && (!formatted[0] || sequences[1] > sequences[0])) ? 1
+                                                                         : 0;
+    vars.active_sector = sector;
+    vars.sequence = sequences[sector];
+    vars.end_offset = find_end_offset(sector);
+  } else {
+    // New store.
+    if (!vars.sectors->erase(0)) {
+      return false;
+    }
+    vars.sequence = 0;
+    start_sector(0);
+    if (!program_sector_header()) {
+      return false;
+    }
+  }
+
+  // The acquisition doesn't run yet, so this is a good time to erase.
+  vars.spare_erased = is_sector_erased(1 - vars.active_sector);
+  return erase_spare_sector();
+}
+
+bool read(uint16_t key, void* data, uint16_t size) {
+  if (!vars.sectors) {
+    return false;
+  }
+  Record record;
+  if (!find_last_record(vars.active_sector, key, &record) ||
+      record.size != size) {
+    return false;
+  }
+  const uint32_t* words = sector_words(vars.active_sector) + record.offset / 4;
+  memcpy(data, &words[1], size);
+  return true;
+}
+
+bool has_room(uint16_t size) {
+  return vars.sectors && vars.end_offset + 4 * (2 + value_words(size)) <=
+                             vars.sectors->sector_size();
+}
+
+bool is_spare_sector_erased() { return vars.spare_erased; }
+
+bool erase_spare_sector() {
+  if (!vars.sectors) {
+    return false;
+  }
+  if (!vars.spare_erased) {
+    vars.spare_erased = vars.sectors->erase(1 - vars.active_sector);
+  }
+  return vars.spare_erased;
+}
+
+bool write(uint16_t key, const void* data, uint16_t size) {
+  if (!vars.sectors || size == 0 || size > kMaxValueSize || key == 0xffff) {
+    return false;
+  }
+
+  // Avoid wearing the flash with unchanged values.
+  Record record;
+  if (find_last_record(vars.active_sector, key, &record) &&
+      record.size == size) {
+    const uint32_t* words =
+        sector_words(vars.active_sector) + record.offset / 4;
+    if (memcmp(&words[1], data, size) == 0) {
+      return true;
+    }
+  }
+
+  // Make room if needed.
+  if (vars.end_offset + 4 * (2 + value_words(size)) >
+          vars.sectors->sector_size() &&
+      !compact()) {
+    return false;
+  }
+
+  if (append_record(key, data, size)) {
+    return true;
+  }
+
+  // The end of the log may be damaged, e.g. by a power loss while
+  // programming. Retry once in the spare sector.
+  return compact() && append_record(key, data, size);
+}
+
+}  // namespace flash_store
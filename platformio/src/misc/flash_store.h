@@ -0,0 +1,65 @@
+// A small key/value store in internal flash.
+//
+// Values are appended as records to a log in one of two flash sectors.
+// Each record has a key, a size, the value and a CRC. Reading a key
+// returns the value of its last valid record. When the active sector
+// is full, the last value of each key is copied to the other sector,
+// which then becomes the active one. This spreads the erase cycles
+// over the two sectors, and a power loss at any point leaves a valid
+// copy of each value.
+//
+// Erasing a sector stalls the CPU, including the acquisition
+// interrupts, for 1-2 secs, so the store never erases on write. The
+// old sector of a compaction is erased later, by setup() or by
+// erase_spare_sector(), at a time when the stall loses no data.
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "hal/flash_sectors.h"
+
+namespace flash_store {
+
+// Keys of the values in the store. Keep values stable since they are
+// persistent.
+enum Key : uint16_t {
+  KEY_ACQUISITION_SETTINGS = 1,
+  KEY_LIFETIME_STATS = 2,
+};
+
+// Max size of a value in bytes.
+constexpr uint16_t kMaxValueSize = 256;
+
+// Call once on program initialization, before any other function
+// here and before the acquisition starts. May erase a sector. Returns
+// true if ok.
+extern bool setup(flash::FlashSectors* sectors);
+
+// True if the spare sector is erased, so the next compaction can
+// proceed. Fast.
+extern bool is_spare_sector_erased();
+
+// Erase the spare sector if not erased yet. Stalls the CPU for 1-2
+// secs if it erases, so call only when that loses no data, e.g. when
+// the motors are not energized. Returns true if the spare sector is
+// erased.
+extern bool erase_spare_sector();
+
+// True if a value of the given size can be written without a
+// compaction, which copies all the values and thus stalls the CPU
+// longer than a write. Fast.
+extern bool has_room(uint16_t size);
+
+// Read the last value of a key to data. Returns false if the key is
+// not found or if its value has a different size.
+extern bool read(uint16_t key, void* data, uint16_t size);
+
+// Write a value of a key. Writing the current value is a no op.
+// Takes a fraction of a millisecond, or a few milliseconds for the
+// rare compaction. Never erases, so fails if the active sector is full
+// and the spare sector was not erased yet, see erase_spare_sector().
+// Returns true if ok.
+extern bool write(uint16_t key, const void* data, uint16_t size);
+
+}  // namespace flash_store
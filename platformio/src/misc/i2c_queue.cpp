@@ -0,0 +1,103 @@
+#include "i2c_queue.h"
+
+#include "circular_buffer.h"
+
+namespace i2c_queue {
+
+// A transaction that does not end within this time is aborted, e.g.
+// when a device holds the bus.
+static constexpr uint32_t kTransferTimeoutMillis = 100;
+
+struct Vars {
+  i2c::I2cPort* port = nullptr;
+  // Pending transactions. The oldest one is in progress if is_active.
+  CircularBuffer<Transaction, kQueueSize> transactions;
+  bool is_active = false;
+  // Start time of the transaction in progress, or end time of the
+  // last transaction.
+  uint32_t start_millis = 0;
+  uint32_t end_millis = 0;
+  // The hold off time after the last transaction.
+  uint8_t hold_off_millis = 0;
+};
+
+static Vars vars;
+
+void setup(i2c::I2cPort* port) {
+  vars.port = port;
+  vars.transactions.clear();
+  vars.is_active = false;
+}
+
+// Start the oldest transaction if possible.
+static void start_next() {
+  if (vars.is_active || vars.transactions.is_empty() ||
+      millis() - vars.end_millis < vars.hold_off_millis) {
+    return;
+  }
+  const Transaction& transaction = *vars.transactions.get(0);
+  vars.is_active = true;
+  vars.start_millis = millis();
+  if (transaction.is_read) {
+    vars.port->start_read(transaction.device_address, transaction.reg,
+                          transaction.data, transaction.size);
+  } else {
+    vars.port->start_write(transaction.device_address, transaction.reg,
+                           transaction.data, transaction.size);
+  }
+  // If failed to start, the port status is an error and the callback
+  // is called by the next loop().
+}
+
+bool submit(const Transaction& transaction) {
+  if (!vars.port || vars.transactions.is_full()) {
+    return false;
+  }
+  *vars.transactions.insert() = transaction;
+  start_next();
+  return true;
+}
+
+void loop() {
+  if (!vars.port) {
+    return;
+  }
+
+  if (vars.is_active) {
+    i2c::TransferStatus status = vars.port->status();
+    if (status == i2c::TRANSFER_BUSY) {
+      if (millis() - vars.start_millis < kTransferTimeoutMillis) {
+        return;
+      }
+      vars.port->reset();
+      status = i2c::TRANSFER_ERROR;
+    }
+
+    // Pop before the callback, so it can submit new transactions.
+    const Transaction transaction = *vars.transactions.get(0);
+    vars.transactions.remove_oldest(1);
+    vars.is_active = false;
+    vars.end_millis = millis();
+    vars.hold_off_millis = transaction.hold_off_millis;
+    if (transaction.callback) {
+      transaction.callback(status == i2c::TRANSFER_OK, transaction.context);
+    }
+  }
+
+  start_next();
+}
+
+bool is_idle() { return vars.transactions.is_empty(); }
+
+bool wait_idle(uint32_t timeout_millis) {
+  const uint32_t start_millis = millis();
+  while (!is_idle()) {
+    if (millis() - start_millis >= timeout_millis) {
+      return false;
+    }
+    loop();
+  }
+  return true;
+}
+
+}  // namespace i2c_queue
@@ -0,0 +1,61 @@
+// A queue of non blocking I2C transactions.
+//
+// Transactions are submitted from the main loop and executed one at
+// a time by the interrupt driven I2C port. Their callbacks are called
+// from loop(), in the order of submission, so the main loop never
+// waits for the I2C bus.
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "hal/i2c_port.h"
+
+namespace i2c_queue {
+
+// Called from loop() when a transaction ends. ok is false if the
+// transaction failed.
+typedef void (*Callback)(bool ok, void* context);
+
+struct Transaction {
+  // 7 bit device address.
+  uint8_t device_address = 0;
+  // Address of the first register.
+  uint8_t reg = 0;
+  // True to read data, false to write it.
+  bool is_read = true;
+  // Time to wait after the transaction before starting the next one,
+  // e.g. for the internal write cycle of an EEPROM.
+  uint8_t hold_off_millis = 0;
+  // The data to write or the buffer to read to. Should stay valid
+  // until the callback.
+  uint8_t* data = nullptr;
+  uint16_t size = 0;
+  // Optional.
+  Callback callback = nullptr;
+  void* context = nullptr;
+};
+
+// Max number of pending transactions.
+constexpr uint16_t kQueueSize = 8;
+
+// Call once on program initialization, before any other function
+// here.
+extern void setup(i2c::I2cPort* port);
+
+// Add a transaction to the queue. Returns false if the queue is full,
+// in which case the callback is not called.
+extern bool submit(const Transaction& transaction);
+
+// Call frequently from the main loop. Starts the next transaction and
+// calls the callback of the transaction that ended, if any.
+extern void loop();
+
+// Returns true if there are no pending transactions.
+extern bool is_idle();
+
+// Run loop() until the queue is idle or timeout. For program
+// initialization, before the main loop starts. Returns true if idle.
+extern bool wait_idle(uint32_t timeout_millis);
+
+}  // namespace i2c_queue
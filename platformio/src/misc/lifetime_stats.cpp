@@ -0,0 +1,163 @@
+#include "lifetime_stats.h"
+
+#include "analyzer/acquisition.h"
+#include "elapsed.h"
+#include "flash_store.h"
+
+namespace lifetime_stats {
+
+static constexpr uint32_t kSampleIntervalMillis = 500;
+
+// A checkpoint programs ~10 flash words, which stalls the CPU,
+// including the acquisition interrupts, for ~0.2ms, less than a DMA
+// half buffer. A compaction of the flash store stalls it for a few
+// milliseconds, so while the motor steps, checkpoints are rare and
+// those that need a compaction are deferred until the motor didn't
+// step for kStepsIdleMillis.
+static constexpr uint32_t kSteppingCheckpointIntervalMillis = 30 * 60 * 1000;
+static constexpr uint32_t kStepsIdleMillis = 5000;
+
+// Checkpoint interval while the motor doesn't move, e.g. to save
+// the energized time.
+static constexpr uint32_t kCheckpointIntervalMillis = 10 * 60 * 1000;
+
+// Min time between checkpoints after moves. At ~40 bytes per record,
+// a checkpoint per minute fills a 128KB flash store sector in about
+// two days.
+static constexpr uint32_t kMinCheckpointIntervalMillis = 60 * 1000;
+
+// The acquisition counters at the last sample.
+struct Counters {
+  uint64_t total_full_steps = 0;
+  uint32_t quadrature_errors = 0;
+  uint32_t stall_events = 0;
+};
+
+struct Vars {
+  LifetimeStats stats;
+  // The value of the last checkpoint.
+  LifetimeStats checkpoint;
+  Counters last_counters;
+  uint64_t last_reset_tick_count = 0;
+  uint8_t last_axis = 0;
+  Elapsed elapsed_from_last_sample;
+  Elapsed elapsed_from_last_step;
+  Elapsed elapsed_from_last_checkpoint;
+};
+
+static Vars vars;
+
+static Counters sample_counters(const acquisition::State& state) {
+  const acquisition::StallEvents* stall_events =
+      acquisition::sample_stall_events();
+  Counters result;
+  result.total_full_steps = state.total_full_steps;
+  result.quadrature_errors = state.quadrature_errors;
+  for (int i = 0; i < acquisition::NUM_STALL_EVENT_TYPES; i++) {
+    result.stall_events += stall_events->counts[i];
+  }
+  return result;
+}
+
+// The increment of a counter since the last sample. A counter that
+// went down was reset in between.
+static inline uint64_t increment(uint64_t value, uint64_t last_value) {
+  return value >= last_value ? value - last_value : value;
+}
+
+static void sample() {
+  const uint32_t interval_millis =
+      vars.elapsed_from_last_sample.elapsed_millis();
+  vars.elapsed_from_last_sample.reset();
+
+  const acquisition::State& state = *acquisition::sample_state();
+  const Counters counters = sample_counters(state);
+  const uint8_t axis = acquisition::selected_axis();
+
+  if (axis != vars.last_axis) {
+    // The counters are of another axis. Start tracking it from here.
+    vars.last_axis = axis;
+  } else {
+    // After a data reset, all the counts are new.
+    const bool was_reset =
+        state.reset_tick_count != vars.last_reset_tick_count;
+    const Counters last = was_reset ? Counters() : vars.last_counters;
+    const uint64_t steps =
+        increment(counters.total_full_steps, last.total_full_steps);
+    vars.stats.steps += steps;
+    vars.stats.quadrature_errors +=
+        increment(counters.quadrature_errors, last.quadrature_errors);
+    vars.stats.stall_events +=
+        increment(counters.stall_events, last.stall_events);
+    if (steps > 0) {
+      vars.elapsed_from_last_step.reset();
+    }
+  }
+  if (state.is_energized) {
+    vars.stats.energized_millis += interval_millis;
+  }
+
+  vars.last_counters = counters;
+  vars.last_reset_tick_count = state.reset_tick_count;
+}
+
+static void checkpoint() {
+  vars.elapsed_from_last_checkpoint.reset();
+  if (memcmp(&vars.stats, &vars.checkpoint, sizeof(vars.stats)) == 0) {
+    return;
+  }
+  // On failure, retried on the next checkpoint.
+  if (flash_store::write(flash_store::KEY_LIFETIME_STATS, &vars.stats,
+                         sizeof(vars.stats))) {
+    vars.checkpoint = vars.stats;
+  }
+}
+
+void setup() {
+  if (!flash_store::read(flash_store::KEY_LIFETIME_STATS, &vars.stats,
+                         sizeof(vars.stats))) {
+    memset(&vars.stats, 0, sizeof(vars.stats));
+  }
+  vars.checkpoint = vars.stats;
+  vars.stats.power_ups++;
+
+  const acquisition::State& state = *acquisition::sample_state();
+  vars.last_counters = sample_counters(state);
+  vars.last_reset_tick_count = state.reset_tick_count;
+  vars.last_axis = acquisition::selected_axis();
+  vars.elapsed_from_last_sample.reset();
+  vars.elapsed_from_last_step.reset();
+
+  // Record the power up now, the acquisition doesn't run yet.
+  checkpoint();
+}
+
+void loop() {
+  if (vars.elapsed_from_last_sample.elapsed_millis() >=
+      kSampleIntervalMillis) {
+    sample();
+  }
+
+  const uint32_t millis_since_checkpoint =
+      vars.elapsed_from_last_checkpoint.elapsed_millis();
+
+  // A long job that never pauses is still saved periodically.
+  if (vars.elapsed_from_last_step.elapsed_millis() < kStepsIdleMillis) {
+    if (millis_since_checkpoint >= kSteppingCheckpointIntervalMillis &&
+        flash_store::has_room(sizeof(vars.stats))) {
+      checkpoint();
+    }
+    return;
+  }
+
+  // Shortly after a move, or periodically.
+  const bool has_moved = vars.stats.steps != vars.checkpoint.steps;
+  if (millis_since_checkpoint >= kCheckpointIntervalMillis ||
+      (has_moved && millis_since_checkpoint >= kMinCheckpointIntervalMillis)) {
+    checkpoint();
+  }
+}
+
+const LifetimeStats& stats() { return vars.stats; }
+
+}  // namespace lifetime_stats
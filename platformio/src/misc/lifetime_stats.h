@@ -0,0 +1,46 @@
+// Cumulative statistics of the selected axis over the lifetime of the
+// device, e.g. of a printer's motor, that are preserved across power
+// cycles.
+//
+// The stats are accumulated from periodic samples of the acquisition
+// counters, so they are not affected by data resets, and are
+// checkpointed to the flash store at a low rate. The flash store keeps
+// the previous checkpoint valid until the new one is completely
+// written, and checks each one with a CRC, so a power loss at any
+// point loses at most the changes since the last checkpoint.
+
+#pragma once
+
+#include <Arduino.h>
+
+namespace lifetime_stats {
+
+// The persistent value. Keep the layout stable, a value of a
+// different size is treated as missing.
+struct LifetimeStats {
+  // Full steps in either direction.
+  uint64_t steps;
+  // Time the coils were energized.
+  uint64_t energized_millis;
+  uint32_t quadrature_errors;
+  // Stall events of all types.
+  uint32_t stall_events;
+  // Number of setup() calls, including this one.
+  uint32_t power_ups;
+  uint32_t reserved;
+};
+
+// Call once on program initialization, after flash_store::setup() and
+// acquisition::setup().
+extern void setup();
+
+// Call frequently from the main loop. Takes a fraction of a
+// millisecond, or a few milliseconds for the rare flash store
+// compaction, see flash_store::write().
+extern void loop();
+
+// The current stats, including the changes that were not checkpointed
+// yet.
+extern const LifetimeStats& stats();
+
+}  // namespace lifetime_stats
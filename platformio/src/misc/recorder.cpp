@@ -0,0 +1,284 @@
+#include "recorder.h"
+
+#include <CRC32.h>
+
+#include "analyzer/acquisition.h"
+#include "elapsed.h"
+
+namespace recorder {
+
+static constexpr uint32_t kSnapshotIntervalMillis = 1000;
+
+// A block that is not full is written after this time, to limit the
+// data lost on power loss.
+static constexpr uint32_t kFlushIntervalMillis = 10000;
+
+static constexpr uint32_t kMaxPayloadSize = kBlockSize - kBlockHeaderSize;
+static constexpr uint8_t kSnapshotBodySize = 26;
+static constexpr uint8_t kMoveBodySize = 24;
+
+struct BlockHeader {
+  uint32_t sequence;
+  uint32_t session;
+};
+
+struct Vars {
+  block_device::BlockDevice* device = nullptr;
+  // Two blocks, one is filled while the other is written.
+  uint8_t blocks[2][kBlockSize];
+  // The block that is filled.
+  int fill_index = 0;
+  uint16_t payload_size = 0;
+  // True if the other block is written, or should be retried.
+  bool is_writing = false;
+  uint32_t write_block_number = 0;
+  // Sequence number of the block that is filled.
+  uint32_t sequence = 0;
+  uint32_t session = 0;
+  // Number of moves recorded so far, see MoveRecords::total_moves.
+  uint32_t moves_recorded = 0;
+  Elapsed elapsed_from_last_snapshot;
+  Elapsed elapsed_from_block_start;
+  Stats stats;
+};
+
+static Vars vars;
+
+static inline void put_u16(uint8_t* p, uint16_t v) { memcpy(p, &v, 2); }
+static inline void put_u32(uint8_t* p, uint32_t v) { memcpy(p, &v, 4); }
+static inline void put_i64(uint8_t* p, int64_t v) { memcpy(p, &v, 8); }
+static inline uint16_t get_u16(const uint8_t* p) {
+  uint16_t v;
+  memcpy(&v, p, 2);
+  return v;
+}
+static inline uint32_t get_u32(const uint8_t* p) {
+  uint32_t v;
+  memcpy(&v, p, 4);
+  return v;
+}
+
+// CRC of a block, excluding the CRC field and the unused tail.
+static uint32_t block_crc(const uint8_t* block, uint16_t payload_size) {
+  CRC32 crc;
+  crc.update(block, 16);
+  crc.update(block + kBlockHeaderSize, payload_size);
+  return crc.finalize();
+}
+
+// Read a block and return its header if it is valid.
+static bool read_block_header(uint32_t block_number, BlockHeader* header) {
+  uint8_t* block = vars.blocks[0];
+  if (!vars.device->read(block_number, block) ||
+      get_u32(block) != kBlockMagic) {
+    return false;
+  }
+  const uint16_t payload_size = get_u16(block + 12);
+  if (payload_size > kMaxPayloadSize ||
+      get_u32(block + 16) != block_crc(block, payload_size)) {
+    return false;
+  }
+  header->sequence = get_u32(block + 4);
+  header->session = get_u32(block + 8);
+  return header->sequence % vars.device->num_blocks() == block_number;
+}
+
+// Add a record to the block that is filled. Returns false if there
+// is no space.
+static bool add_record(RecordType type, const uint8_t* body, uint8_t size) {
+  if (vars.payload_size + 2u + size > kMaxPayloadSize) {
+    return false;
+  }
+  uint8_t* p = vars.blocks[vars.fill_index] + kBlockHeaderSize +
+               vars.payload_size;
+  p[0] = type;
+  p[1] = size;
+  memcpy(p + 2, body, size);
+  vars.payload_size += 2 + size;
+  return true;
+}
+
+// Forward declaration.
+static bool write_block();
+
+static void add_snapshot() {
+  const acquisition::State* state = acquisition::sample_state();
+  const uint32_t total_moves = acquisition::sample_moves()->total_moves;
+  uint8_t body[kSnapshotBodySize];
+  put_u32(body, (uint32_t)acquisition::ticks_to_millis(state->tick_count));
+  put_i64(body + 4, state->full_steps);
+  put_u32(body + 12, state->quadrature_errors);
+  put_u32(body + 16, state->non_energized_count);
+  put_u32(body + 20, total_moves);
+  body[24] = state->is_energized ? 1 : 0;
+  body[25] = 0;
+  vars.elapsed_from_last_snapshot.reset();
+  if (add_record(RECORD_SNAPSHOT, body, sizeof(body))) {
+    return;
+  }
+  // The block is full. The next one starts with a snapshot.
+  if (!write_block()) {
+    vars.stats.records_dropped++;
+  }
+}
+
+// Start filling a new block, with a snapshot as a checkpoint.
+static void start_block() {
+  vars.payload_size = 0;
+  vars.elapsed_from_block_start.reset();
+  add_snapshot();
+}
+
+// Start writing the block that is filled and start filling the other
+// one. Returns false if the other one is still written.
+static bool write_block() {
+  if (vars.is_writing) {
+    return false;
+  }
+  uint8_t* block = vars.blocks[vars.fill_index];
+  put_u32(block, kBlockMagic);
+  put_u32(block + 4, vars.sequence);
+  put_u32(block + 8, vars.session);
+  put_u16(block + 12, vars.payload_size);
+  put_u16(block + 14, 0);
+  put_u32(block + 16, block_crc(block, vars.payload_size));
+  // Zero the unused tail, for cleaner images.
+  memset(block + kBlockHeaderSize + vars.payload_size, 0,
+         kMaxPayloadSize - vars.payload_size);
+
+  vars.write_block_number = vars.sequence % vars.device->num_blocks();
+  vars.device->start_write(vars.write_block_number, block);
+  vars.is_writing = true;
+  vars.sequence++;
+  vars.fill_index = 1 - vars.fill_index;
+  start_block();
+  return true;
+}
+
+// Add a record, writing the block that is filled if it's full.
+static void add_record_or_write(RecordType type, const uint8_t* body,
+                                uint8_t size) {
+  if (add_record(type, body, size)) {
+    return;
+  }
+  if (write_block() && add_record(type, body, size)) {
+    return;
+  }
+  vars.stats.records_dropped++;
+}
+
+// Add the moves that were completed since the last call. Moves that
+// were dropped from the acquisition buffer are skipped.
+static void add_new_moves() {
+  const acquisition::MoveRecords* moves = acquisition::sample_moves();
+
+  // Handle data reset.
+  if (moves->total_moves < vars.moves_recorded) {
+    vars.moves_recorded = 0;
+  }
+
+  const uint32_t new_moves = moves->total_moves - vars.moves_recorded;
+  const uint16_t size = moves->items.size();
+  const uint16_t first = new_moves < size ? size - new_moves : 0;
+  for (uint16_t i = first; i < size; i++) {
+    const acquisition::MoveRecord& move = *moves->items.get(i);
+    const uint32_t steps = abs(move.steps);
+    const int avg_peak_milliamps = acquisition::adc_value_to_milliamps(
+        steps ? move.total_step_peak_currents / steps : 0);
+    uint8_t body[kMoveBodySize];
+    put_u32(body, moves->total_moves - size + i + 1);
+    put_u32(body + 4, (uint32_t)acquisition::ticks_to_millis(move.start_tick));
+    put_u32(body + 8,
+            (uint32_t)acquisition::ticks_to_millis(move.duration_ticks));
+    put_u32(body + 12, (uint32_t)move.steps);
+    put_u32(body + 16, acquisition::move_peak_steps_per_sec(move));
+    put_u16(body + 20, (uint16_t)avg_peak_milliamps);
+    put_u16(body + 22, move.quadrature_errors);
+    add_record_or_write(RECORD_MOVE, body, sizeof(body));
+  }
+  vars.moves_recorded = moves->total_moves;
+}
+
+bool setup(block_device::BlockDevice* device) {
+  vars.device = nullptr;
+  if (device->block_size() != kBlockSize || device->num_blocks() < 2) {
+    return false;
+  }
+  vars.device = device;
+  const uint32_t n = device->num_blocks();
+
+  // Find the last block of the log. The blocks [0, last] are of the
+  // current lap, with increasing sequence numbers, and the blocks
+  // after them, if any, are of the previous lap.
+  BlockHeader first;
+  BlockHeader last;
+  bool found = false;
+  if (read_block_header(0, &first)) {
+    uint32_t lo = 0;
+    uint32_t hi = n;
+    while (hi - lo > 1) {
+      const uint32_t mid = lo + (hi - lo) / 2;
+      BlockHeader header;
+      if (read_block_header(mid, &header) &&
+          header.sequence >= first.sequence) {
+        lo = mid;
+      } else {
+        hi = mid;
+      }
+    }
+    found = read_block_header(lo, &last);
+  } else {
+    // Either a new log, or the last session stopped while writing
+    // the first block of a lap.
+    found = read_block_header(n - 1, &last);
+  }
+
+  vars.sequence = found ? last.sequence + 1 : 0;
+  vars.session = found ? last.session + 1 : 0;
+  vars.fill_index = 0;
+  vars.is_writing = false;
+  vars.moves_recorded = acquisition::sample_moves()->total_moves;
+  vars.stats = Stats();
+  start_block();
+  return true;
+}
+
+void loop() {
+  if (!vars.device) {
+    return;
+  }
+
+  // Track the block that is written.
+  if (vars.is_writing) {
+    switch (vars.device->status()) {
+      case block_device::WRITE_BUSY:
+        break;
+      case block_device::WRITE_OK:
+        vars.is_writing = false;
+        vars.stats.blocks_written++;
+        break;
+      case block_device::WRITE_ERROR:
+        // Retry, so the log has no gaps.
+        vars.stats.write_errors++;
+        vars.device->start_write(vars.write_block_number,
+                                 vars.blocks[1 - vars.fill_index]);
+        break;
+    }
+  }
+
+  add_new_moves();
+
+  if (vars.elapsed_from_last_snapshot.elapsed_millis() >=
+      kSnapshotIntervalMillis) {
+    add_snapshot();
+  }
+
+  // Ignored if the other block is still written.
+  if (vars.elapsed_from_block_start.elapsed_millis() >= kFlushIntervalMillis) {
+    write_block();
+  }
+}
+
+const Stats& stats() { return vars.stats; }
+
+}  // namespace recorder
@@ -0,0 +1,80 @@
+// A recorder of the completed moves and of periodic snapshots of the
+// state, to a block device such as an SD card.
+//
+// The device is a circular log of fixed size blocks, each with a
+// header, a CRC and whole records. Blocks are written in sequence,
+// and a block is never rewritten on the same lap, so a power loss
+// loses at most the block in progress. Each block starts with a
+// snapshot, a checkpoint that allows to decode it on its own. On
+// setup, the end of the log is found with a binary search over the
+// block sequence numbers and the new session continues from there.
+// tools/recorder_reader.py reads an image of the device.
+//
+// The reference board has no block device, all the MCU pins are in
+// use, so the recorder is for boards that add one, e.g. an SD card
+// on a SPI port with DMA.
+//
+// Block layout, little endian:
+//   0  uint32 magic, kBlockMagic.
+//   4  uint32 sequence number. The block index is sequence %
+//      num_blocks.
+//   8  uint32 session number, incremented on each setup().
+//   12 uint16 payload size in bytes.
+//   14 uint16 reserved, zero.
+//   16 uint32 CRC32 of bytes [0, 16) and of the payload.
+//   20 payload, records of a uint8 type, a uint8 body size and the
+//      body. Readers should skip records of unknown types.
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "block_device.h"
+
+namespace recorder {
+
+// Block size in bytes. The device's block size should match.
+constexpr uint32_t kBlockSize = 512;
+constexpr uint32_t kBlockHeaderSize = 20;
+constexpr uint32_t kBlockMagic = 0x31444352;  // "RCD1"
+
+enum RecordType : uint8_t {
+  // A snapshot of the state, 26 bytes body:
+  //   0  uint32 millis since the program start.
+  //   4  int64  full steps.
+  //   12 uint32 quadrature errors.
+  //   16 uint32 non energized count.
+  //   20 uint32 total moves.
+  //   24 uint8  1 if energized, else 0.
+  //   25 uint8  reserved, zero.
+  RECORD_SNAPSHOT = 1,
+  // A completed move, 24 bytes body:
+  //   0  uint32 move number, see MoveRecords::total_moves.
+  //   4  uint32 start, in millis since the program start.
+  //   8  uint32 duration in millis.
+  //   12 int32  signed distance in full steps.
+  //   16 uint32 peak speed in steps/sec.
+  //   20 uint16 average peak current in milliamps.
+  //   22 uint16 quadrature errors.
+  RECORD_MOVE = 2,
+};
+
+struct Stats {
+  uint32_t blocks_written = 0;
+  // Records that were dropped since the device was too slow.
+  uint32_t records_dropped = 0;
+  // Failed block writes. Failed writes are retried.
+  uint32_t write_errors = 0;
+};
+
+// Call once on program initialization, after acquisition::setup().
+// Returns false if the device is not usable, in which case loop() does
+// nothing.
+extern bool setup(block_device::BlockDevice* device);
+
+// Call frequently from the main loop. Never waits for the device.
+extern void loop();
+
+extern const Stats& stats();
+
+}  // namespace recorder
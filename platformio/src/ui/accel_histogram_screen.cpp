@@ -0,0 +1,76 @@
+#include "accel_histogram_screen.h"
+
+#include "analyzer/accel_profiler.h"
+#include "ui.h"
+
+static constexpr uint32_t kUpdateIntervalMillis = 200;
+
+static const ui::ChartAxisConfigs kAxisConfigsNormal{
+    .y_range = {.min = 0, .max = 100},
+    .x = {.labels = "0\n10k\n20k\n30k\n40k", .num_ticks = 5, .dividers = 3},
+    .y = {.labels = "100%\n75%\n50%\n25%\n0", .num_ticks = 5, .dividers = 3}};
+
+AccelHistogramScreen::AccelHistogramScreen(){};
+
+void AccelHistogramScreen::setup(uint8_t screen_num) {
+  ui::create_screen(&screen_);
+  ui::create_page_elements(screen_, "TIME BY ACCELERATION", screen_num,
+                           nullptr);
+  ui::create_histogram(screen_, accel_profiler::kNumAccelBuckets,
+                       kAxisConfigsNormal, ui_events::UI_EVENT_NONE,
+                       &histogram_);
+  // Max values, between the reset and the navigation buttons.
+  ui::create_label(screen_, 235, 60, ui::kBottomButtonsPosY + 2, "",
+                   ui::kFontSmallText, LV_LABEL_ALIGN_LEFT, LV_COLOR_SILVER,
+                   &max_values_field_);
+};
+
+void AccelHistogramScreen::on_load() {
+  // Force display update on first loop.
+  display_update_elapsed_.set(kUpdateIntervalMillis + 1);
+};
+
+void AccelHistogramScreen::on_unload(){};
+
+// Acceleration reset is done by the common event handler.
+void AccelHistogramScreen::on_event(ui_events::UiEventId ui_event_id) {}
+
+void AccelHistogramScreen::loop() {
+  // We update at a fixed rate.
+  if (display_update_elapsed_.elapsed_millis() < kUpdateIntervalMillis) {
+    return;
+  }
+  display_update_elapsed_.reset();
+
+  const accel_profiler::Stats& stats = accel_profiler::stats();
+
+  // Find max ticks in a bucket.
+  uint64_t max_ticks = 0;
+  for (int i = 0; i < accel_profiler::kNumAccelBuckets; i++) {
+    if (stats.accel_bucket_ticks[i] > max_ticks) {
+      max_ticks = stats.accel_bucket_ticks[i];
+    }
+  }
+
+  // Update all the histogram points.
+  for (int i = 0; i < accel_profiler::kNumAccelBuckets; i++) {
+    const uint64_t ticks = stats.accel_bucket_ticks[i];
+    // Scale the value to [0, 100];
+    uint16_t val = max_ticks > 0 ? ((ticks * 100) / max_ticks) : 0;
+
+    // Indicate non zero buckets. Even if it's a tiny fraction.
+    if (ticks > 0 && val == 0) {
+      val = 1;
+    }
+
+    histogram_.lv_series->points[i] = val;
+  }
+
+  lv_chart_refresh(histogram_.lv_chart);
+
+  // In steps/sec^2 and steps/sec^3.
+  lv_label_set_text_fmt(max_values_field_.lv_label,
+                        "MAX ACCEL %lu  DECEL %lu\nMAX JERK %lu  SEGMENTS %lu",
+                        (uint32_t)stats.max_accel, (uint32_t)stats.max_decel,
+                        (uint32_t)stats.max_jerk, stats.segments);
+}
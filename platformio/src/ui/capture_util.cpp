@@ -4,14 +4,58 @@ namespace capture_util {
 
 static constexpr uint32_t kUpdateIntervalMillis = 500;
 
-static constexpr uint16_t kCaptureDividerNormal = 10;
+// Time per division of 0.5ms to 1s. The slower ones detect the
+// peaks of each interval, otherwise short spikes are lost with the
+// dropped samples. From 100ms per division, a full capture takes
+// seconds and the oscilloscope rolls instead.
+static const Timebase kTimebases[] = {
+    {.divider = 1,
+     .mode = acquisition::CAPTURE_MODE_SAMPLE,
+     .roll = false},
+    {.divider = 2,
+     .mode = acquisition::CAPTURE_MODE_SAMPLE,
+     .roll = false},
+    {.divider = 4,
+     .mode = acquisition::CAPTURE_MODE_SAMPLE,
+     .roll = false},
+    {.divider = 10,
+     .mode = acquisition::CAPTURE_MODE_SAMPLE,
+     .roll = false},
+    {.divider = 20,
+     .mode = acquisition::CAPTURE_MODE_SAMPLE,
+     .roll = false},
+    {.divider = 40,
+     .mode = acquisition::CAPTURE_MODE_SAMPLE,
+     .roll = false},
+    {.divider = 100,
+     .mode = acquisition::CAPTURE_MODE_PEAK_DETECT,
+     .roll = false},
+    {.divider = 200,
+     .mode = acquisition::CAPTURE_MODE_PEAK_DETECT,
+     .roll = true},
+    {.divider = 400,
+     .mode = acquisition::CAPTURE_MODE_PEAK_DETECT,
+     .roll = true},
+    {.divider = 1000,
+     .mode = acquisition::CAPTURE_MODE_PEAK_DETECT,
+     .roll = true},
+    {.divider = 2000,
+     .mode = acquisition::CAPTURE_MODE_PEAK_DETECT,
+     .roll = true},
+};
+
+static constexpr int kNumTimebases = sizeof(kTimebases) / sizeof(kTimebases[0]);
 
-static constexpr uint16_t kCaptureDividerAlternative = 50;
+// 5ms per division.
+static constexpr int kDefaultTimebaseIndex = 3;
 
 struct Vars {
   bool has_data = false;
   bool capture_in_progress = false;
-  bool alternative_scale = false;
+  // True if we started the acquisition roll mode with the current
+  // timebase.
+  bool roll_in_progress = false;
+  int timebase_index = kDefaultTimebaseIndex;
   // Ignored in has_data is false.
   acquisition::CaptureBuffer capture_buffer;
   bool capture_enabled = true;
@@ -20,13 +64,75 @@ struct Vars {
 
 static Vars vars;
 
-void toggle_scale() {
-  vars.alternative_scale = !vars.alternative_scale;
+static bool is_sample_timebase(const Timebase& timebase) {
+  return timebase.mode == acquisition::CAPTURE_MODE_SAMPLE && !timebase.roll;
+}
+
+static void set_timebase_index(int timebase_index) {
+  vars.timebase_index = timebase_index;
   vars.has_data = false;
+  vars.roll_in_progress = false;
   vars.capture_enabled = true;
 }
 
-bool alternative_scale() { return vars.alternative_scale; }
+void next_timebase(bool sample_only) {
+  int i = vars.timebase_index;
+  do {
+    i = (i + 1) % kNumTimebases;
+  } while (sample_only && !is_sample_timebase(kTimebases[i]));
+  set_timebase_index(i);
+}
+
+void select_sample_timebase() {
+  if (is_sample_timebase(timebase())) {
+    return;
+  }
+  int i = kNumTimebases - 1;
+  while (!is_sample_timebase(kTimebases[i])) {
+    i--;
+  }
+  set_timebase_index(i);
+}
+
+const Timebase& timebase() { return kTimebases[vars.timebase_index]; }
+
+void format_time(uint32_t usecs, char* bfr, int bfr_size) {
+  // Select the unit, and the value in tenths of it.
+  const char* unit;
+  unsigned long tenths;
+  if (usecs >= 1000000) {
+    unit = "s";
+    tenths = usecs / 100000;
+  } else if (usecs >= 1000) {
+    unit = "ms";
+    tenths = usecs / 100;
+  } else if (usecs > 0) {
+    unit = "us";
+    tenths = usecs * 10;
+  } else {
+    snprintf(bfr, bfr_size, "0");
+    return;
+  }
+  if (tenths % 10) {
+    snprintf(bfr, bfr_size, "%lu.%lu%s", tenths / 10, tenths % 10, unit);
+  } else {
+    snprintf(bfr, bfr_size, "%lu%s", tenths / 10, unit);
+  }
+}
+
+void format_time_axis_labels(uint32_t usecs_per_division, int num_divisions,
+                             char* bfr, int bfr_size) {
+  // Stops when the buffer is full, leaving the labels truncated.
+  bfr[0] = 0;
+  int n = 0;
+  for (int i = 0; i <= num_divisions && n < bfr_size - 1; i++) {
+    if (i > 0) {
+      bfr[n++] = '\n';
+    }
+    format_time(i * usecs_per_division, bfr + n, bfr_size - n);
+    n += strlen(bfr + n);
+  }
+}
 
 const acquisition::CaptureBuffer* capture_buffer() {
   return &vars.capture_buffer;
@@ -40,6 +146,7 @@ bool has_data() { return vars.has_data; }
 
 void clear_data() {
   vars.has_data = false;
+  vars.roll_in_progress = false;
   vars.capture_enabled = true;
 }
 
@@ -56,10 +163,9 @@ bool maybe_update_capture_data() {
       // This will prevent the timer from overflowing, without affecting
       // the logic here.
       vars.elapsed_from_last_update.set(kUpdateIntervalMillis);
-      acquisition::start_capture(vars.alternative_scale
-                                     ? kCaptureDividerAlternative
-                                     : kCaptureDividerNormal);
+      acquisition::start_capture(timebase().divider, timebase().mode);
       vars.capture_in_progress = true;
+      vars.roll_in_progress = false;
     }
     return false;
   }
@@ -86,6 +192,13 @@ bool maybe_update_capture_data() {
     return false;
   }
 
+  // Ignore captures that were started by other screens, e.g. the
+  // spectrum screen, or before the time base was changed.
+  if (acq_capture_buffer->divider != timebase().divider ||
+      acq_capture_buffer->mode != timebase().mode) {
+    return false;
+  }
+
   // Here we are comitted to update with the new capture.
   vars.capture_buffer = *acq_capture_buffer;
   vars.has_data = true;
@@ -93,6 +206,26 @@ bool maybe_update_capture_data() {
   return true;
 }
 
+uint16_t consume_roll_items(acquisition::CaptureItem* bfr,
+                            uint16_t max_count) {
+  // Restarted when resumed, to skip the items of the pause.
+  if (!vars.capture_enabled) {
+    vars.roll_in_progress = false;
+    return 0;
+  }
+
+  // Rolling may have been stopped by another screen, e.g. the
+  // spectrum screen.
+  if (!vars.roll_in_progress || !acquisition::is_rolling()) {
+    acquisition::start_roll(timebase().divider, timebase().mode);
+    vars.roll_in_progress = true;
+    vars.capture_in_progress = false;
+    return 0;
+  }
+
+  return acquisition::consume_roll_items(bfr, max_count);
+}
+
 void CaptureControls::update_display_from_state() {
   if (vars.capture_enabled) {
    // lv_obj_set_state(run_button.lv_button, LV_STATE_CHECKED);
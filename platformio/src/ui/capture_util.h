@@ -27,10 +27,51 @@ struct CaptureControls {
 
 };
 
-  // Toggle between normal (20ms) and alternative (100ms) scale.
-  extern void toggle_scale();
-
-  extern bool alternative_scale() ;
+  // Number of horizontal divisions of the time domain capture
+  // charts. Each division spans kItemsPerDivision capture items at
+  // the native zoom.
+  constexpr int kNumDivisions = 4;
+  constexpr int kItemsPerDivision =
+      acquisition::kCaptureDisplaySize / kNumDivisions;
+
+  // A selectable capture time base.
+  struct Timebase {
+    uint16_t divider;
+    acquisition::CaptureMode mode;
+    // If true, the oscilloscope streams the signals with
+    // consume_roll_items() instead of waiting for full captures.
+    bool roll;
+
+    // Time of a chart division, in usecs.
+    uint32_t usecs_per_division() const {
+      return (uint32_t)divider * kItemsPerDivision *
+             acquisition::kUsecsPerTick;
+    }
+  };
+
+  // Select the next slower timebase, wrapping around to the fastest
+  // one. If sample_only, skips the timebases that are not of
+  // CAPTURE_MODE_SAMPLE or that roll, for screens that need the
+  // individual samples, e.g. the phase patterns. Clears the captured
+  // data.
+  extern void next_timebase(bool sample_only = false);
+
+  // If the current timebase is not one of the sample_only ones of
+  // next_timebase(), select the slowest one that is. Clears the
+  // captured data if changed.
+  extern void select_sample_timebase();
+
+  extern const Timebase& timebase();
+
+  // Format a time such as "0", "500us", "1.5ms" or "2s". Time values
+  // are rounded down to a tenth of their unit.
+  extern void format_time(uint32_t usecs, char* bfr, int bfr_size);
+
+  // Format the newline separated labels of a time axis with the given
+  // number of divisions, starting at "0".
+  extern void format_time_axis_labels(uint32_t usecs_per_division,
+                                      int num_divisions, char* bfr,
+                                      int bfr_size);
 
   extern void clear_data();
 
@@ -42,6 +83,13 @@ struct CaptureControls {
   // If has_data() is true, this contains the data.
   extern const acquisition::CaptureBuffer* capture_buffer();
 
+  // Move up to max_count new items of the roll mode to bfr and return
+  // the number of items moved. Starts the roll mode with the current
+  // timebase if needed, stopping any capture in progress. Returns zero
+  // when capture is disabled. See acquisition::start_roll().
+  extern uint16_t consume_roll_items(acquisition::CaptureItem* bfr,
+                                     uint16_t max_count);
+
   // Given capture controls, update capture enabled/disabled 
   // if needed.
   bool maybe_update_state_from_controls(const CaptureControls& capture_controls);
@@ -18,8 +18,11 @@ void CurrentHistogramScreen::setup(uint8_t screen_num) {
   ui::create_screen(&screen_);
   ui::create_page_elements(screen_, "CURRENT BY STEPS/SEC", screen_num,
                            nullptr);
-  ui::create_histogram(screen_, acquisition::kNumHistogramBuckets,
-                       kAxisConfigsNormal, &histogram_);
+  ui::create_histogram(screen_, histogram::kLinearNumBuckets,
+                       kAxisConfigsNormal, ui_events::UI_EVENT_SCALE,
+                       &histogram_);
+  zoom_.setup(kAxisConfigsNormal, &histogram_);
+  histogram_.set_error_bars(error_bars_);
 };
 
 void CurrentHistogramScreen::on_load() {
@@ -34,6 +37,13 @@ void CurrentHistogramScreen::on_event(ui_events::UiEventId ui_event_id) {
     case ui_events::UI_EVENT_RESET:
       acquisition::reset_state();
       break;
+
+    case ui_events::UI_EVENT_SCALE:
+      zoom_.next_zoom();
+      // Force display update on next loop.
+      display_update_elapsed_.set(kUpdateIntervalMillis + 1);
+      break;
+
     default:
       break;
   }
@@ -48,11 +58,16 @@ void CurrentHistogramScreen::loop() {
 
   // Sample acquisition state and update display.
   const acquisition::State* state = acquisition::sample_state();
+  zoom_.update(*state);
+  const int first_bucket = zoom_.first_bucket();
+  const int num_buckets = zoom_.num_buckets();
 
   // Update all the histogram points.
-  for (int i = 0; i < acquisition::kNumHistogramBuckets; i++) {
-    uint64_t total_current_ticks = state->buckets[i].total_step_peak_currents;
-    uint64_t steps = state->buckets[i].total_steps;
+  for (int i = 0; i < num_buckets; i++) {
+    acquisition::HistogramBucket bucket;
+    acquisition::sample_histogram_bucket(first_bucket + i, &bucket);
+    uint64_t total_current_ticks = bucket.total_step_peak_currents;
+    uint64_t steps = bucket.total_steps;
     // Scale the value to [0, 100];
     uint16_t val =
         steps > 0
@@ -67,6 +82,28 @@ void CurrentHistogramScreen::loop() {
     }
 
     histogram_.lv_series->points[i] = val;
+
+    // Spread of the step peak currents.
+    ui::ErrorBar& error_bar = error_bars_[i];
+    if (steps > 0) {
+      error_bar.min =
+          acquisition::adc_value_to_milliamps(bucket.min_step_peak_current);
+      error_bar.low = acquisition::adc_value_to_milliamps(
+          acquisition::bucket_peak_current_percentile(bucket,
+                                                      acquisition::PEAK_P5));
+      error_bar.mid = acquisition::adc_value_to_milliamps(
+          acquisition::bucket_peak_current_percentile(bucket,
+                                                      acquisition::PEAK_P50));
+      error_bar.high = acquisition::adc_value_to_milliamps(
+          acquisition::bucket_peak_current_percentile(bucket,
+                                                      acquisition::PEAK_P95));
+      error_bar.max =
+          acquisition::adc_value_to_milliamps(bucket.max_step_peak_current);
+    } else {
+      // Not drawn.
+      error_bar.min = 1;
+      error_bar.max = 0;
+    }
   }
 
   lv_chart_refresh(histogram_.lv_chart);
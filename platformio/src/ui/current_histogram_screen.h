@@ -1,5 +1,7 @@
 #pragma once
 
+#include "analyzer/acquisition.h"
+#include "histogram_util.h"
 #include "misc/elapsed.h"
 #include "screen_manager.h"
 
@@ -15,4 +17,8 @@ class CurrentHistogramScreen : public screen_manager::Screen {
  private:
   Elapsed display_update_elapsed_;
   ui::Histogram histogram_;
+  histogram_util::HistogramZoom zoom_;
+  // Per displayed column, the min, P5, P50, P95 and max step peak
+  // currents.
+  ui::ErrorBar error_bars_[acquisition::kNumHistogramBuckets];
 };
\ No newline at end of file
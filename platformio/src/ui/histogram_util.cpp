@@ -0,0 +1,90 @@
+#include "histogram_util.h"
+
+namespace histogram_util {
+
+// Zoom level 0 shows all the buckets, the other levels show
+// overlapping windows of half the buckets each.
+static constexpr uint8_t kNumZoomLevels = 4;
+
+// Number of labels on the x axis.
+static constexpr uint8_t kNumXLabels = 5;
+
+// Format a steps/sec value in a short form. E.g. 850, 1.2k, 15k.
+static int format_speed(char* bfr, int size, uint32_t steps_per_sec) {
+  if (steps_per_sec < 1000) {
+    return snprintf(bfr, size, "%lu", steps_per_sec);
+  }
+  if (steps_per_sec < 10000) {
+    return snprintf(bfr, size, "%lu.%luk", steps_per_sec / 1000,
+                    (steps_per_sec % 1000) / 100);
+  }
+  return snprintf(bfr, size, "%luk", steps_per_sec / 1000);
+}
+
+void HistogramZoom::setup(const ui::ChartAxisConfigs& axis_configs,
+                          ui::Histogram* histogram) {
+  axis_configs_ = &axis_configs;
+  histogram_ = histogram;
+  x_labels_[0] = 0;
+}
+
+void HistogramZoom::next_zoom() {
+  // The linear scale has a single zoom level.
+  if (displayed_scale_ == histogram::SCALE_LINEAR) {
+    return;
+  }
+  if (++zoom_level_ >= kNumZoomLevels) {
+    zoom_level_ = 0;
+  }
+}
+
+void HistogramZoom::update(const acquisition::State& state) {
+  const histogram::Scale scale = state.histogram_scale;
+  if (scale == displayed_scale_ && zoom_level_ == displayed_zoom_level_) {
+    return;
+  }
+  // Linear scale has a single zoom level. A later switch to the log
+  // scale starts from the full range.
+  if (scale == histogram::SCALE_LINEAR) {
+    zoom_level_ = 0;
+  }
+  displayed_scale_ = scale;
+  displayed_zoom_level_ = zoom_level_;
+
+  if (scale == histogram::SCALE_LINEAR) {
+    first_bucket_ = 0;
+    num_buckets_ = histogram::kLinearNumBuckets;
+    histogram_->set_num_columns(num_buckets_);
+    histogram_->set_scale(*axis_configs_);
+    return;
+  }
+
+  if (zoom_level_ == 0) {
+    first_bucket_ = 0;
+    num_buckets_ = histogram::kLogNumBuckets;
+  } else {
+    num_buckets_ = histogram::kLogNumBuckets / 2;
+    first_bucket_ = (zoom_level_ - 1) * (histogram::kLogNumBuckets / 4);
+  }
+
+  // Generate the x labels.
+  char* p = x_labels_;
+  char* const end = x_labels_ + sizeof(x_labels_);
+  for (int i = 0; i < kNumXLabels; i++) {
+    const int bucket =
+        first_bucket_ + (i * (num_buckets_ - 1)) / (kNumXLabels - 1);
+    if (i > 0 && p < end - 1) {
+      *p++ = '\n';
+    }
+    p += format_speed(p, end - p,
+                      histogram::bucket_min_steps_per_sec(scale, bucket));
+  }
+
+  ui::ChartAxisConfigs axis_configs = *axis_configs_;
+  axis_configs.x.labels = x_labels_;
+  axis_configs.x.num_ticks = kNumXLabels;
+  histogram_->set_num_columns(num_buckets_);
+  histogram_->set_scale(axis_configs);
+}
+
+}  // namespace histogram_util
@@ -0,0 +1,49 @@
+// Provides common functionality to the step speed histogram screens.
+
+#pragma once
+
+#include "analyzer/acquisition.h"
+#include "ui.h"
+
+namespace histogram_util {
+
+// Tracks the scale and zoom of a step speed histogram and adjusts
+// the histogram columns and x axis labels accordingly. With log
+// scale, the full range is shown first and additional zoom levels
+// show half of the range at a time.
+class HistogramZoom {
+ public:
+  // Call once on screen setup, after the histogram was created.
+  // 'axis_configs' are the axis configs for the linear scale.
+  // The log scale uses the same y axis with generated x labels.
+  void setup(const ui::ChartAxisConfigs& axis_configs,
+             ui::Histogram* histogram);
+
+  // Cycle to the next zoom level. Ignored with linear scale, which
+  // also resets the level to the full range.
+  void next_zoom();
+
+  // Adjust the histogram to the scale of the given state and
+  // to the current zoom level. Call before updating the histogram
+  // points.
+  void update(const acquisition::State& state);
+
+  // The range of buckets to display. Valid after update().
+  int first_bucket() const { return first_bucket_; }
+  int num_buckets() const { return num_buckets_; }
+
+ private:
+  const ui::ChartAxisConfigs* axis_configs_ = nullptr;
+  ui::Histogram* histogram_ = nullptr;
+  // Zoom level, 0 is the full range.
+  uint8_t zoom_level_ = 0;
+  // Invalid values to force an initial update.
+  int8_t displayed_scale_ = -1;
+  int8_t displayed_zoom_level_ = -1;
+  int first_bucket_ = 0;
+  int num_buckets_ = 0;
+  // Generated x labels. LVGL keeps a reference to it.
+  char x_labels_[48];
+};
+
+}  // namespace histogram_util
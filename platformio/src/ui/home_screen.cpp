@@ -1,6 +1,7 @@
 #include "home_screen.h"
 
 #include "analyzer/acquisition.h"
+#include "config.h"
 #include "misc/config_eeprom.h"
 #include "ui.h"
 
@@ -61,8 +62,52 @@ void HomeScreen::setup(uint8_t screen_num) {
   ui::create_label(screen_, w2 + 20, x2 - 20, y + 1, "",
                    ui::kFontNumericDataFields, LV_LABEL_ALIGN_RIGHT,
                    LV_COLOR_YELLOW, &steps_field_);
+
+  // Times, on the right column.
+  const lv_coord_t x3 = 310;
+  const lv_coord_t w3 = 150;
+  y = 47;
+  ui::create_label(screen_, w3, x3, y, "UPTIME", ui::kFontDataFields,
+                   LV_LABEL_ALIGN_LEFT, LV_COLOR_SILVER, nullptr);
+  y += dy;
+  ui::create_label(screen_, w3, x3, y, "", ui::kFontDataFields,
+                   LV_LABEL_ALIGN_RIGHT, LV_COLOR_SILVER, &uptime_field_);
+  y += dy;
+  ui::create_label(screen_, w3, x3, y, "JOB TIME", ui::kFontDataFields,
+                   LV_LABEL_ALIGN_LEFT, LV_COLOR_SILVER, nullptr);
+  y += dy;
+  ui::create_label(screen_, w3, x3, y, "", ui::kFontDataFields,
+                   LV_LABEL_ALIGN_RIGHT, LV_COLOR_SILVER, &job_time_field_);
+
+  // Axis selection, only with multiple axes. Clicking on the value
+  // selects the next axis for all the pages.
+  if (config::kNumAxes > 1) {
+    y += dy;
+    ui::create_label(screen_, w3, x3, y, "AXIS", ui::kFontDataFields,
+                     LV_LABEL_ALIGN_LEFT, LV_COLOR_SILVER, nullptr);
+    y += dy;
+    ui::create_label(screen_, w3, x3, y, "", ui::kFontDataFields,
+                     LV_LABEL_ALIGN_RIGHT, LV_COLOR_YELLOW, &axis_field_);
+    axis_field_.set_click_event(ui_events::UI_EVENT_AXIS);
+  }
 };
 
+// Set a label to a time in ticks, as [days D] hh:mm:ss.
+static void set_time_field(ui::Label& label, uint64_t ticks) {
+  const uint32_t secs = ticks / acquisition::TicksPerSecond;
+  const uint32_t days = secs / (24 * 60 * 60);
+  const uint32_t hours = (secs / (60 * 60)) % 24;
+  const uint32_t minutes = (secs / 60) % 60;
+  const uint32_t seconds = secs % 60;
+  if (days) {
+    lv_label_set_text_fmt(label.lv_label, "%luD %02lu:%02lu:%02lu", days,
+                          hours, minutes, seconds);
+  } else {
+    lv_label_set_text_fmt(label.lv_label, "%02lu:%02lu:%02lu", hours, minutes,
+                          seconds);
+  }
+}
+
 void HomeScreen::on_load() {
   // Force display update on first loop.
   display_update_elapsed_.set(kUpdateIntervalMillis + 1);
@@ -89,6 +134,13 @@ void HomeScreen::loop() {
   power_field_.set_text(state->is_energized ? "ON" : "OFF");
   power_field_.set_text_color(state->is_energized ? LV_COLOR_SILVER
                                                   : LV_COLOR_RED);
+  set_time_field(uptime_field_, state->tick_count);
+  set_time_field(job_time_field_, acquisition::job_ticks(*state));
+  if (config::kNumAxes > 1) {
+    lv_label_set_text_fmt(axis_field_.lv_label, "%d OF %d",
+                          acquisition::selected_axis() + 1, config::kNumAxes);
+  }
+
   idles_field_.set_text_uint(state->non_energized_count);
   idles_field_.set_text_color(state->non_energized_count ? LV_COLOR_RED
                                                          : LV_COLOR_SILVER);
@@ -96,6 +148,6 @@ void HomeScreen::loop() {
     const double full_steps = acquisition::state_steps(*state);
     steps_field_.set_text_float(full_steps, 2);
   } else {
-    steps_field_.set_text_int(state->full_steps);
+    steps_field_.set_text_int64(state->full_steps);
   }
 }
\ No newline at end of file
@@ -20,4 +20,8 @@ class HomeScreen : public screen_manager::Screen {
   ui::Label power_field_;
   ui::Label idles_field_;
   ui::Label steps_field_;
+  ui::Label uptime_field_;
+  ui::Label job_time_field_;
+  // Valid only if config::kNumAxes > 1.
+  ui::Label axis_field_;
 };
\ No newline at end of file
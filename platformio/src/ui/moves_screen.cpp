@@ -0,0 +1,111 @@
+#include "moves_screen.h"
+
+#include "analyzer/acquisition.h"
+#include "ui.h"
+
+static constexpr uint32_t kUpdateIntervalMillis = 300;
+
+// Number of most recent moves to display. Newest on top.
+static constexpr uint16_t kNumDisplayedMoves = 12;
+
+struct ColumnDesc {
+  lv_coord_t x;
+  lv_coord_t width;
+  const char* title;
+};
+
+static const ColumnDesc kColumnDescs[] = {
+    {.x = 5, .width = 55, .title = "#"},
+    {.x = 65, .width = 80, .title = "STEPS"},
+    {.x = 150, .width = 70, .title = "TIME S"},
+    {.x = 225, .width = 80, .title = "PEAK/S"},
+    {.x = 310, .width = 70, .title = "AMPS"},
+    {.x = 385, .width = 70, .title = "ERRORS"},
+};
+
+MovesScreen::MovesScreen(){};
+
+void MovesScreen::setup(uint8_t screen_num) {
+  static_assert(sizeof(kColumnDescs) / sizeof(kColumnDescs[0]) == NUM_COLUMNS,
+                "Inconsistent number of columns");
+
+  ui::create_screen(&screen_);
+  ui::create_page_elements(screen_, "MOVES", screen_num, nullptr);
+
+  for (int i = 0; i < NUM_COLUMNS; i++) {
+    const ColumnDesc& desc = kColumnDescs[i];
+    ui::create_label(screen_, desc.width, desc.x, 40, desc.title,
+                     ui::kFontSmallText, LV_LABEL_ALIGN_RIGHT, LV_COLOR_GRAY,
+                     nullptr);
+    ui::create_label(screen_, desc.width, desc.x, 60, "", ui::kFontSmallText,
+                     LV_LABEL_ALIGN_RIGHT, LV_COLOR_SILVER, &column_fields_[i]);
+  }
+};
+
+void MovesScreen::on_load() {
+  // Force display update on first loop.
+  displayed_total_moves_ = 0xffffffff;
+  display_update_elapsed_.set(kUpdateIntervalMillis + 1);
+};
+
+void MovesScreen::on_unload(){};
+
+void MovesScreen::on_event(ui_events::UiEventId ui_event_id) {}
+
+void MovesScreen::loop() {
+  // We update at a fixed rate.
+  if (display_update_elapsed_.elapsed_millis() < kUpdateIntervalMillis) {
+    return;
+  }
+  display_update_elapsed_.reset();
+
+  const acquisition::MoveRecords* moves = acquisition::sample_moves();
+  if (moves->total_moves == displayed_total_moves_) {
+    return;
+  }
+  displayed_total_moves_ = moves->total_moves;
+
+  const uint16_t size = moves->items.size();
+  const uint16_t n = min(size, kNumDisplayedMoves);
+
+  // Each column is a multi line label.
+  char bfr[kNumDisplayedMoves * 16];
+  for (int column = 0; column < NUM_COLUMNS; column++) {
+    char* p = bfr;
+    char* const end = bfr + sizeof(bfr);
+    *p = 0;
+    for (uint16_t i = 0; i < n; i++) {
+      const acquisition::MoveRecord& move = *moves->items.get_reversed(i);
+      const uint32_t steps = abs(move.steps);
+      const char* sep = (i > 0) ? "\n" : "";
+      switch (column) {
+        case SEQ:
+          p += snprintf(p, end - p, "%s%lu", sep, moves->total_moves - i);
+          break;
+        case STEPS:
+          p += snprintf(p, end - p, "%s%ld", sep, move.steps);
+          break;
+        case TIME: {
+          const uint32_t duration_millis =
+              move.duration_ticks / (acquisition::TicksPerSecond / 1000);
+          p += snprintf(p, end - p, "%s%lu.%02lu", sep, duration_millis / 1000,
+                        (duration_millis % 1000) / 10);
+        } break;
+        case PEAK_SPEED:
+          p += snprintf(p, end - p, "%s%lu", sep,
+                        acquisition::move_peak_steps_per_sec(move));
+          break;
+        case CURRENT: {
+          const int milliamps = acquisition::adc_value_to_milliamps(
+              steps ? move.total_step_peak_currents / steps : 0);
+          p += snprintf(p, end - p, "%s%d.%02d", sep, milliamps / 1000,
+                        (milliamps % 1000) / 10);
+        } break;
+        case ERRORS:
+          p += snprintf(p, end - p, "%s%u", sep, move.quadrature_errors);
+          break;
+      }
+    }
+    column_fields_[column].set_text(bfr);
+  }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "misc/elapsed.h"
+#include "screen_manager.h"
+
+class MovesScreen : public screen_manager::Screen {
+ public:
+  MovesScreen();
+  virtual void setup(uint8_t screen_num) override;
+  virtual void on_load() override;
+  virtual void on_unload() override;
+  virtual void loop() override;
+  virtual void on_event(ui_events::UiEventId ui_event_id) override;
+
+ private:
+  // Columns of the moves table.
+  enum Column { SEQ, STEPS, TIME, PEAK_SPEED, CURRENT, ERRORS, NUM_COLUMNS };
+
+  Elapsed display_update_elapsed_;
+  ui::Label column_fields_[NUM_COLUMNS];
+  // Total moves at last display update. Used to skip updates
+  // with no new moves.
+  uint32_t displayed_total_moves_ = 0;
+};
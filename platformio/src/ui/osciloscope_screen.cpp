@@ -3,30 +3,117 @@
 #include "analyzer/acquisition.h"
 #include "ui.h"
 
-static constexpr uint16_t kCaptureDividerNormal = 10;
-static const ui::ChartAxisConfigs kAxisConfigsNormal{
+// The chart displays kCaptureDisplaySize points. Zoom level z spans
+// kCaptureDisplaySize << z capture items, without recapturing. At zoom
+// levels above zero, each pair of points shows the min and max of
+// 2^(z+1) items, from the min/max pyramid.
+static constexpr int kNumZoomLevels = 3;
+static_assert((acquisition::kCaptureDisplaySize << (kNumZoomLevels - 1)) <=
+                  acquisition::kCaptureBufferSize,
+              "Capture buffer too small for the zoom levels");
+static_assert(kNumZoomLevels <= MinMaxPyramid::kLastLevel,
+              "Missing pyramid levels");
+
+// Axis configs. The x labels are set by the time base and the zoom
+// level.
+static const ui::ChartAxisConfigs kAxisConfigs = {
     .y_range = {.min = -2500, .max = 2500},
-    .x = {.labels = "0\n5ms\n10ms\n15ms\n20ms", .num_ticks = 5, .dividers = 3},
+    .x = {.labels = "", .num_ticks = capture_util::kNumDivisions + 1,
+          .dividers = capture_util::kNumDivisions - 1},
     .y = {.labels = "2.5A\n0\n-2.5A", .num_ticks = 3, .dividers = 1}};
 
-static constexpr uint16_t kCaptureDividerAlternative = 50;
-static const ui::ChartAxisConfigs kAxisConfigsAlternative{
-    .y_range = {.min = -2500, .max = 2500},
-    .x = {.labels = "0\n20ms\n40ms\n60ms\n80ms\n100ms",
-          .num_ticks = 6,
-          .dividers = 4},
-    .y = {.labels = "2.5A\n0\n-2.5A", .num_ticks = 3, .dividers = 1}};
+// Number of capture items spanned by a zoom level.
+static inline int window_items(int zoom) {
+  return acquisition::kCaptureDisplaySize << zoom;
+}
+
+// Creates a clickable text label at the bottom of the screen.
+static void create_control_label(const ui::Screen& screen, lv_coord_t x,
+                                 const char* text,
+                                 ui_events::UiEventId ui_event_id,
+                                 ui::Label* label) {
+  ui::create_label(screen, 40, x, ui::kBottomButtonsPosY + 5, text,
+                   ui::kFontDataFields, LV_LABEL_ALIGN_CENTER, LV_COLOR_GRAY,
+                   label);
+  label->set_click_event(ui_event_id);
+  // Extend the active area for easier clicking.
+  lv_obj_set_ext_click_area(label->lv_label, 5, 5, 15, 20);
+}
 
 void OsciloscopeScreen::setup(uint8_t screen_num) {
   ui::create_screen(&screen_);
   ui::create_page_elements(screen_, "CURRENT PATTERNS", screen_num, nullptr);
-  ui::create_chart(screen_, acquisition::kCaptureBufferSize, 2,
-                   kAxisConfigsNormal, ui_events::UI_EVENT_SCALE, &chart_);
+  ui::create_chart(screen_, acquisition::kCaptureDisplaySize, 2,
+                   kAxisConfigs, ui_events::UI_EVENT_SCALE, &chart_);
   capture_controls_.setup(screen_);
+  create_control_label(screen_, 55, "<", ui_events::UI_EVENT_PAN_LEFT,
+                       &pan_left_label_);
+  create_control_label(screen_, 100, ">", ui_events::UI_EVENT_PAN_RIGHT,
+                       &pan_right_label_);
+  create_control_label(screen_, 205, "-", ui_events::UI_EVENT_ZOOM_OUT,
+                       &zoom_out_label_);
+  create_control_label(screen_, 250, "+", ui_events::UI_EVENT_ZOOM_IN,
+                       &zoom_in_label_);
 };
 
+void OsciloscopeScreen::set_zoom(int zoom) {
+  zoom_ = zoom < 0 ? 0 : zoom >= kNumZoomLevels ? kNumZoomLevels - 1 : zoom;
+  // Keep the window within the capture.
+  set_center(center_);
+}
+
+void OsciloscopeScreen::set_center(int center) {
+  const int half_window = window_items(zoom_) / 2;
+  const int min_center = half_window;
+  const int max_center = acquisition::kCaptureBufferSize - half_window;
+  center_ = center < min_center   ? min_center
+            : center > max_center ? max_center
+                                  : center;
+}
+
+// With the slow timebases, the chart rolls. Each new item is written
+// at a point that sweeps from left to right and wraps around, and
+// only its neighbourhood is redrawn. Otherwise, the chart is redrawn
+// from the capture data.
+void OsciloscopeScreen::reset_roll_display() {
+  lv_chart_set_update_mode(chart_.lv_chart,
+                           capture_util::timebase().roll
+                               ? LV_CHART_UPDATE_MODE_CIRCULAR
+                               : LV_CHART_UPDATE_MODE_SHIFT);
+  // This also moves the sweep point back to the left.
+  chart_.ser1.clear();
+  chart_.ser2.clear();
+  lv_chart_refresh(chart_.lv_chart);
+}
+
+// Append the new roll items to the chart.
+void OsciloscopeScreen::update_roll_display() {
+  acquisition::CaptureItem items[acquisition::kRollBufferSize];
+  const uint16_t n =
+      capture_util::consume_roll_items(items, acquisition::kRollBufferSize);
+  if (!n) {
+    return;
+  }
+  lv_chart_series_t* lv_series1 = chart_.ser1.lv_series;
+  lv_chart_series_t* lv_series2 = chart_.ser2.lv_series;
+  for (uint16_t i = 0; i < n; i++) {
+    lv_chart_set_next(chart_.lv_chart, lv_series1,
+                      acquisition::adc_value_to_milliamps(items[i].v1));
+    lv_chart_set_next(chart_.lv_chart, lv_series2,
+                      acquisition::adc_value_to_milliamps(items[i].v2));
+  }
+  // A gap ahead of the sweep point, between the new and the old data.
+  lv_chart_set_point_id(chart_.lv_chart, lv_series1, LV_CHART_POINT_DEF,
+                        lv_series1->start_point);
+  lv_chart_set_point_id(chart_.lv_chart, lv_series2, LV_CHART_POINT_DEF,
+                        lv_series2->start_point);
+}
+
 void OsciloscopeScreen::on_load() {
+  // The data may have been captured by another screen.
+  pyramid_.compute(*capture_util::capture_buffer());
   capture_controls_.sync_button_to_state();
+  reset_roll_display();
   update_display();
 };
 
@@ -35,15 +122,41 @@ void OsciloscopeScreen::on_event(ui_events::UiEventId ui_event_id) {
     case ui_events::UI_EVENT_RESET:
       capture_util::clear_data();
       capture_controls_.sync_button_to_state();
+      reset_roll_display();
       update_display();
       break;
 
     case ui_events::UI_EVENT_SCALE: {
-      capture_util::toggle_scale();
+      capture_util::next_timebase();
       capture_controls_.sync_button_to_state();
+      // Back to the trigger point.
+      set_center(acquisition::kCaptureBufferSize / 2);
+      reset_roll_display();
       update_display();
     } break;
 
+    // Zoom and pan the displayed data, without recapturing. Ignored
+    // by the roll display.
+    case ui_events::UI_EVENT_ZOOM_IN:
+      set_zoom(zoom_ - 1);
+      update_display();
+      break;
+
+    case ui_events::UI_EVENT_ZOOM_OUT:
+      set_zoom(zoom_ + 1);
+      update_display();
+      break;
+
+    case ui_events::UI_EVENT_PAN_LEFT:
+      set_center(center_ - window_items(zoom_) / 4);
+      update_display();
+      break;
+
+    case ui_events::UI_EVENT_PAN_RIGHT:
+      set_center(center_ + window_items(zoom_) / 4);
+      update_display();
+      break;
+
     // This makes the compiler happy.
     default:
       break;
@@ -53,10 +166,21 @@ void OsciloscopeScreen::on_event(ui_events::UiEventId ui_event_id) {
 // Update chart from shared state.
 void OsciloscopeScreen::update_display() {
   // TODO: can we skip this most of the times? Is it expensive?
-  chart_.set_scale(capture_util::alternative_scale() ? kAxisConfigsAlternative
-                                                       : kAxisConfigsNormal);
+  const bool roll = capture_util::timebase().roll;
+  // The chart keeps a pointer to the x labels.
+  capture_util::format_time_axis_labels(
+      capture_util::timebase().usecs_per_division() << (roll ? 0 : zoom_),
+      capture_util::kNumDivisions, x_labels_, sizeof(x_labels_));
+  ui::ChartAxisConfigs axis_configs = kAxisConfigs;
+  axis_configs.x.labels = x_labels_;
+  chart_.set_scale(axis_configs);
   capture_controls_.update_display_from_state();
 
+  // The roll display is updated by loop().
+  if (roll) {
+    return;
+  }
+
   // No capture data.
   if (!capture_util::has_data()) {
     chart_.ser1.clear();
@@ -66,18 +190,41 @@ void OsciloscopeScreen::update_display() {
   }
 
   // Has capture data.
-  const acquisition::CaptureBuffer* capture_buffer =  capture_util::capture_buffer();
-  for (int i = 0; i < acquisition::kCaptureBufferSize; i++) {
-    const acquisition::CaptureItem* item =
-        capture_buffer->items.get(i);
-    // Currents in millamps [-2000, 2000].
-    const int milliamps1 = acquisition::adc_value_to_milliamps(item->v1);
-    const int milliamps2 = acquisition::adc_value_to_milliamps(item->v2);
-
-    lv_chart_set_point_id(chart_.lv_chart, chart_.ser1.lv_series, milliamps1,
-                          i);
-    lv_chart_set_point_id(chart_.lv_chart, chart_.ser2.lv_series, milliamps2,
-                          i);
+  const int first_item = center_ - window_items(zoom_) / 2;
+
+  // Zoom level 0, one capture item per point.
+  if (zoom_ == 0) {
+    const acquisition::CaptureBuffer* capture_buffer =
+        capture_util::capture_buffer();
+    for (int i = 0; i < acquisition::kCaptureDisplaySize; i++) {
+      const acquisition::CaptureItem* item =
+          capture_buffer->items.get(first_item + i);
+      // Currents in millamps [-2000, 2000].
+      const int milliamps1 = acquisition::adc_value_to_milliamps(item->v1);
+      const int milliamps2 = acquisition::adc_value_to_milliamps(item->v2);
+
+      lv_chart_set_point_id(chart_.lv_chart, chart_.ser1.lv_series,
+                            milliamps1, i);
+      lv_chart_set_point_id(chart_.lv_chart, chart_.ser2.lv_series,
+                            milliamps2, i);
+    }
+    lv_chart_refresh(chart_.lv_chart);
+    return;
+  }
+
+  // Higher zoom levels, a pair of min/max points per pyramid node.
+  const int level = zoom_ + 1;
+  const int first_node = first_item >> level;
+  lv_coord_t last_milliamps1 = 0;
+  lv_coord_t last_milliamps2 = 0;
+  for (int i = 0; i < acquisition::kCaptureDisplaySize; i += 2) {
+    const MinMaxNode& node = pyramid_.get(level, first_node + i / 2);
+    chart_.ser1.set_min_max(i, acquisition::adc_value_to_milliamps(node.min1),
+                            acquisition::adc_value_to_milliamps(node.max1),
+                            &last_milliamps1);
+    chart_.ser2.set_min_max(i, acquisition::adc_value_to_milliamps(node.min2),
+                            acquisition::adc_value_to_milliamps(node.max2),
+                            &last_milliamps2);
   }
 
   // Chart is dirty. Mark it for refresh.
@@ -91,8 +238,13 @@ void OsciloscopeScreen::loop() {
     return;
   }
 
-  if (capture_util::maybe_update_capture_data()) {
-     update_display();
-   }
+  if (capture_util::timebase().roll) {
+    update_roll_display();
+    return;
+  }
 
-}
\ No newline at end of file
+  if (capture_util::maybe_update_capture_data()) {
+    pyramid_.compute(*capture_util::capture_buffer());
+    update_display();
+  }
+}
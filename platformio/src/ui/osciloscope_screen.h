@@ -1,5 +1,6 @@
 #pragma once
 
+#include "analyzer/min_max_pyramid.h"
 #include "misc/elapsed.h"
 #include "screen_manager.h"
 #include "capture_util.h"
@@ -11,10 +12,30 @@ class OsciloscopeScreen : public screen_manager::Screen {
   virtual void on_load() override;
   virtual void loop() override;
   virtual void on_event(ui_events::UiEventId ui_event_id) override;
+  // The roll display has no zoom.
+  virtual bool has_zoom() const override {
+    return !capture_util::timebase().roll;
+  }
 
  private:
   void update_display();
+  void reset_roll_display();
+  void update_roll_display();
+  void set_zoom(int zoom);
+  void set_center(int center);
   
   ui::Chart chart_;
   capture_util::CaptureControls capture_controls_;
-};
\ No newline at end of file
+  ui::Label pan_left_label_;
+  ui::Label pan_right_label_;
+  ui::Label zoom_out_label_;
+  ui::Label zoom_in_label_;
+  // Min/max summary of the capture data, for the zoomed out views.
+  MinMaxPyramid pyramid_;
+  // The displayed window spans kCaptureDisplaySize << zoom_ capture
+  // items, around the item at index center_.
+  int zoom_ = 0;
+  int center_ = acquisition::kCaptureBufferSize / 2;
+  // The x axis labels, e.g. "0\n5ms\n10ms\n15ms\n20ms".
+  char x_labels_[48];
+};
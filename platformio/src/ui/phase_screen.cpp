@@ -1,10 +1,12 @@
 #include "phase_screen.h"
 
 #include "analyzer/acquisition.h"
+#include "analyzer/phase_metrics.h"
+#include "config.h"
 #include "ui.h"
 
 // TODO: Make class member? Share with other screen?
-static lv_point_t points[acquisition::kCaptureBufferSize];
+static lv_point_t points[acquisition::kCaptureDisplaySize];
 
 static const ui::ChartAxisConfigs kAxisConfigs{
     .y_range = {.min = -2500, .max = 2500},
@@ -22,9 +24,14 @@ void PhaseScreen::setup(uint8_t screen_num) {
                    LV_LABEL_ALIGN_CENTER, LV_COLOR_SILVER, &scale_lable_);
   lv_label_set_long_mode(scale_lable_.lv_label, LV_LABEL_LONG_EXPAND);
   scale_lable_.set_click_event(ui_events::UI_EVENT_SCALE);
+  ui::create_label(screen_, 130, 345, 45, "", ui::kFontSmallText,
+                   LV_LABEL_ALIGN_LEFT, LV_COLOR_SILVER, &metrics_label_);
 };
 
 void PhaseScreen::on_load() {
+  // The phase patterns and metrics need the individual samples, the
+  // timebase may have been changed by the oscilloscope.
+  capture_util::select_sample_timebase();
   capture_controls_.sync_button_to_state();
   update_display();
 };
@@ -38,7 +45,8 @@ void PhaseScreen::on_event(ui_events::UiEventId ui_event_id) {
       break;
 
     case ui_events::UI_EVENT_SCALE: {
-      capture_util::toggle_scale();
+      // Only the timebases with individual samples, see on_load().
+      capture_util::next_timebase(true);
       capture_controls_.sync_button_to_state();
       update_display();
     } break;
@@ -49,6 +57,29 @@ void PhaseScreen::on_event(ui_events::UiEventId ui_event_id) {
   }
 }
 
+// Format a metric value with one decimal digit.
+static const char* format_metric(float value, char* bfr) {
+  dtostrf(value, 0, 1, bfr);
+  return bfr;
+}
+
+void PhaseScreen::update_metrics_display() {
+  if (!has_metrics_) {
+    metrics_label_.set_text(
+        "RIPPLE  --\nIMBAL  --\nPHASE  --\nTHD A  --\nTHD B  --");
+    return;
+  }
+  char bfr[5][12];
+  lv_label_set_text_fmt(
+      metrics_label_.lv_label,
+      "RIPPLE  %s%%\nIMBAL  %s%%\nPHASE  %s DEG\nTHD A  %s%%\nTHD B  %s%%",
+      format_metric(metrics_.magnitude_ripple_percent, bfr[0]),
+      format_metric(metrics_.imbalance_percent, bfr[1]),
+      format_metric(metrics_.phase_offset_degrees, bfr[2]),
+      format_metric(metrics_.thd1_percent, bfr[3]),
+      format_metric(metrics_.thd2_percent, bfr[4]));
+}
+
 // Maps -2500 to +2500 ma to 0 to 2*max_radius.
 static lv_coord_t map_line_coord(int milliamps, lv_coord_t max_radius) {
   constexpr int kMaxScale = 2500;
@@ -58,19 +89,29 @@ static lv_coord_t map_line_coord(int milliamps, lv_coord_t max_radius) {
 void PhaseScreen::update_display() {
   capture_controls_.update_display_from_state();
 
-  scale_lable_.set_text(capture_util::alternative_scale()
-                            ? "SLOW Capture\ntime:  100ms"
-                            : "FAST Capture\ntime:  20ms");
+  char capture_time[12];
+  capture_util::format_time(capture_util::timebase().usecs_per_division() *
+                                capture_util::kNumDivisions,
+                            capture_time, sizeof(capture_time));
+  lv_label_set_text_fmt(scale_lable_.lv_label, "Capture\ntime:  %s",
+                        capture_time);
 
   if (!capture_util::has_data()) {
     lv_line_set_points(polar_chart_.lv_line, points, 0);
+    has_metrics_ = false;
+    update_metrics_display();
     return;
   }
 
+  has_metrics_ =
+      phase_metrics::compute(*capture_util::capture_buffer(), &metrics_);
+  update_metrics_display();
+
   // Update both chart series with the new captured data.
-  for (int i = 0; i < acquisition::kCaptureBufferSize; i++) {
+  for (int i = 0; i < acquisition::kCaptureDisplaySize; i++) {
     const acquisition::CaptureItem* item =
-        capture_util::capture_buffer()->items.get(i);
+        capture_util::capture_buffer()->items.get(
+            acquisition::kCaptureDisplayStart + i);
     // Currents in millamps [-2000, 2000].
     const int milliamps1 = acquisition::adc_value_to_milliamps(item->v1);
     const int milliamps2 = acquisition::adc_value_to_milliamps(item->v2);
@@ -81,7 +122,7 @@ void PhaseScreen::update_display() {
 
   // The line keeps a reference to our points buffer.
   lv_line_set_points(polar_chart_.lv_line, points,
-                     acquisition::kCaptureBufferSize);
+                     acquisition::kCaptureDisplaySize);
 }
 
 void PhaseScreen::loop() {
@@ -93,5 +134,8 @@ void PhaseScreen::loop() {
 
   if (capture_util::maybe_update_capture_data()) {
     update_display();
+    if (config::kEnablePhaseMetricsReports && has_metrics_) {
+      phase_metrics::dump(metrics_);
+    }
   }
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "analyzer/phase_metrics.h"
 #include "capture_util.h"
 #include "misc/elapsed.h"
 #include "screen_manager.h"
@@ -14,8 +15,13 @@ class PhaseScreen : public screen_manager::Screen {
 
  private:
   void update_display();
+  void update_metrics_display();
 
   ui::PolarChart polar_chart_;
   capture_util::CaptureControls capture_controls_;
   ui::Label scale_lable_;
+  ui::Label metrics_label_;
+  // Metrics of the displayed capture. Valid if has_metrics_.
+  bool has_metrics_ = false;
+  phase_metrics::PhaseMetrics metrics_;
 };
\ No newline at end of file
@@ -80,7 +80,8 @@ void RetractionChartScreen::loop() {
 
   const acquisition::State* state = acquisition::sample_state();
 
-  int retraction_steps = state->max_full_steps - state->full_steps;
+  // Retraction is a short distance so int is sufficient.
+  const int retraction_steps = state->max_full_steps - state->full_steps;
 
   if (++field_update_divider_ >= kFieldUpdateRatio) {
     field_update_divider_ = 0;
@@ -0,0 +1,86 @@
+#include "ripple_histogram_screen.h"
+
+#include "analyzer/acquisition.h"
+#include "ui.h"
+
+static constexpr uint32_t kUpdateIntervalMillis = 200;
+
+// Y values are in 0.1% units.
+static const ui::ChartAxisConfigs kAxisConfigsNormal{
+    .y_range = {.min = 0, .max = 250},
+    .x = {.labels = "0\n500\n1000\n1500\n2000", .num_ticks = 5, .dividers = 3},
+    .y = {.labels = "25%\n20\n15\n10\n5\n0",
+          .num_ticks = 6,
+          .dividers = 4}};
+
+RippleHistogramScreen::RippleHistogramScreen(){};
+
+void RippleHistogramScreen::setup(uint8_t screen_num) {
+  ui::create_screen(&screen_);
+  ui::create_page_elements(screen_, "RIPPLE BY STEPS/SEC", screen_num,
+                           nullptr);
+  ui::create_histogram(screen_, histogram::kLinearNumBuckets,
+                       kAxisConfigsNormal, ui_events::UI_EVENT_SCALE,
+                       &histogram_);
+  zoom_.setup(kAxisConfigsNormal, &histogram_);
+};
+
+void RippleHistogramScreen::on_load() {
+  // Force display update on first loop.
+  display_update_elapsed_.set(kUpdateIntervalMillis + 1);
+};
+
+void RippleHistogramScreen::on_unload(){};
+
+void RippleHistogramScreen::on_event(ui_events::UiEventId ui_event_id) {
+  switch (ui_event_id) {
+    case ui_events::UI_EVENT_RESET:
+      acquisition::reset_state();
+      break;
+
+    case ui_events::UI_EVENT_SCALE:
+      zoom_.next_zoom();
+      // Force display update on next loop.
+      display_update_elapsed_.set(kUpdateIntervalMillis + 1);
+      break;
+
+    default:
+      break;
+  }
+}
+
+void RippleHistogramScreen::loop() {
+  // We update at a fixed rate.
+  if (display_update_elapsed_.elapsed_millis() < kUpdateIntervalMillis) {
+    return;
+  }
+  display_update_elapsed_.reset();
+
+  // Sample acquisition state and update display.
+  const acquisition::State* state = acquisition::sample_state();
+  zoom_.update(*state);
+  const int first_bucket = zoom_.first_bucket();
+  const int num_buckets = zoom_.num_buckets();
+
+  // Update all the histogram points.
+  for (int i = 0; i < num_buckets; i++) {
+    acquisition::HistogramBucket bucket;
+    acquisition::sample_histogram_bucket(first_bucket + i, &bucket);
+    // Ripple in 0.1% units, clipped at the top of the chart.
+    const float ripple_permils = acquisition::bucket_ripple_percent(bucket) * 10;
+    uint16_t val = ripple_permils < kAxisConfigsNormal.y_range.max
+                       ? (uint16_t)ripple_permils
+                       : kAxisConfigsNormal.y_range.max;
+
+    // Force non zero value to be visible.
+    const lv_coord_t min_non_zero_val = kAxisConfigsNormal.y_range.max / 100;
+    if (bucket.total_steps > 0 && val < min_non_zero_val) {
+      // Make it visible.
+      val = min_non_zero_val;
+    }
+
+    histogram_.lv_series->points[i] = val;
+  }
+
+  lv_chart_refresh(histogram_.lv_chart);
+}
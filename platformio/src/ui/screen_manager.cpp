@@ -2,15 +2,23 @@
 
 #include <Arduino.h>
 
+#include "accel_histogram_screen.h"
+#include "analyzer/accel_profiler.h"
 #include "analyzer/acquisition.h"
+#include "capture_util.h"
+#include "config.h"
 #include "current_histogram_screen.h"
 #include "display/lv_adapter.h"
 #include "home_screen.h"
+#include "moves_screen.h"
 #include "retraction_chart_screen.h"
+#include "ripple_histogram_screen.h"
 #include "settings_screen.h"
 #include "osciloscope_screen.h"
 #include "phase_screen.h"
+#include "spectrum_screen.h"
 #include "speed_gauge_screen.h"
+#include "stalls_screen.h"
 #include "steps_chart_screen.h"
 #include "steps_histogram_screen.h"
 #include "time_histogram_screen.h"
@@ -35,7 +43,12 @@ static TimeHistogramScreen screen_time_histogram;
 static StepsHistorgramScreen steps_histogram_screen;
 static OsciloscopeScreen osciloscope_screen;
 static PhaseScreen phase_screen;
+static SpectrumScreen spectrum_screen;
 static CurrentHistogramScreen current_histogram_screen;
+static RippleHistogramScreen ripple_histogram_screen;
+static AccelHistogramScreen accel_histogram_screen;
+static MovesScreen moves_screen;
+static StallsScreen stalls_screen;
 
 // Order here determines screen 'next/previous' order.
 static const ScreenDesc screen_table[] = {
@@ -46,8 +59,13 @@ static const ScreenDesc screen_table[] = {
     {SCREEN_TIME_HISTOGRAM, &screen_time_histogram},
     {SCREEN_STEPS_HISTOGRAM, &steps_histogram_screen},
     {SCREEN_CURRENT_HISTOGRAM, &current_histogram_screen},
+    {SCREEN_RIPPLE_HISTOGRAM, &ripple_histogram_screen},
+    {SCREEN_ACCEL_HISTOGRAM, &accel_histogram_screen},
+    {SCREEN_MOVES, &moves_screen},
+    {SCREEN_STALLS, &stalls_screen},
     {SCREEN_OSCILOSCOPE, &osciloscope_screen},
     {SCREEN_PHASE, &phase_screen},
+    {SCREEN_SPECTRUM, &spectrum_screen},
 };
 constexpr int kNumScreens = sizeof(screen_table) / sizeof(screen_table[0]);
 
@@ -101,6 +119,16 @@ static bool common_event_handler(ui_events::UiEventId ui_event_id) {
   switch (ui_event_id) {
     case ui_events::UI_EVENT_RESET:
       acquisition::reset_state();
+      accel_profiler::reset();
+      return true;
+
+    case ui_events::UI_EVENT_AXIS:
+      // The acceleration profile and the captured signals are of
+      // the previously selected axis.
+      acquisition::select_axis((acquisition::selected_axis() + 1) %
+                               config::kNumAxes);
+      accel_profiler::reset();
+      capture_util::clear_data();
       return true;
 
     case ui_events::UI_EVENT_PREV_PAGE:
@@ -128,6 +156,36 @@ static bool common_event_handler(ui_events::UiEventId ui_event_id) {
   }
 }
 
+// Returns true and sets *ui_event_id if a touch gesture is pending.
+// Swipes move between the pages and pinches zoom, or change the chart
+// scale, same as clicking the chart, in screens that have no zoom.
+static bool consume_gesture_event(ui_events::UiEventId* ui_event_id) {
+  Gesture gesture;
+  if (!lv_adapter::consume_gesture(&gesture)) {
+    return false;
+  }
+  switch (gesture) {
+    case GESTURE_SWIPE_LEFT:
+      *ui_event_id = ui_events::UI_EVENT_NEXT_PAGE;
+      return true;
+    case GESTURE_SWIPE_RIGHT:
+      *ui_event_id = ui_events::UI_EVENT_PREV_PAGE;
+      return true;
+    case GESTURE_PINCH_IN:
+      *ui_event_id = current_screen_desc->screen_ptr->has_zoom()
+                         ? ui_events::UI_EVENT_ZOOM_OUT
+                         : ui_events::UI_EVENT_SCALE;
+      return true;
+    case GESTURE_PINCH_OUT:
+      *ui_event_id = current_screen_desc->screen_ptr->has_zoom()
+                         ? ui_events::UI_EVENT_ZOOM_IN
+                         : ui_events::UI_EVENT_SCALE;
+      return true;
+    default:
+      return false;
+  }
+}
+
 void setup() {
   // Setup all screens.
   for (int i = 0; i < kNumScreens; i++) {
@@ -145,7 +203,8 @@ void setup() {
 void loop() {
   // Handle pending ui event, if any.
   ui_events::UiEventId event_id;
-  if (ui_events::consume_event(&event_id)) {
+  if (consume_gesture_event(&event_id) ||
+      ui_events::consume_event(&event_id)) {
     const bool also_send_to_screen = common_event_handler(event_id);
     if (also_send_to_screen) {
       current_screen_desc->screen_ptr->on_event(event_id);
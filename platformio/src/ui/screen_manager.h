@@ -20,6 +20,9 @@ class Screen {
   virtual void loop() {};
   // On event. Should ignore unknown events.
   virtual void on_event(ui_events::UiEventId ui_event_id) {}
+  // True if the screen handles UI_EVENT_ZOOM_IN/OUT. Pinch gestures
+  // are sent as zoom events if true, or as UI_EVENT_SCALE otherwise.
+  virtual bool has_zoom() const { return false; }
 
   lv_obj_t* lv_scr() {
     return screen_.lv_screen;
@@ -41,7 +44,12 @@ enum ScreenId {
   SCREEN_STEPS_HISTOGRAM,
   SCREEN_OSCILOSCOPE,
   SCREEN_PHASE,
+  SCREEN_SPECTRUM,
   SCREEN_CURRENT_HISTOGRAM,
+  SCREEN_RIPPLE_HISTOGRAM,
+  SCREEN_ACCEL_HISTOGRAM,
+  SCREEN_MOVES,
+  SCREEN_STALLS,
   SCREEN_SETTINGS,
 };
 
@@ -2,7 +2,8 @@
 
 #include "analyzer/acquisition.h"
 #include "config.h"
-#include "misc/config_eeprom.h"
+#include "misc/config_flash.h"
+#include "misc/lifetime_stats.h"
 #include "ui.h"
 #include "ui_events.h"
 
@@ -13,14 +14,32 @@ static constexpr const char* kFootnotText =
     "the analyzer and press the SET ZERO button.\n"
     "Firmware version " VERSION_STRING;
 
+// Format a count in a short form. E.g. 850, 12.3K, 4.5M, 1.2G.
+static void format_count(char* bfr, int size, uint64_t count) {
+  static const char* const kUnits[] = {"", "K", "M", "G"};
+  int unit = 0;
+  // In tenths of the unit.
+  uint64_t tenths = count * 10;
+  while (tenths >= 10000 && unit < 3) {
+    tenths /= 1000;
+    unit++;
+  }
+  const uint32_t t = (uint32_t)tenths;
+  if (unit == 0 || t >= 1000) {
+    snprintf(bfr, size, "%lu%s", t / 10, kUnits[unit]);
+  } else {
+    snprintf(bfr, size, "%lu.%lu%s", t / 10, t % 10, kUnits[unit]);
+  }
+}
+
 // Must be static. LV keeps a reference to it.
 static lv_style_t style;
 
-static void update_eeprom() {
+static void update_flash() {
   acquisition::Settings settings;
   acquisition::get_settings(&settings);
-  config_eeprom::write_acquisition_settings(settings);
-  Serial.println(config_eeprom::last_status);
+  config_flash::write_acquisition_settings(settings);
+  Serial.println(config_flash::last_status);
 }
 
 static bool is_reversed_direction() {
@@ -29,6 +48,24 @@ static bool is_reversed_direction() {
   return acq_settings.reverse_direction;
 }
 
+static bool is_adaptive_threshold() {
+  acquisition::Settings acq_settings;
+  acquisition::get_settings(&acq_settings);
+  return acq_settings.adaptive_threshold;
+}
+
+static bool is_oversampling() {
+  acquisition::Settings acq_settings;
+  acquisition::get_settings(&acq_settings);
+  return acq_settings.oversampling;
+}
+
+static bool is_log_histogram() {
+  acquisition::Settings acq_settings;
+  acquisition::get_settings(&acq_settings);
+  return acq_settings.histogram_scale == histogram::SCALE_LOG;
+}
+
 // TODO: generalize and move to ui.cpp.
 static void create_set_zero_button(lv_obj_t* lv_screen) {
   lv_obj_t* lv_button = lv_btn_create(lv_screen, NULL);
@@ -104,12 +141,38 @@ void SettingsScreen::setup(uint8_t screen_num) {
   ui::create_label(screen_, w2, x2, y, "", ui::kFontNumericDataFields,
                    LV_LABEL_ALIGN_RIGHT, LV_COLOR_SILVER, &ch_b_field_);
 
-  y += 90;
+  ui::create_label(screen_, 440, x1, y + 31, "", ui::kFontSmallText,
+                   LV_LABEL_ALIGN_LEFT, LV_COLOR_GRAY, &lifetime_field_);
+
+  y += 56;
   ui::create_checkbox(screen_, x1, y, " REVERSE  STEPS  DIRECTION",
                       ui::kFontDataFields, LV_COLOR_SILVER,
                       ui_events::UI_EVENT_DIRECTION, &reverse_checkbox_);
   reverse_checkbox_.set_is_checked(is_reversed_direction());
 
+  y += 33;
+  ui::create_checkbox(screen_, x1, y, " ADAPTIVE  POWER  THRESHOLD",
+                      ui::kFontDataFields, LV_COLOR_SILVER,
+                      ui_events::UI_EVENT_ADAPTIVE_THRESHOLD,
+                      &adaptive_threshold_checkbox_);
+  adaptive_threshold_checkbox_.set_is_checked(is_adaptive_threshold());
+
+  y += 33;
+  ui::create_checkbox(screen_, x1, y, " LOG  SCALE  HISTOGRAMS",
+                      ui::kFontDataFields, LV_COLOR_SILVER,
+                      ui_events::UI_EVENT_HISTOGRAM_SCALE,
+                      &log_histogram_checkbox_);
+  log_histogram_checkbox_.set_is_checked(is_log_histogram());
+
+  if (acquisition::kOversamplingSupported) {
+    y += 33;
+    ui::create_checkbox(screen_, x1, y, " 4X  OVERSAMPLING",
+                        ui::kFontDataFields, LV_COLOR_SILVER,
+                        ui_events::UI_EVENT_OVERSAMPLING,
+                        &oversampling_checkbox_);
+    oversampling_checkbox_.set_is_checked(is_oversampling());
+  }
+
   ui::create_label(screen_, 0, 5, 270, kFootnotText, ui::kFontSmallText,
                    LV_LABEL_ALIGN_LEFT, LV_COLOR_OLIVE, nullptr);
 };
@@ -125,12 +188,30 @@ void SettingsScreen::on_event(ui_events::UiEventId ui_event_id) {
   switch (ui_event_id) {
     case ui_events::UI_EVENT_ZERO_CALIBRATION:
       acquisition::calibrate_zeros();
-      update_eeprom();
+      update_flash();
       break;
 
     case ui_events::UI_EVENT_DIRECTION:
       acquisition::set_direction(reverse_checkbox_.is_checked());
-      update_eeprom();
+      update_flash();
+      break;
+
+    case ui_events::UI_EVENT_ADAPTIVE_THRESHOLD:
+      acquisition::set_adaptive_threshold(
+          adaptive_threshold_checkbox_.is_checked());
+      update_flash();
+      break;
+
+    case ui_events::UI_EVENT_OVERSAMPLING:
+      acquisition::set_oversampling(oversampling_checkbox_.is_checked());
+      update_flash();
+      break;
+
+    case ui_events::UI_EVENT_HISTOGRAM_SCALE:
+      acquisition::set_histogram_scale(log_histogram_checkbox_.is_checked()
+                                           ? histogram::SCALE_LOG
+                                           : histogram::SCALE_LINEAR);
+      update_flash();
       break;
 
     default:
@@ -152,4 +233,16 @@ void SettingsScreen::loop() {
                              2);
   ch_b_field_.set_text_float(acquisition::adc_value_to_amps(state->v2),
                              2);
+
+  const lifetime_stats::LifetimeStats& lifetime = lifetime_stats::stats();
+  char steps[12];
+  char errors[12];
+  format_count(steps, sizeof(steps), lifetime.steps);
+  format_count(errors, sizeof(errors), lifetime.quadrature_errors);
+  const uint32_t tenth_hours = (uint32_t)(lifetime.energized_millis / 360000);
+  lv_label_set_text_fmt(lifetime_field_.lv_label,
+                        "LIFETIME: %s STEPS, %lu.%lu HRS, %s ERRORS, "
+                        "%lu STALLS, %lu BOOTS",
+                        steps, tenth_hours / 10, tenth_hours % 10, errors,
+                        lifetime.stall_events, lifetime.power_ups);
 }
\ No newline at end of file
@@ -16,5 +16,10 @@ class SettingsScreen : public screen_manager::Screen {
   Elapsed display_update_elapsed_;
   ui::Label ch_a_field_;
   ui::Label ch_b_field_;
+  ui::Label lifetime_field_;
   ui::Checkbox reverse_checkbox_;
+  ui::Checkbox adaptive_threshold_checkbox_;
+  ui::Checkbox log_histogram_checkbox_;
+  // Valid only if acquisition::kOversamplingSupported.
+  ui::Checkbox oversampling_checkbox_;
 };
\ No newline at end of file
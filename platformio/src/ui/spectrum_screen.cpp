@@ -0,0 +1,156 @@
+#include "spectrum_screen.h"
+
+#include "analyzer/acquisition.h"
+#include "analyzer/fft.h"
+#include "ui.h"
+
+static constexpr uint32_t kUpdateIntervalMillis = 250;
+
+// The spectrum is computed over the last kFftSize items of the
+// capture buffer.
+static constexpr int kFftSize = 512;
+static_assert(kFftSize <= acquisition::kCaptureBufferSize,
+              "Capture buffer too small for the FFT");
+static constexpr int kNumBins = kFftSize / 2;
+
+// Wide span, 0 to 50Khz, shows the PWM chopper frequency.
+static constexpr uint16_t kCaptureDividerWide = 1;
+static constexpr acquisition::CaptureMode kCaptureModeWide =
+    acquisition::CAPTURE_MODE_SAMPLE;
+static const ui::ChartAxisConfigs kAxisConfigsWide{
+    .y_range = {.min = fft::kMinDb10, .max = 0},
+    .x = {.labels = "0\n10K\n20K\n30K\n40K\n50K", .num_ticks = 6, .dividers = 4},
+    .y = {.labels = "0dB\n-30\n-60\n-90", .num_ticks = 4, .dividers = 2}};
+
+// Narrow span, 0 to 5Khz, shows resonance bands. Each capture item is
+// the average of 10 samples, a boxcar anti alias filter, so the chopper
+// and PWM energy above 5Khz is attenuated rather than folded into the
+// displayed band.
+static constexpr uint16_t kCaptureDividerNarrow = 10;
+static constexpr acquisition::CaptureMode kCaptureModeNarrow =
+    acquisition::CAPTURE_MODE_AVERAGE;
+static const ui::ChartAxisConfigs kAxisConfigsNarrow{
+    .y_range = {.min = fft::kMinDb10, .max = 0},
+    .x = {.labels = "0\n1K\n2K\n3K\n4K\n5K", .num_ticks = 6, .dividers = 4},
+    .y = {.labels = "0dB\n-30\n-60\n-90", .num_ticks = 4, .dividers = 2}};
+
+// FFT input and work buffer.
+static int16_t fft_samples[kFftSize];
+
+void SpectrumScreen::setup(uint8_t screen_num) {
+  fft::setup();
+  ui::create_screen(&screen_);
+  ui::create_page_elements(screen_, "CURRENT SPECTRUM", screen_num, nullptr);
+  ui::create_chart(screen_, kNumBins, 2, kAxisConfigsWide,
+                   ui_events::UI_EVENT_SCALE, &chart_);
+  capture_controls_.setup(screen_);
+};
+
+void SpectrumScreen::on_load() {
+  // Captures may have been started by other screens.
+  capture_in_progress_ = false;
+  capture_controls_.sync_button_to_state();
+  update_display();
+};
+
+void SpectrumScreen::on_event(ui_events::UiEventId ui_event_id) {
+  switch (ui_event_id) {
+    case ui_events::UI_EVENT_RESET:
+      has_data_ = false;
+      capture_util::set_capture_enabled(true);
+      capture_controls_.sync_button_to_state();
+      update_display();
+      break;
+
+    case ui_events::UI_EVENT_SCALE:
+      wide_span_ = !wide_span_;
+      has_data_ = false;
+      capture_in_progress_ = false;
+      capture_util::set_capture_enabled(true);
+      capture_controls_.sync_button_to_state();
+      update_display();
+      break;
+
+    // This makes the compiler happy.
+    default:
+      break;
+  }
+}
+
+void SpectrumScreen::update_display() {
+  chart_.set_scale(wide_span_ ? kAxisConfigsWide : kAxisConfigsNarrow);
+  capture_controls_.update_display_from_state();
+
+  if (!has_data_) {
+    chart_.ser1.clear();
+    chart_.ser2.clear();
+  }
+  lv_chart_refresh(chart_.lv_chart);
+}
+
+// Compute the spectrum of the two channels from the acquisition
+// capture buffer directly into the chart series. Assumes that a
+// capture is ready.
+void SpectrumScreen::update_spectrum() {
+  const acquisition::CaptureBuffer* capture_buffer =
+      acquisition::capture_buffer();
+
+  const int first = capture_buffer->items.size() - kFftSize;
+  for (int i = 0; i < kFftSize; i++) {
+    fft_samples[i] = capture_buffer->items.get(first + i)->v1;
+  }
+  fft::power_spectrum_db10(fft_samples, kFftSize,
+                           chart_.ser1.lv_series->points);
+
+  for (int i = 0; i < kFftSize; i++) {
+    fft_samples[i] = capture_buffer->items.get(first + i)->v2;
+  }
+  fft::power_spectrum_db10(fft_samples, kFftSize,
+                           chart_.ser2.lv_series->points);
+
+  has_data_ = true;
+}
+
+void SpectrumScreen::loop() {
+  // Update capture enabled if needed.
+  if (capture_util::maybe_update_state_from_controls(capture_controls_)) {
+    update_display();
+    return;
+  }
+
+  if (!capture_util::capture_enabled()) {
+    return;
+  }
+
+  const uint16_t divider =
+      wide_span_ ? kCaptureDividerWide : kCaptureDividerNarrow;
+  const acquisition::CaptureMode mode =
+      wide_span_ ? kCaptureModeWide : kCaptureModeNarrow;
+
+  // Do we need to start a new capture?
+  if (!capture_in_progress_) {
+    if (elapsed_from_last_capture_.elapsed_millis() >= kUpdateIntervalMillis) {
+      elapsed_from_last_capture_.reset();
+      acquisition::start_capture(divider, mode);
+      capture_in_progress_ = true;
+    }
+    return;
+  }
+
+  if (!acquisition::is_capture_ready()) {
+    return;
+  }
+  capture_in_progress_ = false;
+
+  // The spectrum doesn't need a trigger point, we use the entire
+  // buffer as is.
+  const acquisition::CaptureBuffer* capture_buffer =
+      acquisition::capture_buffer();
+  if (capture_buffer->divider != divider || capture_buffer->mode != mode ||
+      capture_buffer->items.size() < kFftSize) {
+    return;
+  }
+
+  update_spectrum();
+  update_display();
+}
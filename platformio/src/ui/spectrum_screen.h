@@ -0,0 +1,25 @@
+#pragma once
+
+#include "capture_util.h"
+#include "misc/elapsed.h"
+#include "screen_manager.h"
+
+class SpectrumScreen : public screen_manager::Screen {
+ public:
+  SpectrumScreen(){};
+  virtual void setup(uint8_t screen_num) override;
+  virtual void on_load() override;
+  virtual void loop() override;
+  virtual void on_event(ui_events::UiEventId ui_event_id) override;
+
+ private:
+  void update_display();
+  void update_spectrum();
+
+  ui::Chart chart_;
+  capture_util::CaptureControls capture_controls_;
+  Elapsed elapsed_from_last_capture_;
+  bool capture_in_progress_ = false;
+  bool has_data_ = false;
+  bool wide_span_ = true;
+};
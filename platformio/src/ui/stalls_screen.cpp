@@ -0,0 +1,91 @@
+#include "stalls_screen.h"
+
+#include "ui.h"
+
+static constexpr uint32_t kUpdateIntervalMillis = 500;
+
+// Number of most recent events to list. Newest on top.
+static constexpr uint16_t kNumDisplayedEvents = 7;
+
+// Indexed by acquisition::StallEventType.
+static const char* const kEventTypeNames[] = {
+    "QUADRANT JUMP",
+    "CURRENT COLLAPSE",
+    "DISTORTED STEP",
+};
+
+static_assert(sizeof(kEventTypeNames) / sizeof(kEventTypeNames[0]) ==
+                  acquisition::NUM_STALL_EVENT_TYPES,
+              "Inconsistent stall event names");
+
+StallsScreen::StallsScreen(){};
+
+void StallsScreen::setup(uint8_t screen_num) {
+  ui::create_screen(&screen_);
+  ui::create_page_elements(screen_, "STALL EVENTS", screen_num, nullptr);
+
+  // We don't bother to keep references to the fixed labels.
+  const lv_coord_t w1 = 220;
+  const lv_coord_t w2 = 130;
+  const lv_coord_t x1 = 40;
+  const lv_coord_t x2 = 300;
+  const lv_coord_t dy = 36;
+  lv_coord_t y = 47;
+
+  // NOTE: adding 1 to the y of the numeric fields to better align
+  // with the font of the text fields.
+  for (int i = 0; i < acquisition::NUM_STALL_EVENT_TYPES; i++) {
+    ui::create_label(screen_, w1, x1, y, kEventTypeNames[i],
+                     ui::kFontDataFields, LV_LABEL_ALIGN_LEFT,
+                     LV_COLOR_SILVER, nullptr);
+    ui::create_label(screen_, w2, x2, y + 1, "", ui::kFontNumericDataFields,
+                     LV_LABEL_ALIGN_RIGHT, LV_COLOR_SILVER, &count_fields_[i]);
+    y += dy;
+  }
+
+  ui::create_label(screen_, 390, x1, y + 5, "", ui::kFontSmallText,
+                   LV_LABEL_ALIGN_LEFT, LV_COLOR_YELLOW, &events_field_);
+};
+
+void StallsScreen::on_load() {
+  // Force display update on first loop.
+  display_update_elapsed_.set(kUpdateIntervalMillis + 1);
+};
+
+void StallsScreen::on_unload(){};
+
+void StallsScreen::on_event(ui_events::UiEventId ui_event_id) {}
+
+void StallsScreen::loop() {
+  // We update at a fixed rate.
+  if (display_update_elapsed_.elapsed_millis() < kUpdateIntervalMillis) {
+    return;
+  }
+  display_update_elapsed_.reset();
+
+  const acquisition::StallEvents* events = acquisition::sample_stall_events();
+
+  for (int i = 0; i < acquisition::NUM_STALL_EVENT_TYPES; i++) {
+    count_fields_[i].set_text_uint(events->counts[i]);
+  }
+
+  // List the most recent events with their time since last
+  // reset and the steps position.
+  char bfr[kNumDisplayedEvents * 64];
+  char* p = bfr;
+  char* const end = bfr + sizeof(bfr);
+  *p = 0;
+  const uint64_t reset_tick_count = acquisition::reset_tick_count();
+  const uint16_t n = min(events->items.size(), kNumDisplayedEvents);
+  for (uint16_t i = 0; i < n; i++) {
+    const acquisition::StallEvent& event = *events->items.get_reversed(i);
+    const uint64_t event_millis =
+        acquisition::ticks_to_millis(event.tick - reset_tick_count);
+    char steps_bfr[ui::kInt64TextSize];
+    p += snprintf(p, end - p, "%s%lu.%03lu s   %s   AT STEP %s",
+                  (i > 0) ? "\n" : "", (uint32_t)(event_millis / 1000),
+                  (uint32_t)(event_millis % 1000), kEventTypeNames[event.type],
+                  ui::format_int64(event.full_steps, steps_bfr));
+  }
+  events_field_.set_text(bfr);
+}
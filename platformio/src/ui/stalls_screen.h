@@ -0,0 +1,20 @@
+#pragma once
+
+#include "analyzer/acquisition.h"
+#include "misc/elapsed.h"
+#include "screen_manager.h"
+
+class StallsScreen : public screen_manager::Screen {
+ public:
+  StallsScreen();
+  virtual void setup(uint8_t screen_num) override;
+  virtual void on_load() override;
+  virtual void on_unload() override;
+  virtual void loop() override;
+  virtual void on_event(ui_events::UiEventId ui_event_id) override;
+
+ private:
+  Elapsed display_update_elapsed_;
+  ui::Label count_fields_[acquisition::NUM_STALL_EVENT_TYPES];
+  ui::Label events_field_;
+};
@@ -27,10 +27,11 @@ StepsChartScreen::StepsChartScreen(){};
 void StepsChartScreen::setup(uint8_t screen_num) {
   y_offset_ = 0;
   field_update_divider_ = kFieldUpdateRatio;
-  points_buffer_.clear();
+  columns_buffer_.clear();
+      column_accumulator_.reset();
   ui::create_screen(&screen_);
   ui::create_page_elements(screen_, "STEPS  CHART", screen_num, nullptr);
-  ui::create_chart(screen_, kNumPoints, 1, kAxisConfigsNormal,
+  ui::create_chart(screen_, 2 * kNumColumns, 1, kAxisConfigsNormal,
                    ui_events::UI_EVENT_SCALE, &chart_);
 
   ui::create_label(screen_, 110, 120, 293, "", ui::kFontNumericDataFields,
@@ -38,6 +39,8 @@ void StepsChartScreen::setup(uint8_t screen_num) {
 };
 
 void StepsChartScreen::on_load() {
+  // Drop the samples from before the screen was unloaded.
+      column_accumulator_.reset();
   // Force display update on first loop.
   display_update_elapsed_.set(kUpdateIntervalMillis + 1);
 };
@@ -51,7 +54,8 @@ void StepsChartScreen::on_event(ui_events::UiEventId ui_event_id) {
       y_offset_ = 0;
       field_update_divider_ = kFieldUpdateRatio;
       steps_field_.set_text("");
-      points_buffer_.clear();
+      columns_buffer_.clear();
+      column_accumulator_.reset();
       chart_.ser1.clear();
       break;
 
@@ -68,6 +72,10 @@ void StepsChartScreen::on_event(ui_events::UiEventId ui_event_id) {
 }
 
 void StepsChartScreen::loop() {
+  // Sample the steps at the loop rate, so moves that are shorter than
+  // a column are still shown.
+  column_accumulator_.add(acquisition::sample_full_steps());
+
   // We update at a fixed rate.
   if (display_update_elapsed_.elapsed_millis() < kUpdateIntervalMillis) {
     return;
@@ -76,39 +84,41 @@ void StepsChartScreen::loop() {
   // an error.
   display_update_elapsed_.advance(kUpdateIntervalMillis);
 
-  const acquisition::State* state = acquisition::sample_state();
-
-  int32_t abs_steps = state->full_steps;
-
-  // Shift the point into our local buffer.
-  *points_buffer_.insert() = abs_steps;
+  // Shift the column into our local buffer. The accumulator is
+  // not empty since we added a sample above.
+  const decimation::Envelope<int64_t> envelope =
+      column_accumulator_.envelope();
+      column_accumulator_.reset();
+  *columns_buffer_.insert() = {envelope.min, envelope.max};
 
+  const int64_t abs_steps = acquisition::sample_full_steps();
   if (++field_update_divider_ >= kFieldUpdateRatio) {
     field_update_divider_ = 0;
-    steps_field_.set_text_int(abs_steps);
+    steps_field_.set_text_int64(abs_steps);
   }
 
   const ui::Range& y_range = alternative_scale_
                                  ? kAxisConfigsAlternative.y_range
                                  : kAxisConfigsNormal.y_range;
 
-  // Adjust offset if value got out of chart range.
-  const int32_t rel_steps = abs_steps + y_offset_;
-  if (rel_steps > y_range.max) {
-    y_offset_ -= (rel_steps - y_range.max);
-  } else if (rel_steps < y_range.min) {
-    y_offset_ += (y_range.min - rel_steps);
+  // Adjust offset if the last column got out of chart range.
+  const int64_t rel_max = envelope.max + y_offset_;
+  const int64_t rel_min = envelope.min + y_offset_;
+  if (rel_max > y_range.max) {
+    y_offset_ -= (rel_max - y_range.max);
+  } else if (rel_min < y_range.min) {
+    y_offset_ += (y_range.min - rel_min);
   }
 
-  const uint16_t n = points_buffer_.size();
+  const uint16_t n = columns_buffer_.size();
 
+  lv_coord_t last_chart_val = columns_buffer_.get(0)->min + y_offset_;
   for (uint16_t i = 0; i < n; i++) {
-    const int32_t rel_point_steps = *points_buffer_.get(i) + y_offset_;
-
-    const lv_coord_t chart_val = rel_point_steps;
-
-    lv_chart_set_point_id(chart_.lv_chart, chart_.ser1.lv_series, chart_val, i);
+    const StepsColumn* column = columns_buffer_.get(i);
+    const lv_coord_t chart_min = column->min + y_offset_;
+    const lv_coord_t chart_max = column->max + y_offset_;
+    chart_.ser1.set_min_max(2 * i, chart_min, chart_max, &last_chart_val);
   }
 
   lv_chart_refresh(chart_.lv_chart);
-}
\ No newline at end of file
+}
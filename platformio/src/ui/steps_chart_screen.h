@@ -2,6 +2,7 @@
 
 #include "misc/elapsed.h"
 #include "misc/circular_buffer.h"
+#include "misc/decimation.h"
 #include "screen_manager.h"
 
 class StepsChartScreen : public screen_manager::Screen {
@@ -14,7 +15,13 @@ class StepsChartScreen : public screen_manager::Screen {
   virtual void on_event(ui_events::UiEventId ui_event_id) override;
 
  private:
-  static constexpr int16_t kNumPoints = 100;
+  // Each column is drawn as a vertical bar between the min and max
+  // steps during its time interval, with two chart points.
+  static constexpr int16_t kNumColumns = 100;
+  struct StepsColumn {
+    int64_t min;
+    int64_t max;
+  };
   Elapsed display_update_elapsed_;
   // Counter to update the steps field once every N chart updates.
   uint8_t field_update_divider_ = 0;
@@ -22,11 +29,13 @@ class StepsChartScreen : public screen_manager::Screen {
   ui::Chart chart_;
   // We add this value to the steps value to make the 
   // chart scroll vertically in case of a Y over/underflow.
-  int32_t y_offset_ = 0;
-  // We keep our own buffer of point values as int32. This
+  int64_t y_offset_ = 0;
+  // We keep our own buffer of column values as int64. This
   // way we don't risk an over/underflow if we will use the 
   // Chart's int16 point values when we rebase the Y range.
-  CircularBuffer<int32_t, kNumPoints> points_buffer_;
+  CircularBuffer<StepsColumn, kNumColumns> columns_buffer_;
+  // The steps sampled during the current column.
+  decimation::EnvelopeAccumulator<int64_t> column_accumulator_;
   bool alternative_scale_ = false;
 
 };
\ No newline at end of file
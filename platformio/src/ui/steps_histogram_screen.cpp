@@ -15,8 +15,10 @@ StepsHistorgramScreen::StepsHistorgramScreen(){};
 void StepsHistorgramScreen::setup(uint8_t screen_num) {
   ui::create_screen(&screen_);
   ui::create_page_elements(screen_, "STEPS BY STEPS/SEC", screen_num, nullptr);
-  ui::create_histogram(screen_, acquisition::kNumHistogramBuckets,
-                       kAxisConfigsNormal, &histogram_);
+  ui::create_histogram(screen_, histogram::kLinearNumBuckets,
+                       kAxisConfigsNormal, ui_events::UI_EVENT_SCALE,
+                       &histogram_);
+  zoom_.setup(kAxisConfigsNormal, &histogram_);
 };
 
 void StepsHistorgramScreen::on_load() {
@@ -30,7 +32,12 @@ void StepsHistorgramScreen::on_event(ui_events::UiEventId ui_event_id) {
   switch (ui_event_id) {
     case ui_events::UI_EVENT_RESET:
       acquisition::reset_state();
+      break;
 
+    case ui_events::UI_EVENT_SCALE:
+      zoom_.next_zoom();
+      // Force display update on next loop.
+      display_update_elapsed_.set(kUpdateIntervalMillis + 1);
       break;
 
     default:
@@ -47,19 +54,25 @@ void StepsHistorgramScreen::loop() {
 
   // Sample data and update screen.
   const acquisition::State* state = acquisition::sample_state();
-
-  // Find max steps in a bucket.
-  uint64_t max_steps = state->buckets[0].total_steps;
-  for (int i = 1; i < acquisition::kNumHistogramBuckets; i++) {
-    uint64_t steps = state->buckets[i].total_steps;
-    if (steps > max_steps) {
-      max_steps = steps;
+  zoom_.update(*state);
+  const int first_bucket = zoom_.first_bucket();
+  const int num_buckets = zoom_.num_buckets();
+
+  // Sample the buckets and find max steps in a bucket.
+  uint32_t bucket_steps[acquisition::kNumHistogramBuckets];
+  uint64_t max_steps = 0;
+  for (int i = 0; i < num_buckets; i++) {
+    acquisition::HistogramBucket bucket;
+    acquisition::sample_histogram_bucket(first_bucket + i, &bucket);
+    bucket_steps[i] = bucket.total_steps;
+    if (bucket_steps[i] > max_steps) {
+      max_steps = bucket_steps[i];
     }
   }
 
   // Update all the histogram points.
-  for (int i = 0; i < acquisition::kNumHistogramBuckets; i++) {
-    uint64_t steps = state->buckets[i].total_steps;
+  for (int i = 0; i < num_buckets; i++) {
+    uint64_t steps = bucket_steps[i];
     // Scale the value to [0, 100];
     uint16_t val = max_steps > 0 ? ((steps * 100) / max_steps) : 0;
 
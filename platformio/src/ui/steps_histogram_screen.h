@@ -1,5 +1,6 @@
 #pragma once
 
+#include "histogram_util.h"
 #include "misc/elapsed.h"
 #include "screen_manager.h"
 
@@ -15,4 +16,5 @@ class StepsHistorgramScreen : public screen_manager::Screen {
  private:
   Elapsed display_update_elapsed_;
   ui::Histogram histogram_;
+  histogram_util::HistogramZoom zoom_;
 };
\ No newline at end of file
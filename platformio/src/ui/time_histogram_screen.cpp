@@ -16,8 +16,10 @@ TimeHistogramScreen::TimeHistogramScreen(){};
 void TimeHistogramScreen::setup(uint8_t screen_num) {
   ui::create_screen(&screen_);
   ui::create_page_elements(screen_, "TIME BY STEPS/SEC", screen_num, nullptr);
-  ui::create_histogram(screen_, acquisition::kNumHistogramBuckets,
-                       kAxisConfigsNormal, &histogram_);
+  ui::create_histogram(screen_, histogram::kLinearNumBuckets,
+                       kAxisConfigsNormal, ui_events::UI_EVENT_SCALE,
+                       &histogram_);
+  zoom_.setup(kAxisConfigsNormal, &histogram_);
 };
 
 void TimeHistogramScreen::on_load() {
@@ -33,6 +35,12 @@ void TimeHistogramScreen::on_event(ui_events::UiEventId ui_event_id) {
       acquisition::reset_state();
       break;
 
+    case ui_events::UI_EVENT_SCALE:
+      zoom_.next_zoom();
+      // Force display update on next loop.
+      display_update_elapsed_.set(kUpdateIntervalMillis + 1);
+      break;
+
     default:
       break;
   }
@@ -47,19 +55,25 @@ void TimeHistogramScreen::loop() {
 
   // Sample data and update screen.
   const acquisition::State* state = acquisition::sample_state();
-
-  // Find max ticks in a bucket.
-  uint64_t max_ticks = state->buckets[0].total_ticks_in_steps;
-  for (int i = 1; i < acquisition::kNumHistogramBuckets; i++) {
-    uint64_t ticks = state->buckets[i].total_ticks_in_steps;
-    if (ticks > max_ticks) {
-      max_ticks = ticks;
+  zoom_.update(*state);
+  const int first_bucket = zoom_.first_bucket();
+  const int num_buckets = zoom_.num_buckets();
+
+  // Sample the buckets and find max ticks in a bucket.
+  uint64_t bucket_ticks[acquisition::kNumHistogramBuckets];
+  uint64_t max_ticks = 0;
+  for (int i = 0; i < num_buckets; i++) {
+    acquisition::HistogramBucket bucket;
+    acquisition::sample_histogram_bucket(first_bucket + i, &bucket);
+    bucket_ticks[i] = bucket.total_ticks_in_steps;
+    if (bucket_ticks[i] > max_ticks) {
+      max_ticks = bucket_ticks[i];
     }
   }
 
   // Update all the histogram points.
-  for (int i = 0; i < acquisition::kNumHistogramBuckets; i++) {
-    uint64_t ticks = state->buckets[i].total_ticks_in_steps;
+  for (int i = 0; i < num_buckets; i++) {
+    uint64_t ticks = bucket_ticks[i];
     // Scale the value to [0, 100];
     uint16_t val = max_ticks > 0 ? ((ticks * 100) / max_ticks) : 0;
 
@@ -50,7 +50,7 @@ struct PolarChartStyles {
 
 static PolarChartStyles polar_chart_styles;
 
-static char temp_text_buffer[20];
+static char temp_text_buffer[kInt64TextSize];
 
 const lv_font_t* const kFontSmallText = &font_montserrat_alphanum_12;
 const lv_font_t* const kFontPageTitles = &font_montserrat_alphanum_16;
@@ -537,9 +537,134 @@ void create_polar_chart(const Screen& screen,
   polar_chart->lv_line = lv_line;
 }
 
+void Histogram::set_scale(const ChartAxisConfigs& axis_configs) {
+  set_chart_scale(lv_chart, axis_configs);
+  y_range = axis_configs.y_range;
+  lv_chart_refresh(lv_chart);
+}
+
+// Histograms with error bars. LVGL user data is disabled so we
+// find the histogram of a chart object by a lookup in this table.
+static const Histogram* error_bar_histograms[kMaxErrorBarHistograms] = {};
+
+// The original chart design function, called before drawing the
+// error bars.
+static lv_design_cb_t chart_ancestor_design_cb = nullptr;
+
+// Maps a histogram y value to a screen y coordinate.
+static lv_coord_t map_histogram_y(const Histogram& histogram,
+                                  const lv_area_t& area, lv_coord_t value) {
+  const Range& r = histogram.y_range;
+  const lv_coord_t height = lv_area_get_height(&area);
+  value = max(r.min, min(r.max, value));
+  return area.y2 - (int32_t)(value - r.min) * height / (r.max - r.min);
+}
+
+static void draw_vertical_line(lv_coord_t x, lv_coord_t y1, lv_coord_t y2,
+                               const lv_area_t* clip_area,
+                               const lv_draw_line_dsc_t& dsc) {
+  const lv_point_t p1 = {x, y1};
+  const lv_point_t p2 = {x, y2};
+  lv_draw_line(&p1, &p2, clip_area, &dsc);
+}
+
+static lv_design_res_t error_bars_design_cb(lv_obj_t* lv_chart,
+                                            const lv_area_t* clip_area,
+                                            lv_design_mode_t mode) {
+  const lv_design_res_t result =
+      chart_ancestor_design_cb(lv_chart, clip_area, mode);
+  if (mode != LV_DESIGN_DRAW_MAIN) {
+    return result;
+  }
+
+  const Histogram* histogram = nullptr;
+  for (int i = 0; i < kMaxErrorBarHistograms; i++) {
+    if (error_bar_histograms[i] &&
+        error_bar_histograms[i]->lv_chart == lv_chart) {
+      histogram = error_bar_histograms[i];
+      break;
+    }
+  }
+  if (!histogram || !histogram->error_bars) {
+    return result;
+  }
+
+  lv_area_t area;
+  lv_chart_get_series_area(lv_chart, &area);
+  const uint16_t n = lv_chart_get_point_count(lv_chart);
+  const lv_coord_t width = lv_area_get_width(&area);
+  // Half of the column width. Matches the layout of column charts.
+  const lv_coord_t half_column = width / (4 * n);
+
+  lv_draw_line_dsc_t whisker_dsc;
+  lv_draw_line_dsc_init(&whisker_dsc);
+  whisker_dsc.color = LV_COLOR_SILVER;
+  whisker_dsc.width = 1;
+
+  lv_draw_line_dsc_t bar_dsc;
+  lv_draw_line_dsc_init(&bar_dsc);
+  bar_dsc.color = LV_COLOR_RED;
+  bar_dsc.width = half_column > 1 ? half_column : 1;
+
+  lv_draw_line_dsc_t tick_dsc;
+  lv_draw_line_dsc_init(&tick_dsc);
+  tick_dsc.color = LV_COLOR_WHITE;
+  tick_dsc.width = 2;
+
+  for (uint16_t i = 0; i < n; i++) {
+    const ErrorBar& bar = histogram->error_bars[i];
+    if (bar.min > bar.max) {
+      continue;
+    }
+    // Center of the column.
+    const lv_coord_t x =
+        area.x1 + (int32_t)width * i / n + width / (2 * n);
+    draw_vertical_line(x, map_histogram_y(*histogram, area, bar.max),
+                       map_histogram_y(*histogram, area, bar.min), clip_area,
+                       whisker_dsc);
+    draw_vertical_line(x, map_histogram_y(*histogram, area, bar.high),
+                       map_histogram_y(*histogram, area, bar.low), clip_area,
+                       bar_dsc);
+    const lv_coord_t y_mid = map_histogram_y(*histogram, area, bar.mid);
+    const lv_point_t p1 = {(lv_coord_t)(x - half_column), y_mid};
+    const lv_point_t p2 = {(lv_coord_t)(x + half_column), y_mid};
+    lv_draw_line(&p1, &p2, clip_area, &tick_dsc);
+  }
+
+  return result;
+}
+
+void Histogram::set_error_bars(const ErrorBar* bars) {
+  error_bars = bars;
+
+  for (int i = 0; i < kMaxErrorBarHistograms; i++) {
+    if (error_bar_histograms[i] == this) {
+      return;
+    }
+  }
+  for (int i = 0; i < kMaxErrorBarHistograms; i++) {
+    if (!error_bar_histograms[i]) {
+      error_bar_histograms[i] = this;
+      // All charts share the same ancestor design function.
+      if (!chart_ancestor_design_cb) {
+        chart_ancestor_design_cb = lv_obj_get_design_cb(lv_chart);
+      }
+      lv_obj_set_design_cb(lv_chart, error_bars_design_cb);
+      return;
+    }
+  }
+  // Registry is full. Error bars are not drawn.
+}
+
+void Histogram::set_num_columns(uint16_t num_columns) {
+  if (lv_chart_get_point_count(lv_chart) != num_columns) {
+    lv_chart_set_point_count(lv_chart, num_columns);
+  }
+}
+
 void create_histogram(const Screen& screen, uint16_t num_columns,
                       const ChartAxisConfigs& axis_configs,
-                      Histogram* histogram) {
+                      ui_events::UiEventId ui_event_id, Histogram* histogram) {
   init_styles_if_needed();
 
   lv_obj_t* lv_chart = lv_chart_create(screen.lv_screen, NULL);
@@ -551,6 +676,12 @@ void create_histogram(const Screen& screen, uint16_t num_columns,
 
   lv_chart_set_point_count(lv_chart, num_columns);
 
+  if (ui_event_id != ui_events::UI_EVENT_NONE) {
+    lv_obj_set_click(lv_chart, true);
+    const lv_event_cb_t event_cb = ui_events::get_event_handler(ui_event_id);
+    lv_obj_set_event_cb(lv_chart, event_cb);
+  }
+
   // Add a data series.
   lv_chart_series_t* lv_series = lv_chart_add_series(lv_chart, LV_COLOR_YELLOW);
 
@@ -567,6 +698,7 @@ void create_histogram(const Screen& screen, uint16_t num_columns,
 
   histogram->lv_chart = lv_chart;
   histogram->lv_series = lv_series;
+  histogram->y_range = axis_configs.y_range;
 }
 
 void create_page_title(const Screen& screen, const char* title, Label* label) {
@@ -627,6 +759,27 @@ static void init_styles_if_needed() {
   }
 }
 
+char* format_int64(int64_t value, char* bfr) {
+  // Digits are generated in reverse order, from the end of the buffer.
+  char tmp[kInt64TextSize];
+  char* p = tmp + sizeof(tmp);
+  *--p = 0;
+  uint64_t u = value < 0 ? -(uint64_t)value : value;
+  do {
+    *--p = '0' + (u % 10);
+    u /= 10;
+  } while (u);
+  if (value < 0) {
+    *--p = '-';
+  }
+  strcpy(bfr, p);
+  return bfr;
+}
+
+void Label::set_text_int64(int64_t i) {
+  lv_label_set_text(lv_label, format_int64(i, temp_text_buffer));
+}
+
 void Label::set_text_float(double f, uint8_t precision) {
   dtostrf(f, 0, precision, temp_text_buffer);
   // TODO: find a conversion method that doesn't return negative
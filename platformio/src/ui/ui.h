@@ -49,6 +49,7 @@ struct Label {
   void set_text_int(int32_t i) { lv_label_set_text_fmt(lv_label, "%d", i); }
 
   void set_text_uint(uint32_t u) { lv_label_set_text_fmt(lv_label, "%u", u); }
+  void set_text_int64(int64_t i);
   void set_text(const char* s) { lv_label_set_text(lv_label, s); }
   void set_text_float(double f, uint8_t precision);
   void set_text_color(lv_color_t text_color) {
@@ -118,6 +119,18 @@ struct ChartSeries {
     fill_counter = 0;
   }
 
+  // Draws a vertical bar from min to max with the points i and i + 1,
+  // for the envelope of decimated data. The order of min and max is
+  // the one closer to *last, the value of the previous point, for a
+  // continuous line. Sets *last to the value of point i + 1.
+  void set_min_max(uint16_t i, lv_coord_t min, lv_coord_t max,
+                   lv_coord_t* last) {
+    const bool min_first = abs(*last - min) <= abs(*last - max);
+    lv_chart_set_point_id(lv_chart, lv_series, min_first ? min : max, i);
+    lv_chart_set_point_id(lv_chart, lv_series, min_first ? max : min, i + 1);
+    *last = min_first ? max : min;
+  }
+
  private:
   bool filled = false;
   uint16_t fill_counter = 0;
@@ -131,11 +144,35 @@ struct Chart {
   void set_scale(const ChartAxisConfigs& axis_configs);
 };
 
+// Error bar of a histogram column, in histogram y units. Drawn as a
+// thin whisker from min to max, a wide bar from low to high and a
+// tick at mid. Not drawn if min > max.
+struct ErrorBar {
+  lv_coord_t min;
+  lv_coord_t low;
+  lv_coord_t mid;
+  lv_coord_t high;
+  lv_coord_t max;
+};
+
 struct Histogram {
   lv_obj_t* lv_chart = nullptr;
   lv_chart_series_t* lv_series = nullptr;
+  // The y range of the current scale.
+  Range y_range;
+  // Optional error bars, one per column. See set_error_bars().
+  const ErrorBar* error_bars = nullptr;
+
+  void set_scale(const ChartAxisConfigs& axis_configs);
+  void set_num_columns(uint16_t num_columns);
+  // Draw error bars over the columns. 'error_bars' should have an
+  // entry for each column and is read when the histogram is redrawn.
+  // Up to kMaxErrorBarHistograms histograms can have error bars.
+  void set_error_bars(const ErrorBar* error_bars);
 };
 
+constexpr int kMaxErrorBarHistograms = 2;
+
 struct PolarChart {
   lv_coord_t max_radius;
   lv_obj_t* lv_chart = nullptr;
@@ -176,12 +213,21 @@ extern void create_checkbox(const Screen& screen, lv_coord_t x, lv_coord_t y,
                             ui_events::UiEventId ui_event_id,
                             Checkbox* checkbox);
 
+// Buffer size for format_int64().
+constexpr int kInt64TextSize = 21;
+
+// Format a signed 64 bits value in decimal. 'bfr' should have at
+// least kInt64TextSize chars. Returns 'bfr'. The printf we use
+// doesn't support 64 bits values.
+extern char* format_int64(int64_t value, char* bfr);
+
 extern void create_chart(const Screen& screen, uint16_t num_points,
                          int num_series, const ChartAxisConfigs& axis_configs,
                          ui_events::UiEventId ui_event_id, Chart* chart);
 
 extern void create_histogram(const Screen& screen, uint16_t num_columns,
                              const ChartAxisConfigs& axis_configs,
+                             ui_events::UiEventId ui_event_id,
                              Histogram* histogram);
 
 // If 'lable' is null it is ignored.
@@ -62,10 +62,42 @@ static void event_handler_direction(lv_obj_t* obj, lv_event_t event) {
   common_event_handler(obj, event, UI_EVENT_DIRECTION);
 }
 
+static void event_handler_adaptive_threshold(lv_obj_t* obj, lv_event_t event) {
+  common_event_handler(obj, event, UI_EVENT_ADAPTIVE_THRESHOLD);
+}
+
+static void event_handler_histogram_scale(lv_obj_t* obj, lv_event_t event) {
+  common_event_handler(obj, event, UI_EVENT_HISTOGRAM_SCALE);
+}
+
+static void event_handler_oversampling(lv_obj_t* obj, lv_event_t event) {
+  common_event_handler(obj, event, UI_EVENT_OVERSAMPLING);
+}
+
 static void event_handler_scale(lv_obj_t* obj, lv_event_t event) {
   common_event_handler(obj, event, UI_EVENT_SCALE);
 }
 
+static void event_handler_zoom_in(lv_obj_t* obj, lv_event_t event) {
+  common_event_handler(obj, event, UI_EVENT_ZOOM_IN);
+}
+
+static void event_handler_zoom_out(lv_obj_t* obj, lv_event_t event) {
+  common_event_handler(obj, event, UI_EVENT_ZOOM_OUT);
+}
+
+static void event_handler_pan_left(lv_obj_t* obj, lv_event_t event) {
+  common_event_handler(obj, event, UI_EVENT_PAN_LEFT);
+}
+
+static void event_handler_pan_right(lv_obj_t* obj, lv_event_t event) {
+  common_event_handler(obj, event, UI_EVENT_PAN_RIGHT);
+}
+
+static void event_handler_axis(lv_obj_t* obj, lv_event_t event) {
+  common_event_handler(obj, event, UI_EVENT_AXIS);
+}
+
 static void event_handler_debug(lv_obj_t* obj, lv_event_t event) {
   common_event_handler(obj, event, UI_EVENT_DEBUG);
 }
@@ -96,8 +128,24 @@ extern lv_event_cb_t get_event_handler(UiEventId ui_event_id) {
       return event_handler_zero_calibration;
     case UI_EVENT_DIRECTION:
       return event_handler_direction;
+    case UI_EVENT_ADAPTIVE_THRESHOLD:
+      return event_handler_adaptive_threshold;
+    case UI_EVENT_HISTOGRAM_SCALE:
+      return event_handler_histogram_scale;
+    case UI_EVENT_OVERSAMPLING:
+      return event_handler_oversampling;
     case UI_EVENT_SCALE:
       return event_handler_scale;
+    case UI_EVENT_ZOOM_IN:
+      return event_handler_zoom_in;
+    case UI_EVENT_ZOOM_OUT:
+      return event_handler_zoom_out;
+    case UI_EVENT_PAN_LEFT:
+      return event_handler_pan_left;
+    case UI_EVENT_PAN_RIGHT:
+      return event_handler_pan_right;
+    case UI_EVENT_AXIS:
+      return event_handler_axis;
     case UI_EVENT_DEBUG:
       return event_handler_debug;
     case UI_EVENT_SCREENSHOT:
@@ -15,7 +15,15 @@ enum UiEventId {
   UI_EVENT_CAPTURE,
   UI_EVENT_ZERO_CALIBRATION,
   UI_EVENT_DIRECTION,
+  UI_EVENT_ADAPTIVE_THRESHOLD,
+  UI_EVENT_HISTOGRAM_SCALE,
+  UI_EVENT_OVERSAMPLING,
   UI_EVENT_SCALE,
+  UI_EVENT_ZOOM_IN,
+  UI_EVENT_ZOOM_OUT,
+  UI_EVENT_PAN_LEFT,
+  UI_EVENT_PAN_RIGHT,
+  UI_EVENT_AXIS,
   UI_EVENT_DEBUG,
   UI_EVENT_SCREENSHOT,
 };
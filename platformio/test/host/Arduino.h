@@ -0,0 +1,50 @@
+// A stand in for the Arduino core header in the host tests. Provides
+// the C library headers that the firmware gets via Arduino.h, a
+// fake millis() clock that the tests advance, and a Serial that
+// discards its output.
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PI 3.1415926535897932384626433832795
+
+namespace host {
+
+// The value that millis() returns.
+inline uint32_t& fake_millis() {
+  static uint32_t value = 0;
+  return value;
+}
+
+}  // namespace host
+
+inline uint32_t millis() { return host::fake_millis(); }
+
+// Same as the Arduino min() and max(), for arguments of the same type.
+template <class T>
+inline T min(T a, T b) {
+  return b < a ? b : a;
+}
+
+template <class T>
+inline T max(T a, T b) {
+  return a < b ? b : a;
+}
+
+// Discards the Serial output.
+struct HostSerial {
+  template <class... Args>
+  void printf(const char*, Args...) {}
+  template <class T>
+  void print(T) {}
+  template <class T>
+  void println(T) {}
+  void println() {}
+};
+
+static HostSerial Serial;
@@ -0,0 +1,73 @@
+// Synthetic coil current traces for the host tests, of a stepper that
+// is driven with sine and cosine coil currents, with noise. Faults are
+// injected by changing the segments, and the phase, on the fly.
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+namespace coil_trace {
+
+// 12 bit ADC, 0.4V per amp, 3.3V full scale.
+constexpr double kCountsPerAmp = 0.4 * 4096 / 3.3;
+
+// Samples per second, same as the acquisition ticks.
+constexpr double kTicksPerSecond = 100000;
+
+// A segment of a coil current trace.
+struct Segment {
+  uint32_t ticks;
+  // Coil current amplitude. Zero if not energized.
+  double amps;
+  // Electrical cycles per second. A full step is a quarter of a cycle.
+  double hz;
+  // The coil 2 amplitude relative to coil 1. Other values than 1
+  // distort the circular current trajectory to an ellipse, e.g. as a
+  // high back-EMF does.
+  double coil2_ratio = 1;
+};
+
+// Generates the zero based ADC counts of the two coils, a tick at a
+// time.
+class Generator {
+ public:
+  // offset_counts is a zero calibration error of both channels.
+  explicit Generator(double noise_counts, double offset_counts = 0)
+      : noise_counts_(noise_counts), offset_counts_(offset_counts) {}
+
+  // Advance by one tick of the segment and return the counts of the
+  // two coils.
+  void next(const Segment& segment, int* v1, int* v2) {
+    phase_ += segment.hz / kTicksPerSecond;
+    const double amplitude = segment.amps * kCountsPerAmp;
+    *v1 = (int)lround(amplitude * cos(2 * M_PI * phase_) + offset_counts_ +
+                      noise());
+    *v2 = (int)lround(amplitude * segment.coil2_ratio *
+                          sin(2 * M_PI * phase_) +
+                      offset_counts_ + noise());
+  }
+
+  // Current phase in electrical cycles.
+  double phase() const { return phase_; }
+  void set_phase(double phase) { phase_ = phase; }
+
+ private:
+  // Approximately normal noise, from the sum of 4 uniform values.
+  double noise() {
+    double sum = 0;
+    for (int i = 0; i < 4; i++) {
+      rand_state_ = rand_state_ * 1664525 + 1013904223;
+      sum += (rand_state_ >> 8) / (double)(1 << 24) - 0.5;
+    }
+    // The sum has a variance of 1/3.
+    return sum * sqrt(3.0) * noise_counts_;
+  }
+
+  const double noise_counts_;
+  const double offset_counts_;
+  double phase_ = 0;
+  uint32_t rand_state_ = 1;
+};
+
+}  // namespace coil_trace
@@ -0,0 +1,99 @@
+// A block device over a host file, for the host tests of the
+// recorder. Writes take a few status() calls to complete, like a
+// background write of a real device, and failures and power losses
+// can be injected. The file is a raw image of the device, in the
+// format that tools/recorder_reader.py reads.
+
+#pragma once
+
+#include <stdio.h>
+
+#include "misc/block_device.h"
+
+class FileBlockDevice : public block_device::BlockDevice {
+ public:
+  static constexpr uint32_t kBlockSize = 512;
+
+  // Opens the image file. If create, creates a new image of
+  // num_blocks erased blocks, else opens an existing one.
+  FileBlockDevice(const char* path, uint32_t num_blocks, bool create)
+      : num_blocks_(num_blocks) {
+    file_ = fopen(path, create ? "w+b" : "r+b");
+    if (file_ && create) {
+      uint8_t block[kBlockSize];
+      memset(block, 0xff, sizeof(block));
+      for (uint32_t i = 0; i < num_blocks; i++) {
+        fwrite(block, 1, sizeof(block), file_);
+      }
+      fflush(file_);
+    }
+  }
+
+  ~FileBlockDevice() {
+    if (file_) {
+      fclose(file_);
+    }
+  }
+
+  bool is_open() const { return file_ != nullptr; }
+
+  uint32_t block_size() const override { return kBlockSize; }
+
+  uint32_t num_blocks() const override { return num_blocks_; }
+
+  bool read(uint32_t block, uint8_t* data) override {
+    return file_ && block < num_blocks_ &&
+           fseek(file_, block * kBlockSize, SEEK_SET) == 0 &&
+           fread(data, 1, kBlockSize, file_) == kBlockSize;
+  }
+
+  void start_write(uint32_t block, const uint8_t* data) override {
+    pending_block_ = block;
+    pending_data_ = data;
+    busy_polls_ = kWritePolls;
+    status_ = block_device::WRITE_BUSY;
+  }
+
+  block_device::WriteStatus status() override {
+    if (status_ != block_device::WRITE_BUSY || --busy_polls_ > 0) {
+      return status_;
+    }
+    num_writes_++;
+    if (fail_every_ && num_writes_ % fail_every_ == 0) {
+      status_ = block_device::WRITE_ERROR;
+      return status_;
+    }
+    // A power loss leaves the first bytes of the block written.
+    const uint32_t size = power_lost_ ? 40 : kBlockSize;
+    const bool ok = file_ && pending_block_ < num_blocks_ &&
+                    fseek(file_, pending_block_ * kBlockSize, SEEK_SET) == 0 &&
+                    fwrite(pending_data_, 1, size, file_) == size;
+    fflush(file_);
+    status_ = ok ? block_device::WRITE_OK : block_device::WRITE_ERROR;
+    return status_;
+  }
+
+  // Fail every nth write, or none if zero.
+  void set_fail_every(uint32_t n) { fail_every_ = n; }
+
+  // From now on, writes are partial, as when the power is lost while
+  // writing.
+  void set_power_lost() { power_lost_ = true; }
+
+  // Number of completed or failed writes.
+  uint32_t num_writes() const { return num_writes_; }
+
+ private:
+  // Number of status() calls until a write completes.
+  static constexpr int kWritePolls = 3;
+
+  FILE* file_ = nullptr;
+  const uint32_t num_blocks_;
+  block_device::WriteStatus status_ = block_device::WRITE_OK;
+  uint32_t pending_block_ = 0;
+  const uint8_t* pending_data_ = nullptr;
+  int busy_polls_ = 0;
+  uint32_t num_writes_ = 0;
+  uint32_t fail_every_ = 0;
+  bool power_lost_ = false;
+};
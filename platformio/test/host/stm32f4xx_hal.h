@@ -0,0 +1,50 @@
+// A stand in for the STM32 HAL header in the host tests. Provides the
+// few definitions that the hal/ headers of the acquisition module use,
+// so its interrupt routine can be fed with synthetic ADC samples. The
+// GPIO writes go to RAM.
+
+#pragma once
+
+#include <stdint.h>
+
+struct GPIO_TypeDef {
+  uint32_t BSRR;
+};
+
+namespace host {
+
+inline GPIO_TypeDef* fake_gpio_port(int index) {
+  static GPIO_TypeDef ports[3];
+  return &ports[index];
+}
+
+}  // namespace host
+
+#define GPIOA (host::fake_gpio_port(0))
+#define GPIOB (host::fake_gpio_port(1))
+#define GPIOC (host::fake_gpio_port(2))
+
+#define GPIO_PIN_0 ((uint16_t)0x0001)
+#define GPIO_PIN_1 ((uint16_t)0x0002)
+#define GPIO_PIN_2 ((uint16_t)0x0004)
+#define GPIO_PIN_3 ((uint16_t)0x0008)
+#define GPIO_PIN_4 ((uint16_t)0x0010)
+#define GPIO_PIN_5 ((uint16_t)0x0020)
+#define GPIO_PIN_6 ((uint16_t)0x0040)
+#define GPIO_PIN_7 ((uint16_t)0x0080)
+#define GPIO_PIN_8 ((uint16_t)0x0100)
+#define GPIO_PIN_9 ((uint16_t)0x0200)
+#define GPIO_PIN_10 ((uint16_t)0x0400)
+#define GPIO_PIN_11 ((uint16_t)0x0800)
+#define GPIO_PIN_12 ((uint16_t)0x1000)
+#define GPIO_PIN_13 ((uint16_t)0x2000)
+#define GPIO_PIN_14 ((uint16_t)0x4000)
+#define GPIO_PIN_15 ((uint16_t)0x8000)
+
+struct ADC_HandleTypeDef {};
+struct DMA_HandleTypeDef {};
+struct TIM_HandleTypeDef {};
+
+// The host tests have no interrupts.
+inline void __disable_irq() {}
+inline void __enable_irq() {}
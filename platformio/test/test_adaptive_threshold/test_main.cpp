@@ -0,0 +1,139 @@
+// Tests of the adaptive energized thresholds. Coil current traces of
+// various current and noise levels are replayed through the threshold
+// tracking, in the same order as the acquisition interrupt routine,
+// and the decoded energized state is compared to the trace's.
+
+#include <unity.h>
+
+#include "analyzer/adaptive_threshold.h"
+#include "coil_trace.h"
+
+void setUp() {}
+void tearDown() {}
+
+using coil_trace::Segment;
+
+// Replays a trace through an AdaptiveThreshold and counts the
+// samples whose decoded state is wrong.
+class Replay {
+ public:
+  // offset_counts is a zero calibration error of both channels.
+  Replay(double noise_counts, double offset_counts = 0)
+      : trace_(noise_counts, offset_counts) {
+    threshold_.update(&energized_threshold_, &non_energized_threshold_);
+  }
+
+  // Replay a segment. Samples in the first settle_ticks are not
+  // checked. Returns the number of wrong samples.
+  uint32_t play(const Segment& segment, uint32_t settle_ticks) {
+    uint32_t errors = 0;
+    const bool expected = segment.amps > 0;
+    for (uint32_t i = 0; i < segment.ticks; i++) {
+      tick_++;
+      if ((tick_ & ((1 << adaptive_threshold::kUpdateTicksBits) - 1)) == 0) {
+        threshold_.update(&energized_threshold_, &non_energized_threshold_);
+      }
+      int v1;
+      int v2;
+      trace_.next(segment, &v1, &v2);
+      const uint16_t total_current = abs(v1) + abs(v2);
+      is_energized_ = adaptive_threshold::is_energized(
+          is_energized_, total_current, energized_threshold_,
+          non_energized_threshold_);
+      threshold_.track_total_current(total_current, non_energized_threshold_);
+      if (is_energized_) {
+        threshold_.track_max_current(abs(v1) > abs(v2) ? abs(v1) : abs(v2));
+      }
+      if (i >= settle_ticks && is_energized_ != expected) {
+        errors++;
+      }
+    }
+    return errors;
+  }
+
+  const adaptive_threshold::AdaptiveThreshold& threshold() const {
+    return threshold_;
+  }
+
+ private:
+  coil_trace::Generator trace_;
+  adaptive_threshold::AdaptiveThreshold threshold_;
+  uint16_t energized_threshold_ = 0;
+  uint16_t non_energized_threshold_ = 0;
+  bool is_energized_ = false;
+  uint32_t tick_ = 0;
+};
+
+// 100ms settle time after each transition.
+static constexpr uint32_t kSettleTicks = 10000;
+
+void test_current_levels() {
+  const double kAmps[] = {0.1, 0.25, 0.5, 1.0, 2.0};
+  const double kNoiseCounts[] = {2, 5, 10};
+  for (double amps : kAmps) {
+    for (double noise_counts : kNoiseCounts) {
+      // The min threshold is about 6.4x the noise level, so lower
+      // currents are not detectable.
+      if (amps * coil_trace::kCountsPerAmp < 8 * noise_counts) {
+        continue;
+      }
+      Replay replay(noise_counts);
+      uint32_t errors = replay.play({50000, 0, 0}, kSettleTicks);
+      // Moving, holding, moving again, off.
+      errors += replay.play({100000, amps, 200}, kSettleTicks);
+      errors += replay.play({100000, amps, 0}, 0);
+      errors += replay.play({100000, amps, 1000}, 0);
+      errors += replay.play({100000, 0, 0}, kSettleTicks);
+      char message[80];
+      snprintf(message, sizeof(message), "%.2fA, noise %.0f counts: %u errors",
+               amps, noise_counts, errors);
+      TEST_ASSERT_EQUAL_MESSAGE(0, errors, message);
+    }
+  }
+}
+
+void test_idle_current_reduction() {
+  // Drivers that reduce the current by 50% when idle stay energized.
+  Replay replay(5);
+  replay.play({50000, 1.0, 500}, 0);
+  TEST_ASSERT_EQUAL(0, replay.play({200000, 0.5, 0}, 0));
+}
+
+void test_noise_floor_adapts_down() {
+  Replay replay(2);
+  replay.play({100000, 0, 0}, 0);
+  TEST_ASSERT_LESS_OR_EQUAL(5, replay.threshold().noise_floor());
+}
+
+void test_offset_at_power_up() {
+  // A zero calibration error and noise that are above the initial non
+  // energized threshold would latch the energized state if the
+  // thresholds started from a zero noise floor, and the noise floor
+  // would not be tracked while latched.
+  Replay replay(3, 35);
+  TEST_ASSERT_EQUAL(0, replay.play({300000, 0, 0}, 0));
+  // The noise floor includes the offset.
+  TEST_ASSERT_GREATER_OR_EQUAL(60, replay.threshold().noise_floor());
+  // And a real current is still detected.
+  TEST_ASSERT_EQUAL(0, replay.play({100000, 1.0, 500}, kSettleTicks));
+  TEST_ASSERT_EQUAL(0, replay.play({100000, 0, 0}, kSettleTicks));
+}
+
+void test_startup_transient() {
+  // A transient at power up latches the energized state, and then
+  // decays to the noise level.
+  Replay replay(20);
+  replay.play({100, 3.0, 0}, 0);
+  TEST_ASSERT_EQUAL(0, replay.play({300000, 0, 0}, 50000));
+  TEST_ASSERT_EQUAL(0, replay.play({100000, 1.0, 500}, kSettleTicks));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_current_levels);
+  RUN_TEST(test_idle_current_reduction);
+  RUN_TEST(test_noise_floor_adapts_down);
+  RUN_TEST(test_offset_at_power_up);
+  RUN_TEST(test_startup_transient);
+  return UNITY_END();
+}
@@ -0,0 +1,212 @@
+// Tests of the chart decimation and of the oscilloscope's min/max
+// pyramid, against brute force min/max/mean computations, and a host
+// benchmark of the decimation of 1M samples.
+
+#include <time.h>
+#include <unity.h>
+
+#include "analyzer/min_max_pyramid.cpp"
+
+void setUp() {}
+void tearDown() {}
+
+static uint32_t rand_state = 1;
+
+// A random value in [-range, range].
+static int16_t random_value(int16_t range) {
+  rand_state = rand_state * 1664525 + 1013904223;
+  return (int16_t)((rand_state >> 8) % (2 * range + 1)) - range;
+}
+
+// Checks the columns of decimate() over random samples.
+static void check_decimate(uint32_t n, uint16_t w) {
+  static int16_t samples[5000];
+  TEST_ASSERT_TRUE(n <= sizeof(samples) / sizeof(samples[0]));
+  for (uint32_t j = 0; j < n; j++) {
+    samples[j] = random_value(2000);
+  }
+
+  uint16_t next_column = 0;
+  uint32_t next_sample = 0;
+  decimation::decimate<int16_t>(
+      n, w,
+      [&](uint32_t j) {
+        // Each sample is read once, in order.
+        TEST_ASSERT_EQUAL(next_sample, j);
+        next_sample++;
+        return samples[j];
+      },
+      [&](uint16_t i, const decimation::Envelope<int16_t>& envelope) {
+        TEST_ASSERT_EQUAL(next_column, i);
+        next_column++;
+        // Column i covers [i * n / w, (i + 1) * n / w).
+        const uint32_t start = (uint64_t)i * n / w;
+        const uint32_t end = (uint64_t)(i + 1) * n / w;
+        int16_t min = samples[start];
+        int16_t max = samples[start];
+        int64_t sum = 0;
+        for (uint32_t j = start; j < end; j++) {
+          min = samples[j] < min ? samples[j] : min;
+          max = samples[j] > max ? samples[j] : max;
+          sum += samples[j];
+        }
+        TEST_ASSERT_EQUAL(min, envelope.min);
+        TEST_ASSERT_EQUAL(max, envelope.max);
+        TEST_ASSERT_EQUAL(sum / (int64_t)(end - start), envelope.mean);
+      });
+  TEST_ASSERT_EQUAL(w, next_column);
+  TEST_ASSERT_EQUAL(n, next_sample);
+}
+
+void test_decimate() {
+  // Whole and fractional samples per column.
+  check_decimate(1000, 100);
+  check_decimate(1000, 333);
+  check_decimate(4999, 480);
+  check_decimate(479, 478);
+  // One sample per column.
+  check_decimate(200, 200);
+  // A single column.
+  check_decimate(17, 1);
+}
+
+// A sample of a long sequence. A slow sine with a spike every 1000
+// samples.
+static int16_t long_sample(uint32_t j) {
+  const int16_t spike = (j % 1000 == 17) ? 1000 : 0;
+  return (int16_t)(1000 * sin(j * 0.0001)) + spike;
+}
+
+void test_decimate_1m_samples() {
+  const uint32_t n = 1000000;
+  const uint16_t w = 480;
+  // Precomputed so the benchmark measures only the decimation.
+  static int16_t samples[n];
+  for (uint32_t j = 0; j < n; j++) {
+    samples[j] = long_sample(j);
+  }
+  uint16_t num_columns = 0;
+  int16_t max_max = -32768;
+  const clock_t start = clock();
+  decimation::decimate<int16_t>(
+      n, w, [&](uint32_t j) { return samples[j]; },
+      [&](uint16_t i, const decimation::Envelope<int16_t>& envelope) {
+        num_columns++;
+        max_max = envelope.max > max_max ? envelope.max : max_max;
+      });
+  const double usecs = 1e6 * (clock() - start) / CLOCKS_PER_SEC;
+  char message[100];
+  snprintf(message, sizeof(message),
+           "%u samples to %u columns, %.2f nsecs per sample on the host", n,
+           w, 1000 * usecs / n);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_EQUAL(w, num_columns);
+  // The spikes are kept.
+  TEST_ASSERT_EQUAL(1999, max_max);
+
+  // And a few columns match a brute force computation.
+  decimation::decimate<int16_t>(
+      n, w, long_sample,
+      [&](uint16_t i, const decimation::Envelope<int16_t>& envelope) {
+        if (i % 97 != 0) {
+          return;
+        }
+        const uint32_t start = (uint64_t)i * n / w;
+        const uint32_t end = (uint64_t)(i + 1) * n / w;
+        int16_t min = long_sample(start);
+        int16_t max = min;
+        int64_t sum = 0;
+        for (uint32_t j = start; j < end; j++) {
+          const int16_t v = long_sample(j);
+          min = v < min ? v : min;
+          max = v > max ? v : max;
+          sum += v;
+        }
+        TEST_ASSERT_EQUAL(min, envelope.min);
+        TEST_ASSERT_EQUAL(max, envelope.max);
+        TEST_ASSERT_EQUAL(sum / (int64_t)(end - start), envelope.mean);
+      });
+}
+
+void test_envelope_accumulator() {
+  decimation::EnvelopeAccumulator<int64_t> accumulator;
+  TEST_ASSERT_TRUE(accumulator.is_empty());
+  accumulator.add(5);
+  accumulator.add(-3);
+  accumulator.add(10);
+  TEST_ASSERT_FALSE(accumulator.is_empty());
+  decimation::Envelope<int64_t> envelope = accumulator.envelope();
+  TEST_ASSERT_EQUAL(-3, envelope.min);
+  TEST_ASSERT_EQUAL(10, envelope.max);
+  TEST_ASSERT_EQUAL(4, envelope.mean);
+
+  // A decreasing sequence, the first value is the max.
+  accumulator.reset();
+  TEST_ASSERT_TRUE(accumulator.is_empty());
+  accumulator.add(3);
+  accumulator.add(2);
+  accumulator.add(1);
+  envelope = accumulator.envelope();
+  TEST_ASSERT_EQUAL(1, envelope.min);
+  TEST_ASSERT_EQUAL(3, envelope.max);
+  TEST_ASSERT_EQUAL(2, envelope.mean);
+}
+
+// Fills a capture buffer with n random items. If wrap, the items
+// wrap around the end of the circular buffer.
+static void fill_capture_buffer(acquisition::CaptureBuffer* buffer,
+                                uint16_t n, bool wrap) {
+  buffer->items.clear();
+  const int total = wrap ? acquisition::kCaptureBufferSize + 123 : n;
+  for (int i = 0; i < total; i++) {
+    *buffer->items.insert() = {random_value(2000), random_value(2000)};
+  }
+  buffer->items.keep_at_most(n);
+}
+
+static void check_pyramid(uint16_t n, bool wrap) {
+  static acquisition::CaptureBuffer buffer;
+  static MinMaxPyramid pyramid;
+  fill_capture_buffer(&buffer, n, wrap);
+  pyramid.compute(buffer);
+
+  for (int level = MinMaxPyramid::kFirstLevel;
+       level <= MinMaxPyramid::kLastLevel; level++) {
+    TEST_ASSERT_EQUAL(n >> level, pyramid.level_size(level));
+    for (uint16_t i = 0; i < pyramid.level_size(level); i++) {
+      const acquisition::CaptureItem& first = *buffer.items.get(i << level);
+      MinMaxNode expected = {first.v1, first.v1, first.v2, first.v2};
+      for (uint16_t j = i << level; j < (i + 1) << level; j++) {
+        const acquisition::CaptureItem& item = *buffer.items.get(j);
+        expected.min1 = item.v1 < expected.min1 ? item.v1 : expected.min1;
+        expected.max1 = item.v1 > expected.max1 ? item.v1 : expected.max1;
+        expected.min2 = item.v2 < expected.min2 ? item.v2 : expected.min2;
+        expected.max2 = item.v2 > expected.max2 ? item.v2 : expected.max2;
+      }
+      const MinMaxNode& node = pyramid.get(level, i);
+      TEST_ASSERT_EQUAL(expected.min1, node.min1);
+      TEST_ASSERT_EQUAL(expected.max1, node.max1);
+      TEST_ASSERT_EQUAL(expected.min2, node.min2);
+      TEST_ASSERT_EQUAL(expected.max2, node.max2);
+    }
+  }
+}
+
+void test_min_max_pyramid() {
+  check_pyramid(acquisition::kCaptureBufferSize, false);
+  check_pyramid(acquisition::kCaptureBufferSize, true);
+  // A partial capture, whose last items don't fill a node.
+  check_pyramid(301, true);
+  // Less than a node.
+  check_pyramid(3, false);
+  check_pyramid(0, false);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_decimate);
+  RUN_TEST(test_decimate_1m_samples);
+  RUN_TEST(test_envelope_accumulator);
+  RUN_TEST(test_min_max_pyramid);
+  return UNITY_END();
+}
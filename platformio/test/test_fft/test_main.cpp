@@ -0,0 +1,124 @@
+// Tests of the fixed point FFT with known tones, at the FFT sizes
+// of the spectrum screen and around them.
+
+#include <unity.h>
+
+#include "analyzer/fft.cpp"
+
+void setUp() {}
+void tearDown() {}
+
+static constexpr int kSizes[] = {256, 512, 1024};
+
+// Full scale of the 12 bit signed input samples.
+static constexpr double kFullScale = 2047;
+
+static int16_t samples[fft::kMaxSize];
+static int16_t db10[fft::kMaxSize / 2];
+
+// Computes the spectrum of n samples of a sine at the center of the
+// given bin, with the given amplitude.
+static void tone_spectrum(int n, int bin, double amplitude) {
+  for (int i = 0; i < n; i++) {
+    const double angle = 2 * fft::kPi * bin * i / n;
+    samples[i] = (int16_t)lround(amplitude * sin(angle));
+  }
+  fft::power_spectrum_db10(samples, n, db10);
+}
+
+static int peak_bin(int n) {
+  int result = 0;
+  for (int k = 1; k < n / 2; k++) {
+    if (db10[k] > db10[result]) {
+      result = k;
+    }
+  }
+  return result;
+}
+
+// Asserts that the bins away from the given bins are below -50dB.
+static void assert_floor(int n, int bin) {
+  for (int k = 0; k < n / 2; k++) {
+    TEST_ASSERT_TRUE(db10[k] >= fft::kMinDb10);
+    if (k < bin - 2 || k > bin + 2) {
+      TEST_ASSERT_LESS_THAN(-500, db10[k]);
+    }
+  }
+}
+
+void test_full_scale_tones() {
+  for (int n : kSizes) {
+    const int bins[] = {3, n / 8, n / 2 - 3};
+    for (int bin : bins) {
+      tone_spectrum(n, bin, kFullScale);
+      TEST_ASSERT_EQUAL(bin, peak_bin(n));
+      // 0dB within 0.5dB.
+      TEST_ASSERT_INT_WITHIN(5, 0, db10[bin]);
+      // The Hann window spreads a tone to the adjacent bins, at -6dB.
+      TEST_ASSERT_INT_WITHIN(5, -60, db10[bin - 1]);
+      TEST_ASSERT_INT_WITHIN(5, -60, db10[bin + 1]);
+      assert_floor(n, bin);
+    }
+  }
+}
+
+void test_tone_levels() {
+  for (int n : kSizes) {
+    tone_spectrum(n, n / 4, kFullScale / 10);
+    TEST_ASSERT_EQUAL(n / 4, peak_bin(n));
+    TEST_ASSERT_INT_WITHIN(5, -200, db10[n / 4]);
+    // A 20 LSB sine, with a larger quantization error.
+    tone_spectrum(n, n / 4, kFullScale / 100);
+    TEST_ASSERT_INT_WITHIN(15, -400, db10[n / 4]);
+  }
+}
+
+void test_dc() {
+  for (int n : kSizes) {
+    for (int i = 0; i < n; i++) {
+      samples[i] = 2047;
+    }
+    fft::power_spectrum_db10(samples, n, db10);
+    // The Hann window passes all of the DC but half of a sine, so DC
+    // is at +6dB, and spreads to bin 1 at -6dB.
+    TEST_ASSERT_EQUAL(0, peak_bin(n));
+    TEST_ASSERT_INT_WITHIN(5, 60, db10[0]);
+    TEST_ASSERT_INT_WITHIN(5, 0, db10[1]);
+    assert_floor(n, 0);
+  }
+}
+
+void test_nyquist() {
+  for (int n : kSizes) {
+    for (int i = 0; i < n; i++) {
+      samples[i] = (i & 1) ? -2047 : 2047;
+    }
+    fft::power_spectrum_db10(samples, n, db10);
+    // The Nyquist bin itself is not reported. The Hann window spreads
+    // it to the last reported bin, and it doesn't alias to DC.
+    TEST_ASSERT_EQUAL(n / 2 - 1, peak_bin(n));
+    TEST_ASSERT_INT_WITHIN(5, 0, db10[n / 2 - 1]);
+    assert_floor(n, n / 2);
+  }
+}
+
+void test_min_db10_clipping() {
+  for (int n : kSizes) {
+    memset(samples, 0, sizeof(samples));
+    fft::power_spectrum_db10(samples, n, db10);
+    for (int k = 0; k < n / 2; k++) {
+      TEST_ASSERT_EQUAL(fft::kMinDb10, db10[k]);
+    }
+  }
+}
+
+int main() {
+  fft::setup();
+  UNITY_BEGIN();
+  RUN_TEST(test_full_scale_tones);
+  RUN_TEST(test_tone_levels);
+  RUN_TEST(test_dc);
+  RUN_TEST(test_nyquist);
+  RUN_TEST(test_min_db10_clipping);
+  return UNITY_END();
+}
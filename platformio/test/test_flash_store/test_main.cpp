@@ -0,0 +1,261 @@
+// Tests of the flash store over a pair of RAM sectors, including
+// power losses while programming.
+
+#include <unity.h>
+
+#include "misc/flash_store.cpp"
+
+void setUp() {}
+void tearDown() {}
+
+// Small RAM sectors, so a few writes fill a sector. Programming can
+// be cut after a number of words, as by a power loss.
+class RamFlashSectors : public flash::FlashSectors {
+ public:
+  static constexpr uint32_t kSectorSize = 512;
+
+  RamFlashSectors() { memset(data_, 0xff, sizeof(data_)); }
+
+  uint32_t sector_size() const override { return kSectorSize; }
+
+  const uint8_t* sector_data(int sector) const override {
+    return (const uint8_t*)data_[sector];
+  }
+
+  bool erase(int sector) override {
+    erases++;
+    memset(data_[sector], 0xff, kSectorSize);
+    return true;
+  }
+
+  bool program(int sector, uint32_t offset, const uint32_t* words,
+               int n) override {
+    for (int i = 0; i < n; i++) {
+      if (words_to_power_loss == 0) {
+        return false;
+      }
+      if (words_to_power_loss > 0) {
+        words_to_power_loss--;
+      }
+      uint32_t* word = &data_[sector][offset / 4 + i];
+      // Flash words are programmed only once per erase.
+      if (*word != 0xffffffff) {
+        overwrites++;
+        return false;
+      }
+      *word = words[i];
+      programmed_words++;
+    }
+    return true;
+  }
+
+  // Flip a bit of a programmed word, e.g. a torn or decayed write.
+  void corrupt(int sector, uint32_t offset) {
+    data_[sector][offset / 4] ^= 0x10;
+  }
+
+  // Number of words that can be programmed until a power loss, or
+  // unlimited if negative.
+  int words_to_power_loss = -1;
+  int erases = 0;
+  int overwrites = 0;
+  int programmed_words = 0;
+
+ private:
+  uint32_t data_[flash::kNumStoreSectors][kSectorSize / 4];
+};
+
+// A value that is 28 bytes, so a record is 36 bytes.
+struct Value {
+  uint32_t words[7];
+};
+
+static Value make_value(uint32_t seed) {
+  Value value;
+  for (int i = 0; i < 7; i++) {
+    value.words[i] = seed * 1000 + i;
+  }
+  return value;
+}
+
+static void assert_value(uint16_t key, uint32_t seed) {
+  Value value;
+  TEST_ASSERT_TRUE(flash_store::read(key, &value, sizeof(value)));
+  TEST_ASSERT_EQUAL(seed * 1000, value.words[0]);
+  TEST_ASSERT_EQUAL(seed * 1000 + 6, value.words[6]);
+}
+
+static bool write_value(uint16_t key, uint32_t seed) {
+  const Value value = make_value(seed);
+  return flash_store::write(key, &value, sizeof(value));
+}
+
+// Number of writes of a 36 bytes record that fill a sector with an
+// 8 bytes header.
+static constexpr int kRecordsPerSector =
+    (RamFlashSectors::kSectorSize - 8) / 36;
+
+void test_write_read() {
+  static RamFlashSectors sectors;
+  sectors = RamFlashSectors();
+  TEST_ASSERT_TRUE(flash_store::setup(&sectors));
+  Value value;
+  TEST_ASSERT_FALSE(flash_store::read(1, &value, sizeof(value)));
+
+  TEST_ASSERT_TRUE(write_value(1, 10));
+  TEST_ASSERT_TRUE(write_value(2, 20));
+  TEST_ASSERT_TRUE(write_value(1, 11));
+  assert_value(1, 11);
+  assert_value(2, 20);
+  // A different size is treated as missing.
+  uint32_t word;
+  TEST_ASSERT_FALSE(flash_store::read(1, &word, sizeof(word)));
+
+  // Writing the current value programs nothing.
+  const int programmed_words = sectors.programmed_words;
+  TEST_ASSERT_TRUE(write_value(1, 11));
+  TEST_ASSERT_EQUAL(programmed_words, sectors.programmed_words);
+
+  // And the values are preserved across a restart.
+  TEST_ASSERT_TRUE(flash_store::setup(&sectors));
+  assert_value(1, 11);
+  assert_value(2, 20);
+  TEST_ASSERT_EQUAL(0, sectors.overwrites);
+}
+
+void test_torn_record() {
+  static RamFlashSectors sectors;
+  sectors = RamFlashSectors();
+  TEST_ASSERT_TRUE(flash_store::setup(&sectors));
+  TEST_ASSERT_TRUE(write_value(1, 10));
+
+  // A power loss in the middle of the value.
+  sectors.words_to_power_loss = 4;
+  TEST_ASSERT_FALSE(write_value(1, 11));
+  sectors.words_to_power_loss = -1;
+
+  // The torn record fails its CRC and the previous value is read.
+  TEST_ASSERT_TRUE(flash_store::setup(&sectors));
+  assert_value(1, 10);
+
+  // New records are appended after the torn one.
+  TEST_ASSERT_TRUE(write_value(1, 12));
+  assert_value(1, 12);
+
+  // A corrupted record is skipped too.
+  flash_store::Record record;
+  const int sector = flash_store::vars.active_sector;
+  TEST_ASSERT_TRUE(flash_store::find_last_record(sector, 1, &record));
+  sectors.corrupt(sector, record.offset + 8);
+  assert_value(1, 10);
+  TEST_ASSERT_EQUAL(0, sectors.overwrites);
+}
+
+void test_compaction() {
+  static RamFlashSectors sectors;
+  sectors = RamFlashSectors();
+  TEST_ASSERT_TRUE(flash_store::setup(&sectors));
+  TEST_ASSERT_EQUAL(0, flash_store::vars.active_sector);
+  TEST_ASSERT_TRUE(flash_store::is_spare_sector_erased());
+
+  // Fill sector 0, mostly with values of key 1.
+  TEST_ASSERT_TRUE(write_value(2, 20));
+  for (int i = 1; i < kRecordsPerSector; i++) {
+    TEST_ASSERT_TRUE(write_value(1, i));
+  }
+  TEST_ASSERT_EQUAL(0, flash_store::vars.active_sector);
+  TEST_ASSERT_FALSE(flash_store::has_room(sizeof(Value)));
+
+  // The next write moves the last values to sector 1.
+  TEST_ASSERT_TRUE(write_value(1, 100));
+  TEST_ASSERT_TRUE(flash_store::has_room(sizeof(Value)));
+  TEST_ASSERT_EQUAL(1, flash_store::vars.active_sector);
+  TEST_ASSERT_FALSE(flash_store::is_spare_sector_erased());
+  assert_value(1, 100);
+  assert_value(2, 20);
+  TEST_ASSERT_EQUAL(8 + 3 * 36, flash_store::vars.end_offset);
+
+  // And sector 1 is used after a restart.
+  TEST_ASSERT_TRUE(flash_store::setup(&sectors));
+  TEST_ASSERT_EQUAL(1, flash_store::vars.active_sector);
+  TEST_ASSERT_TRUE(flash_store::is_spare_sector_erased());
+  assert_value(1, 100);
+  assert_value(2, 20);
+  TEST_ASSERT_EQUAL(0, sectors.overwrites);
+}
+
+void test_write_never_erases() {
+  static RamFlashSectors sectors;
+  sectors = RamFlashSectors();
+  TEST_ASSERT_TRUE(flash_store::setup(&sectors));
+  const int erases = sectors.erases;
+
+  // Fill both sectors. Only the first compaction has an erased spare
+  // sector. It leaves the copied value and the new one in sector 1.
+  int seed = 1;
+  while (flash_store::vars.active_sector == 0) {
+    TEST_ASSERT_TRUE(write_value(1, seed++));
+  }
+  for (int i = 2; i < kRecordsPerSector; i++) {
+    TEST_ASSERT_TRUE(write_value(1, seed++));
+  }
+  TEST_ASSERT_FALSE(write_value(1, seed));
+  TEST_ASSERT_EQUAL(erases, sectors.erases);
+  assert_value(1, seed - 1);
+
+  // Until the spare sector is erased.
+  TEST_ASSERT_TRUE(flash_store::erase_spare_sector());
+  TEST_ASSERT_EQUAL(erases + 1, sectors.erases);
+  TEST_ASSERT_TRUE(flash_store::erase_spare_sector());
+  TEST_ASSERT_EQUAL(erases + 1, sectors.erases);
+  TEST_ASSERT_TRUE(write_value(1, seed));
+  TEST_ASSERT_EQUAL(0, flash_store::vars.active_sector);
+  assert_value(1, seed);
+  TEST_ASSERT_EQUAL(0, sectors.overwrites);
+}
+
+void test_power_loss_in_compaction() {
+  static RamFlashSectors sectors;
+  sectors = RamFlashSectors();
+  TEST_ASSERT_TRUE(flash_store::setup(&sectors));
+  TEST_ASSERT_TRUE(write_value(2, 20));
+  TEST_ASSERT_TRUE(write_value(3, 30));
+  for (int i = 2; i < kRecordsPerSector; i++) {
+    TEST_ASSERT_TRUE(write_value(1, i));
+  }
+  const int last_seed = kRecordsPerSector - 1;
+
+  // A power loss after copying two of the three values, before the
+  // sector header.
+  sectors.words_to_power_loss = 2 * 9 + 3;
+  TEST_ASSERT_FALSE(write_value(1, 100));
+  sectors.words_to_power_loss = -1;
+
+  // The old sector is still the active one, with all the values, and
+  // the partly programmed sector is erased on setup.
+  const int erases = sectors.erases;
+  TEST_ASSERT_TRUE(flash_store::setup(&sectors));
+  TEST_ASSERT_EQUAL(0, flash_store::vars.active_sector);
+  TEST_ASSERT_EQUAL(erases + 1, sectors.erases);
+  assert_value(1, last_seed);
+  assert_value(2, 20);
+  assert_value(3, 30);
+
+  // And the compaction is completed on the next write.
+  TEST_ASSERT_TRUE(write_value(1, 100));
+  TEST_ASSERT_EQUAL(1, flash_store::vars.active_sector);
+  assert_value(1, 100);
+  assert_value(2, 20);
+  assert_value(3, 30);
+  TEST_ASSERT_EQUAL(0, sectors.overwrites);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_write_read);
+  RUN_TEST(test_torn_record);
+  RUN_TEST(test_compaction);
+  RUN_TEST(test_write_never_erases);
+  RUN_TEST(test_power_loss_in_compaction);
+  return UNITY_END();
+}
@@ -0,0 +1,185 @@
+// Tests of the gesture detector. Touch traces, in the format of
+// config::kEnableTouchTraces, are replayed through the detector and
+// the reported gestures are compared to the expected ones. The touch
+// screen is polled every ~30ms.
+
+#include <unity.h>
+
+#include "display/gesture_detector.cpp"
+
+void setUp() {}
+void tearDown() {}
+
+// A touch screen poll.
+struct Poll {
+  uint32_t millis;
+  uint8_t num_points;
+  touch_driver::TouchPoint points[touch_driver::kMaxTouchPoints];
+};
+
+// Replays a trace and returns the number of reported gestures. Sets
+// *gesture to the last one, or GESTURE_NONE.
+static int replay(const Poll* polls, int n, Gesture* gesture) {
+  GestureDetector detector;
+  int count = 0;
+  *gesture = GESTURE_NONE;
+  for (int i = 0; i < n; i++) {
+    const Gesture g =
+        detector.track(polls[i].num_points, polls[i].points, polls[i].millis);
+    if (g != GESTURE_NONE) {
+      *gesture = g;
+      count++;
+    }
+  }
+  return count;
+}
+
+#define ASSERT_TRACE(expected, polls)                                    \
+  do {                                                                   \
+    Gesture gesture;                                                     \
+    const int count =                                                    \
+        replay(polls, sizeof(polls) / sizeof(polls[0]), &gesture);       \
+    TEST_ASSERT_EQUAL((expected) == GESTURE_NONE ? 0 : 1, count);        \
+    TEST_ASSERT_EQUAL(expected, gesture);                                \
+  } while (0)
+
+// A tap on a button.
+static const Poll kTap[] = {
+    {10230, 1, {{312, 145}, {0, 0}}},
+    {10261, 1, {{312, 146}, {0, 0}}},
+    {10290, 1, {{313, 146}, {0, 0}}},
+    {10321, 0, {{0, 0}, {0, 0}}},
+};
+
+// A quick swipe to the left, with some vertical drift.
+static const Poll kSwipeLeft[] = {
+    {20110, 1, {{402, 160}, {0, 0}}},
+    {20140, 1, {{381, 162}, {0, 0}}},
+    {20171, 1, {{342, 165}, {0, 0}}},
+    {20200, 1, {{297, 170}, {0, 0}}},
+    {20231, 1, {{255, 174}, {0, 0}}},
+    {20260, 1, {{226, 176}, {0, 0}}},
+    {20291, 0, {{0, 0}, {0, 0}}},
+};
+
+static const Poll kSwipeRight[] = {
+    {30050, 1, {{90, 200}, {0, 0}}},
+    {30081, 1, {{118, 198}, {0, 0}}},
+    {30110, 1, {{165, 195}, {0, 0}}},
+    {30141, 1, {{214, 193}, {0, 0}}},
+    {30170, 1, {{251, 192}, {0, 0}}},
+    {30201, 0, {{0, 0}, {0, 0}}},
+};
+
+static const Poll kSwipeUp[] = {
+    {40000, 1, {{240, 260}, {0, 0}}},
+    {40030, 1, {{238, 231}, {0, 0}}},
+    {40061, 1, {{236, 190}, {0, 0}}},
+    {40090, 1, {{235, 151}, {0, 0}}},
+    {40121, 0, {{0, 0}, {0, 0}}},
+};
+
+// A slow drag, e.g. of a slider. Not a swipe.
+static const Poll kSlowDrag[] = {
+    {50000, 1, {{100, 150}, {0, 0}}},
+    {50150, 1, {{112, 150}, {0, 0}}},
+    {50301, 1, {{125, 151}, {0, 0}}},
+    {50450, 1, {{141, 151}, {0, 0}}},
+    {50601, 1, {{165, 152}, {0, 0}}},
+    {50750, 1, {{190, 152}, {0, 0}}},
+    {50901, 1, {{221, 153}, {0, 0}}},
+    {51050, 0, {{0, 0}, {0, 0}}},
+};
+
+// A diagonal swipe has no main direction.
+static const Poll kDiagonal[] = {
+    {60000, 1, {{100, 100}, {0, 0}}},
+    {60030, 1, {{140, 135}, {0, 0}}},
+    {60061, 1, {{185, 170}, {0, 0}}},
+    {60090, 1, {{230, 210}, {0, 0}}},
+    {60121, 0, {{0, 0}, {0, 0}}},
+};
+
+// Two fingers moving apart. The second finger touches one poll after
+// the first one.
+static const Poll kPinchOut[] = {
+    {70000, 1, {{220, 150}, {0, 0}}},
+    {70031, 2, {{220, 151}, {262, 180}}},
+    {70060, 2, {{214, 146}, {270, 187}}},
+    {70091, 2, {{205, 139}, {281, 196}}},
+    {70120, 2, {{196, 131}, {294, 205}}},
+    {70151, 2, {{188, 125}, {303, 212}}},
+    {70180, 2, {{183, 121}, {309, 217}}},
+    {70211, 1, {{183, 121}, {0, 0}}},
+    {70240, 0, {{0, 0}, {0, 0}}},
+};
+
+// Two fingers moving toward each other.
+static const Poll kPinchIn[] = {
+    {80000, 2, {{150, 100}, {330, 220}}},
+    {80030, 2, {{158, 106}, {321, 213}}},
+    {80061, 2, {{175, 118}, {303, 201}}},
+    {80090, 2, {{193, 130}, {286, 190}}},
+    {80121, 2, {{205, 138}, {272, 181}}},
+    {80150, 2, {{211, 142}, {266, 177}}},
+    {80181, 0, {{0, 0}, {0, 0}}},
+};
+
+// Two fingers that barely move, and then one finger that moves
+// quickly after the other one is lifted. Neither a pinch nor a swipe.
+static const Poll kTwoFingersThenOne[] = {
+    {90000, 2, {{200, 150}, {280, 160}}},
+    {90030, 2, {{202, 150}, {283, 161}}},
+    {90061, 2, {{203, 151}, {285, 163}}},
+    {90090, 1, {{203, 151}, {0, 0}}},
+    {90121, 1, {{250, 152}, {0, 0}}},
+    {90150, 1, {{330, 153}, {0, 0}}},
+    {90181, 0, {{0, 0}, {0, 0}}},
+};
+
+// A swipe left and then a tap, in the same trace. Each touch is
+// detected separately.
+static const Poll kSwipeThenTap[] = {
+    {100000, 1, {{400, 160}, {0, 0}}},
+    {100030, 1, {{350, 161}, {0, 0}}},
+    {100061, 1, {{290, 162}, {0, 0}}},
+    {100090, 1, {{250, 162}, {0, 0}}},
+    {100121, 1, {{200, 163}, {0, 0}}},
+    {100150, 0, {{0, 0}, {0, 0}}},
+    {100600, 1, {{120, 80}, {0, 0}}},
+    {100631, 1, {{121, 80}, {0, 0}}},
+    {100660, 0, {{0, 0}, {0, 0}}},
+};
+
+void test_tap() { ASSERT_TRACE(GESTURE_NONE, kTap); }
+
+void test_swipes() {
+  ASSERT_TRACE(GESTURE_SWIPE_LEFT, kSwipeLeft);
+  ASSERT_TRACE(GESTURE_SWIPE_RIGHT, kSwipeRight);
+  ASSERT_TRACE(GESTURE_SWIPE_UP, kSwipeUp);
+}
+
+void test_not_swipes() {
+  ASSERT_TRACE(GESTURE_NONE, kSlowDrag);
+  ASSERT_TRACE(GESTURE_NONE, kDiagonal);
+}
+
+void test_pinches() {
+  ASSERT_TRACE(GESTURE_PINCH_OUT, kPinchOut);
+  ASSERT_TRACE(GESTURE_PINCH_IN, kPinchIn);
+  ASSERT_TRACE(GESTURE_NONE, kTwoFingersThenOne);
+}
+
+void test_one_gesture_per_touch() {
+  ASSERT_TRACE(GESTURE_SWIPE_LEFT, kSwipeThenTap);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_tap);
+  RUN_TEST(test_swipes);
+  RUN_TEST(test_not_swipes);
+  RUN_TEST(test_pinches);
+  RUN_TEST(test_one_gesture_per_touch);
+  return UNITY_END();
+}
@@ -0,0 +1,148 @@
+// Tests of the histogram bucket tables.
+
+#include <time.h>
+#include <unity.h>
+
+#include "analyzer/histogram.h"
+
+using histogram::SCALE_LINEAR;
+using histogram::SCALE_LOG;
+
+void setUp() {}
+void tearDown() {}
+
+// The speed of a step with given duration, in steps/sec.
+static double steps_per_sec(uint32_t ticks) {
+  return (double)histogram::kTicksPerSecond / ticks;
+}
+
+void test_ignores_slow_steps() {
+  const uint32_t max_ticks = histogram::kMaxTicksInStep;
+  TEST_ASSERT_EQUAL(0, histogram::bucket_index(SCALE_LINEAR, max_ticks));
+  TEST_ASSERT_EQUAL(-1, histogram::bucket_index(SCALE_LINEAR, max_ticks + 1));
+  TEST_ASSERT_EQUAL(0, histogram::bucket_index(SCALE_LOG, max_ticks));
+  TEST_ASSERT_EQUAL(-1, histogram::bucket_index(SCALE_LOG, max_ticks + 1));
+}
+
+void test_linear_table_matches_division() {
+  for (uint32_t t = 1; t <= histogram::kMaxTicksInStep; t++) {
+    TEST_ASSERT_EQUAL(histogram::linear_bucket_index_by_division(t),
+                      histogram::bucket_index(SCALE_LINEAR, t));
+  }
+}
+
+void test_linear_bucket_edges() {
+  // 1000 steps/sec is the first speed of bucket 10.
+  TEST_ASSERT_EQUAL(10, histogram::bucket_index(SCALE_LINEAR, 100));
+  TEST_ASSERT_EQUAL(9, histogram::bucket_index(SCALE_LINEAR, 101));
+  // Fast steps are aggregated in the last bucket.
+  TEST_ASSERT_EQUAL(histogram::kLinearNumBuckets - 1,
+                    histogram::bucket_index(SCALE_LINEAR, 1));
+  TEST_ASSERT_EQUAL(1000,
+                    histogram::bucket_min_steps_per_sec(SCALE_LINEAR, 10));
+}
+
+void test_log_index_inverse() {
+  for (uint32_t t = 1; t <= histogram::kMaxTicksInStep; t++) {
+    const int index = histogram::log_ticks_index(t);
+    TEST_ASSERT_LESS_OR_EQUAL(t, histogram::log_index_min_ticks(index));
+    TEST_ASSERT_GREATER_THAN(t, histogram::log_index_min_ticks(index + 1));
+  }
+}
+
+void test_log_buckets_cover_range_in_speed_order() {
+  TEST_ASSERT_GREATER_OR_EQUAL(80, histogram::kLogNumBuckets);
+  TEST_ASSERT_LESS_OR_EQUAL(histogram::kMaxNumBuckets,
+                            histogram::kLogNumBuckets);
+  int last_index = 0;
+  for (uint32_t t = histogram::kMaxTicksInStep; t >= 1; t--) {
+    const int index = histogram::bucket_index(SCALE_LOG, t);
+    TEST_ASSERT_GREATER_OR_EQUAL(last_index, index);
+    TEST_ASSERT_LESS_THAN(histogram::kLogNumBuckets, index);
+    last_index = index;
+  }
+  TEST_ASSERT_EQUAL(histogram::kLogNumBuckets - 1, last_index);
+}
+
+void test_log_bucket_min_speed() {
+  // The slowest bucket starts at the slowest step that is tracked.
+  TEST_ASSERT_EQUAL(10, histogram::bucket_min_steps_per_sec(SCALE_LOG, 0));
+  for (uint32_t t = 1; t <= histogram::kMaxTicksInStep; t++) {
+    const int index = histogram::bucket_index(SCALE_LOG, t);
+    TEST_ASSERT_LESS_OR_EQUAL(
+        steps_per_sec(t),
+        histogram::bucket_min_steps_per_sec(SCALE_LOG, index));
+  }
+}
+
+void test_log_resolution() {
+  // Steps in the same bucket are within 12.5% in speed, except for
+  // the fastest bucket that aggregates the shorter steps.
+  for (uint32_t t = histogram::kLogMinTicksInStep + 1;
+       t <= histogram::kMaxTicksInStep; t++) {
+    const int index = histogram::bucket_index(SCALE_LOG, t);
+    const uint32_t min_ticks = histogram::log_index_min_ticks(
+        histogram::kLogMaxTicksIndex - index);
+    TEST_ASSERT_LESS_OR_EQUAL(1.125 * steps_per_sec(t),
+                              steps_per_sec(min_ticks));
+  }
+}
+
+// Step durations in a random order, so the branches of the mappings
+// are not predictable.
+static constexpr int kNumCostSteps = 1000000;
+static uint32_t cost_steps[kNumCostSteps];
+
+// Returns the sum of the bucket indexes of the cost steps, and the
+// time per step in nanoseconds.
+template <class BucketIndexFn>
+static int64_t time_bucket_index(BucketIndexFn bucket_index, double* nsecs) {
+  const clock_t start = clock();
+  int64_t sum = 0;
+  for (int i = 0; i < kNumCostSteps; i++) {
+    sum += bucket_index(cost_steps[i]);
+  }
+  *nsecs = 1e9 * (clock() - start) / CLOCKS_PER_SEC / kNumCostSteps;
+  return sum;
+}
+
+void test_bucket_index_cost() {
+  uint32_t rand_state = 1;
+  for (int i = 0; i < kNumCostSteps; i++) {
+    rand_state = rand_state * 1664525 + 1013904223;
+    cost_steps[i] = 1 + (rand_state >> 8) % histogram::kMaxTicksInStep;
+  }
+  double division_nsecs;
+  double table_nsecs;
+  double log_nsecs;
+  const int64_t division_sum = time_bucket_index(
+      [](uint32_t t) { return histogram::linear_bucket_index_by_division(t); },
+      &division_nsecs);
+  const int64_t table_sum = time_bucket_index(
+      [](uint32_t t) { return histogram::bucket_index(SCALE_LINEAR, t); },
+      &table_nsecs);
+  const int64_t log_sum = time_bucket_index(
+      [](uint32_t t) { return histogram::bucket_index(SCALE_LOG, t); },
+      &log_nsecs);
+  TEST_ASSERT_EQUAL(division_sum, table_sum);
+  TEST_ASSERT_TRUE(log_sum > 0);
+  char message[120];
+  snprintf(message, sizeof(message),
+           "Nsecs per step on the host: division %.2f, linear table %.2f, "
+           "log %.2f",
+           division_nsecs, table_nsecs, log_nsecs);
+  TEST_MESSAGE(message);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_ignores_slow_steps);
+  RUN_TEST(test_linear_table_matches_division);
+  RUN_TEST(test_linear_bucket_edges);
+  RUN_TEST(test_log_index_inverse);
+  RUN_TEST(test_log_buckets_cover_range_in_speed_order);
+  RUN_TEST(test_log_bucket_min_speed);
+  RUN_TEST(test_log_resolution);
+  RUN_TEST(test_bucket_index_cost);
+  return UNITY_END();
+}
@@ -0,0 +1,304 @@
+// Tests of the I2C transactions queue, over a mock I2C port whose
+// transfers end when the test says so.
+
+#include <unity.h>
+
+#include "misc/i2c_queue.cpp"
+
+void setUp() {}
+void tearDown() {}
+
+// Records the started transfers and returns the status that the test
+// sets.
+class MockPort : public i2c::I2cPort {
+ public:
+  bool start_read(uint8_t device_address, uint8_t reg, uint8_t* data,
+                  uint16_t n) override {
+    return start(device_address, reg, true, data, n);
+  }
+
+  bool start_write(uint8_t device_address, uint8_t reg,
+                   const uint8_t* data, uint16_t n) override {
+    return start(device_address, reg, false, data, n);
+  }
+
+  i2c::TransferStatus status() const override { return status_; }
+
+  void reset() override {
+    resets++;
+    status_ = i2c::TRANSFER_ERROR;
+  }
+
+  // End the transfer in progress. A read gets the given byte value.
+  void end(bool ok, uint8_t value = 0) {
+    if (ok && last_is_read) {
+      memset(last_data_, value, last_size);
+    }
+    status_ = ok ? i2c::TRANSFER_OK : i2c::TRANSFER_ERROR;
+  }
+
+  bool is_busy() const { return status_ == i2c::TRANSFER_BUSY; }
+
+  // If false, transfers fail to start.
+  bool accept = true;
+  int starts = 0;
+  int resets = 0;
+  uint8_t last_device_address = 0;
+  uint8_t last_reg = 0;
+  bool last_is_read = false;
+  uint16_t last_size = 0;
+
+ private:
+  bool start(uint8_t device_address, uint8_t reg, bool is_read,
+             const uint8_t* data, uint16_t n) {
+    // A new transfer should start only after the last one ended.
+    TEST_ASSERT_FALSE(is_busy());
+    starts++;
+    last_device_address = device_address;
+    last_reg = reg;
+    last_is_read = is_read;
+    last_data_ = (uint8_t*)data;
+    last_size = n;
+    status_ = accept ? i2c::TRANSFER_BUSY : i2c::TRANSFER_ERROR;
+    return accept;
+  }
+
+  i2c::TransferStatus status_ = i2c::TRANSFER_OK;
+  uint8_t* last_data_ = nullptr;
+};
+
+// Records the callbacks.
+struct CallbackLog {
+  int count = 0;
+  bool ok[16];
+  int ids[16];
+};
+
+// The callback context of a transaction.
+struct Context {
+  CallbackLog* log;
+  int id;
+};
+
+static void callback(bool ok, void* context) {
+  Context* c = (Context*)context;
+  TEST_ASSERT_TRUE(c->log->count < 16);
+  c->log->ok[c->log->count] = ok;
+  c->log->ids[c->log->count] = c->id;
+  c->log->count++;
+}
+
+static i2c_queue::Transaction transaction(Context* context, bool is_read,
+                                          uint8_t* data, uint16_t size) {
+  i2c_queue::Transaction result;
+  result.device_address = 0x38;
+  result.reg = 0x10 + context->id;
+  result.is_read = is_read;
+  result.data = data;
+  result.size = size;
+  result.callback = callback;
+  result.context = context;
+  return result;
+}
+
+void test_read() {
+  MockPort port;
+  i2c_queue::setup(&port);
+  CallbackLog log;
+  Context context = {&log, 1};
+  uint8_t data[4] = {0};
+  TEST_ASSERT_TRUE(i2c_queue::submit(transaction(&context, true, data, 4)));
+  // Started on submission.
+  TEST_ASSERT_EQUAL(1, port.starts);
+  TEST_ASSERT_EQUAL(0x38, port.last_device_address);
+  TEST_ASSERT_EQUAL(0x11, port.last_reg);
+  TEST_ASSERT_TRUE(port.last_is_read);
+  TEST_ASSERT_EQUAL(4, port.last_size);
+  TEST_ASSERT_FALSE(i2c_queue::is_idle());
+
+  // Still busy.
+  i2c_queue::loop();
+  TEST_ASSERT_EQUAL(0, log.count);
+
+  port.end(true, 0x5a);
+  i2c_queue::loop();
+  TEST_ASSERT_EQUAL(1, log.count);
+  TEST_ASSERT_TRUE(log.ok[0]);
+  TEST_ASSERT_EQUAL(0x5a, data[3]);
+  TEST_ASSERT_TRUE(i2c_queue::is_idle());
+}
+
+void test_order() {
+  MockPort port;
+  i2c_queue::setup(&port);
+  CallbackLog log;
+  Context contexts[3] = {{&log, 1}, {&log, 2}, {&log, 3}};
+  uint8_t data[3] = {0};
+  for (int i = 0; i < 3; i++) {
+    TEST_ASSERT_TRUE(
+        i2c_queue::submit(transaction(&contexts[i], i != 1, &data[i], 1)));
+  }
+  // One transfer at a time.
+  TEST_ASSERT_EQUAL(1, port.starts);
+
+  for (int i = 0; i < 3; i++) {
+    TEST_ASSERT_EQUAL(0x11 + i, port.last_reg);
+    TEST_ASSERT_EQUAL(i != 1, port.last_is_read);
+    // The second one fails.
+    port.end(i != 1);
+    i2c_queue::loop();
+  }
+  TEST_ASSERT_EQUAL(3, port.starts);
+  TEST_ASSERT_EQUAL(3, log.count);
+  for (int i = 0; i < 3; i++) {
+    TEST_ASSERT_EQUAL(i + 1, log.ids[i]);
+    TEST_ASSERT_EQUAL(i != 1, log.ok[i]);
+  }
+  TEST_ASSERT_TRUE(i2c_queue::is_idle());
+}
+
+void test_full_queue() {
+  MockPort port;
+  i2c_queue::setup(&port);
+  CallbackLog log;
+  Context context = {&log, 1};
+  uint8_t data = 0;
+  for (int i = 0; i < i2c_queue::kQueueSize; i++) {
+    TEST_ASSERT_TRUE(i2c_queue::submit(transaction(&context, true, &data, 1)));
+  }
+  TEST_ASSERT_FALSE(i2c_queue::submit(transaction(&context, true, &data, 1)));
+  port.end(true);
+  i2c_queue::loop();
+  TEST_ASSERT_TRUE(i2c_queue::submit(transaction(&context, true, &data, 1)));
+}
+
+void test_failed_start() {
+  MockPort port;
+  port.accept = false;
+  i2c_queue::setup(&port);
+  CallbackLog log;
+  Context context = {&log, 1};
+  uint8_t data = 0;
+  TEST_ASSERT_TRUE(i2c_queue::submit(transaction(&context, true, &data, 1)));
+  i2c_queue::loop();
+  TEST_ASSERT_EQUAL(1, log.count);
+  TEST_ASSERT_FALSE(log.ok[0]);
+  TEST_ASSERT_TRUE(i2c_queue::is_idle());
+}
+
+void test_timeout() {
+  MockPort port;
+  i2c_queue::setup(&port);
+  CallbackLog log;
+  Context contexts[2] = {{&log, 1}, {&log, 2}};
+  uint8_t data[2] = {0};
+  TEST_ASSERT_TRUE(
+      i2c_queue::submit(transaction(&contexts[0], true, &data[0], 1)));
+  TEST_ASSERT_TRUE(
+      i2c_queue::submit(transaction(&contexts[1], true, &data[1], 1)));
+
+  // A stuck bus.
+  host::fake_millis() += i2c_queue::kTransferTimeoutMillis - 1;
+  i2c_queue::loop();
+  TEST_ASSERT_EQUAL(0, log.count);
+  TEST_ASSERT_EQUAL(0, port.resets);
+
+  // Aborted, and the next one starts.
+  host::fake_millis() += 1;
+  i2c_queue::loop();
+  TEST_ASSERT_EQUAL(1, port.resets);
+  TEST_ASSERT_EQUAL(1, log.count);
+  TEST_ASSERT_FALSE(log.ok[0]);
+  TEST_ASSERT_EQUAL(2, port.starts);
+  TEST_ASSERT_EQUAL(0x12, port.last_reg);
+
+  port.end(true);
+  i2c_queue::loop();
+  TEST_ASSERT_EQUAL(2, log.count);
+  TEST_ASSERT_TRUE(log.ok[1]);
+}
+
+void test_hold_off() {
+  MockPort port;
+  i2c_queue::setup(&port);
+  CallbackLog log;
+  Context contexts[2] = {{&log, 1}, {&log, 2}};
+  uint8_t data[2] = {0};
+  // E.g. an EEPROM write and its write cycle.
+  i2c_queue::Transaction write =
+      transaction(&contexts[0], false, &data[0], 1);
+  write.hold_off_millis = 10;
+  TEST_ASSERT_TRUE(i2c_queue::submit(write));
+  TEST_ASSERT_TRUE(
+      i2c_queue::submit(transaction(&contexts[1], true, &data[1], 1)));
+
+  port.end(true);
+  i2c_queue::loop();
+  TEST_ASSERT_EQUAL(1, log.count);
+  TEST_ASSERT_EQUAL(1, port.starts);
+
+  host::fake_millis() += 9;
+  i2c_queue::loop();
+  TEST_ASSERT_EQUAL(1, port.starts);
+
+  host::fake_millis() += 1;
+  i2c_queue::loop();
+  TEST_ASSERT_EQUAL(2, port.starts);
+  TEST_ASSERT_EQUAL(0x12, port.last_reg);
+}
+
+void test_wait_idle() {
+  MockPort port;
+  i2c_queue::setup(&port);
+  CallbackLog log;
+  Context context = {&log, 1};
+  uint8_t data = 0;
+  TEST_ASSERT_TRUE(i2c_queue::submit(transaction(&context, true, &data, 1)));
+  port.end(true);
+  TEST_ASSERT_TRUE(i2c_queue::wait_idle(100));
+  TEST_ASSERT_EQUAL(1, log.count);
+}
+
+// A callback that submits another transaction, as the touch driver
+// does.
+static void chained_callback(bool ok, void* context) {
+  callback(ok, context);
+  Context* c = (Context*)context;
+  if (c->id == 1) {
+    static Context next = {c->log, 2};
+    static uint8_t data = 0;
+    TEST_ASSERT_TRUE(i2c_queue::submit(transaction(&next, true, &data, 1)));
+  }
+}
+
+void test_submit_from_callback() {
+  MockPort port;
+  i2c_queue::setup(&port);
+  CallbackLog log;
+  Context context = {&log, 1};
+  uint8_t data = 0;
+  i2c_queue::Transaction first = transaction(&context, true, &data, 1);
+  first.callback = chained_callback;
+  TEST_ASSERT_TRUE(i2c_queue::submit(first));
+  port.end(true);
+  i2c_queue::loop();
+  TEST_ASSERT_EQUAL(2, port.starts);
+  TEST_ASSERT_EQUAL(0x12, port.last_reg);
+  port.end(true);
+  i2c_queue::loop();
+  TEST_ASSERT_EQUAL(2, log.count);
+  TEST_ASSERT_TRUE(i2c_queue::is_idle());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_read);
+  RUN_TEST(test_order);
+  RUN_TEST(test_full_queue);
+  RUN_TEST(test_failed_start);
+  RUN_TEST(test_timeout);
+  RUN_TEST(test_hold_off);
+  RUN_TEST(test_wait_idle);
+  RUN_TEST(test_submit_from_callback);
+  return UNITY_END();
+}
@@ -0,0 +1,164 @@
+// Benchmarks of the acquisition interrupt routine, in the acquisition
+// and capture modes. A synthetic trace of a moving motor is passed to
+// the routine a DMA buffer at a time, the way the ADC/DMA interrupts
+// do. The host is much faster than the Cortex-M4, so the nsecs per
+// tick are only a relative measure.
+
+#include <time.h>
+#include <unity.h>
+
+#include "analyzer/acquisition.cpp"
+#include "coil_trace.h"
+
+// Fakes of the hardware that the acquisition uses.
+namespace tim {
+void set_trigger_rate_factor(uint32_t factor) {}
+}  // namespace tim
+
+namespace dma {
+static AdcPoint fake_buffers[2][kDmaAdcPointBufferSize];
+AdcPoint* const kDmaAdcPointBuffer1 = fake_buffers[0];
+AdcPoint* const kDmaAdcPointBuffer2 = fake_buffers[1];
+}  // namespace dma
+
+void setUp() {}
+void tearDown() {}
+
+static constexpr uint16_t kOffsetCounts = 2000;
+
+// 5 secs of 1A at 250 electrical Hz, or 1000 full steps per second.
+static constexpr int kTicks = 500000;
+static constexpr double kHz = 250;
+static constexpr int kExpectedSteps = 4 * kHz * kTicks / 100000;
+
+// The ADC points of the trace, a point per tick, and
+// kOversamplingFactor points per tick in the oversampling mode.
+static dma::AdcPoint points[kTicks];
+static dma::AdcPoint
+    oversampled_points[kTicks * acquisition::kOversamplingFactor];
+
+static void generate_points(dma::AdcPoint* bfr, int points_per_tick) {
+  coil_trace::Generator trace(5);
+  const coil_trace::Segment segment = {0, 1.0, kHz / points_per_tick};
+  for (int i = 0; i < kTicks * points_per_tick; i++) {
+    int v1;
+    int v2;
+    trace.next(segment, &v1, &v2);
+    bfr[i].axes[0].v1 = kOffsetCounts + v1;
+    bfr[i].axes[0].v2 = kOffsetCounts + v2;
+  }
+}
+
+// Clear the acquisition state and set it up with the given mode.
+static void setup_acquisition(bool oversampling) {
+  acquisition::isr_data = acquisition::IsrData();
+  acquisition::Settings settings = {};
+  settings.offsets[0] = {kOffsetCounts, kOffsetCounts};
+  settings.adaptive_threshold = true;
+  settings.oversampling = oversampling;
+  acquisition::setup(settings);
+}
+
+// Pass the points to the interrupt routine and return the nsecs per
+// tick.
+static double time_ticks(const dma::AdcPoint* bfr, int points_per_tick) {
+  const int n = kTicks * points_per_tick;
+  const clock_t start = clock();
+  for (int i = 0; i < n; i += dma::kDmaAdcPointBufferSize) {
+    acquisition::isr_handle_dma_buffer(bfr + i, dma::kDmaAdcPointBufferSize);
+  }
+  return 1e9 * (clock() - start) / CLOCKS_PER_SEC / kTicks;
+}
+
+void test_oversampling_cost() {
+  generate_points(points, 1);
+  generate_points(oversampled_points, acquisition::kOversamplingFactor);
+
+  setup_acquisition(false);
+  const double normal_nsecs = time_ticks(points, 1);
+  TEST_ASSERT_EQUAL(kTicks, acquisition::sample_state()->tick_count);
+  TEST_ASSERT_INT_WITHIN(2, kExpectedSteps,
+                         acquisition::sample_state()->full_steps);
+
+  setup_acquisition(true);
+  const double oversampling_nsecs =
+      time_ticks(oversampled_points, acquisition::kOversamplingFactor);
+  // Same ticks and steps, from 4x the points.
+  TEST_ASSERT_EQUAL(kTicks, acquisition::sample_state()->tick_count);
+  TEST_ASSERT_INT_WITHIN(2, kExpectedSteps,
+                         acquisition::sample_state()->full_steps);
+
+  char message[100];
+  snprintf(message, sizeof(message),
+           "Nsecs per tick on the host: normal %.1f, oversampling %.1f",
+           normal_nsecs, oversampling_nsecs);
+  TEST_MESSAGE(message);
+}
+
+void test_capture_mode_cost() {
+  generate_points(points, 1);
+  // Not capturing, and rolling at the divider of the slow timebases,
+  // in each capture mode.
+  setup_acquisition(false);
+  const double idle_nsecs = time_ticks(points, 1);
+  const acquisition::CaptureMode kModes[] = {
+      acquisition::CAPTURE_MODE_SAMPLE, acquisition::CAPTURE_MODE_AVERAGE,
+      acquisition::CAPTURE_MODE_PEAK_DETECT};
+  double mode_nsecs[3];
+  for (int i = 0; i < 3; i++) {
+    setup_acquisition(false);
+    acquisition::start_roll(100, kModes[i]);
+    mode_nsecs[i] = time_ticks(points, 1);
+    TEST_ASSERT_TRUE(acquisition::is_rolling());
+  }
+
+  char message[120];
+  snprintf(message, sizeof(message),
+           "Nsecs per tick on the host: idle %.1f, sample %.1f, average "
+           "%.1f, peak detect %.1f",
+           idle_nsecs, mode_nsecs[0], mode_nsecs[1], mode_nsecs[2]);
+  TEST_MESSAGE(message);
+}
+
+// Counts the spikes in the roll items of a trace with a single tick
+// spike every 10,000 ticks, in the middle of a capture interval.
+static int count_captured_spikes(acquisition::CaptureMode mode) {
+  for (int i = 0; i < kTicks; i++) {
+    const uint16_t v = kOffsetCounts + (i % 10000 == 5050 ? 1000 : 0);
+    points[i].axes[0].v1 = v;
+    points[i].axes[0].v2 = v;
+  }
+  setup_acquisition(false);
+  acquisition::start_roll(100, mode);
+  int spikes = 0;
+  for (int i = 0; i < kTicks; i += dma::kDmaAdcPointBufferSize) {
+    acquisition::isr_handle_dma_buffer(points + i,
+                                       dma::kDmaAdcPointBufferSize);
+    acquisition::CaptureItem items[acquisition::kRollBufferSize];
+    const uint16_t n =
+        acquisition::consume_roll_items(items, acquisition::kRollBufferSize);
+    for (int j = 0; j < n; j++) {
+      // The input filters reduce the spike to ~300 counts.
+      if (items[j].v1 > 100 && items[j].v2 > 100) {
+        spikes++;
+      }
+    }
+  }
+  return spikes;
+}
+
+void test_peak_detect_keeps_spikes() {
+  using acquisition::CAPTURE_MODE_PEAK_DETECT;
+  using acquisition::CAPTURE_MODE_SAMPLE;
+  TEST_ASSERT_EQUAL(0, count_captured_spikes(CAPTURE_MODE_SAMPLE));
+  TEST_ASSERT_EQUAL(kTicks / 10000,
+                    count_captured_spikes(CAPTURE_MODE_PEAK_DETECT));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_oversampling_cost);
+  RUN_TEST(test_capture_mode_cost);
+  RUN_TEST(test_peak_detect_keeps_spikes);
+  return UNITY_END();
+}
@@ -0,0 +1,231 @@
+// Tests of the recorder over a block device image in a host file. The
+// image is decoded with tools/recorder_reader.py, the way recorded
+// devices are read, and is left at .pio/recorder_test.img for
+// inspection. Requires python3 in the path.
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unity.h>
+
+#include "file_block_device.h"
+#include "misc/recorder.cpp"
+
+// Fakes of the acquisition functions that the recorder uses.
+namespace acquisition {
+
+static State fake_state;
+static MoveRecords fake_moves;
+
+const State* sample_state() { return &fake_state; }
+const MoveRecords* sample_moves() { return &fake_moves; }
+uint32_t move_peak_steps_per_sec(const MoveRecord& move) {
+  return TicksPerSecond / move.min_ticks_in_step;
+}
+int adc_value_to_milliamps(int adc_value) { return 2 * adc_value; }
+
+}  // namespace acquisition
+
+void setUp() {}
+void tearDown() {}
+
+// Returns a path relative to the project directory, assuming this
+// file is at test/test_recorder/test_main.cpp in it.
+static void project_path(const char* relative_path, char* bfr, int size) {
+  const char* file = __FILE__;
+  const char* end = strstr(file, "test/test_recorder/test_main.cpp");
+  const int prefix_size = end ? end - file : 0;
+  snprintf(bfr, size, "%.*s%s", prefix_size, file, relative_path);
+}
+
+static void add_move() {
+  acquisition::MoveRecord move = {};
+  move.start_tick = acquisition::fake_state.tick_count;
+  move.duration_ticks = 5000;
+  move.steps = (acquisition::fake_moves.total_moves % 2) ? -120 : 120;
+  move.total_step_peak_currents = 120 * 400;
+  move.min_ticks_in_step = 100;
+  *acquisition::fake_moves.items.insert() = move;
+  acquisition::fake_moves.total_moves++;
+}
+
+// Runs the main loop for the given number of 10ms iterations, with
+// a move every move_interval iterations, or no moves if zero.
+static void run(int iterations, int move_interval) {
+  for (int i = 0; i < iterations; i++) {
+    host::fake_millis() += 10;
+    acquisition::fake_state.tick_count += acquisition::TicksPerSecond / 100;
+    acquisition::fake_state.full_steps += 7;
+    if (move_interval && i % move_interval == 0) {
+      add_move();
+    }
+    recorder::loop();
+  }
+}
+
+// A move record in the reader's output.
+struct MoveLine {
+  uint32_t session;
+  uint32_t number;
+};
+
+struct ReaderOutput {
+  int num_snapshots = 0;
+  int num_moves = 0;
+  MoveLine moves[2000];
+  // True if a record of a session follows one of a newer session.
+  bool out_of_order = false;
+  int num_blocks = 0;
+  int num_invalid_blocks = 0;
+};
+
+// Runs the reader on an image and parses its output. Returns false
+// if the reader failed.
+static bool read_image(const char* image_path, ReaderOutput* output) {
+  char reader_path[256];
+  char csv_path[256];
+  char log_path[256];
+  project_path("../tools/recorder_reader.py", reader_path,
+               sizeof(reader_path));
+  project_path(".pio/recorder_test.csv", csv_path, sizeof(csv_path));
+  project_path(".pio/recorder_test.log", log_path, sizeof(log_path));
+  char command[1200];
+  snprintf(command, sizeof(command), "python3 %s %s > %s 2> %s", reader_path,
+           image_path, csv_path, log_path);
+  if (system(command) != 0) {
+    return false;
+  }
+
+  FILE* f = fopen(csv_path, "r");
+  TEST_ASSERT_NOT_NULL(f);
+  char line[256];
+  uint32_t last_session = 0;
+  while (fgets(line, sizeof(line), f)) {
+    uint32_t session;
+    uint32_t sequence;
+    uint32_t number;
+    if (sscanf(line, "SNAPSHOT,%u,%u", &session, &sequence) == 2) {
+      output->num_snapshots++;
+    } else if (sscanf(line, "MOVE,%u,%u,%u", &session, &sequence, &number) ==
+               3) {
+      TEST_ASSERT_TRUE(output->num_moves < 2000);
+      output->moves[output->num_moves++] = {session, number};
+    } else {
+      continue;
+    }
+    output->out_of_order |= session < last_session;
+    last_session = session;
+  }
+  fclose(f);
+
+  f = fopen(log_path, "r");
+  TEST_ASSERT_NOT_NULL(f);
+  TEST_ASSERT_EQUAL(2, fscanf(f, "%d blocks, %d invalid blocks",
+                              &output->num_blocks,
+                              &output->num_invalid_blocks));
+  fclose(f);
+  return true;
+}
+
+void test_sessions() {
+  char image_path[256];
+  project_path(".pio/recorder_test.img", image_path, sizeof(image_path));
+  // Blocks of up to ~18 records each, so the log wraps.
+  const uint32_t kNumBlocks = 32;
+  static ReaderOutput output;
+
+  // First session, 400 moves in 200 secs. In the second half, one
+  // of seven writes fails and is retried.
+  {
+    FileBlockDevice device(image_path, kNumBlocks, true);
+    TEST_ASSERT_TRUE(device.is_open());
+    TEST_ASSERT_TRUE(recorder::setup(&device));
+    run(10000, 50);
+    device.set_fail_every(7);
+    run(10000, 50);
+    device.set_fail_every(0);
+    // The last moves are flushed within 10 secs.
+    run(1500, 0);
+    TEST_ASSERT_EQUAL(400, acquisition::fake_moves.total_moves);
+    TEST_ASSERT_TRUE(recorder::stats().write_errors > 0);
+    TEST_ASSERT_EQUAL(0, recorder::stats().records_dropped);
+    // And then a power loss while writing.
+    device.set_power_lost();
+    run(2000, 0);
+  }
+
+  output = ReaderOutput();
+  if (!read_image(image_path, &output)) {
+    TEST_IGNORE_MESSAGE("Failed to run tools/recorder_reader.py");
+  }
+  // The partial blocks of the power loss.
+  TEST_ASSERT_TRUE(output.num_invalid_blocks > 0);
+  TEST_ASSERT_EQUAL(kNumBlocks, output.num_blocks + output.num_invalid_blocks);
+
+  // Second session, continues the log over the partial blocks.
+  {
+    FileBlockDevice device(image_path, kNumBlocks, false);
+    TEST_ASSERT_TRUE(device.is_open());
+    TEST_ASSERT_TRUE(recorder::setup(&device));
+    run(3000, 50);
+    run(1500, 0);
+    TEST_ASSERT_EQUAL(460, acquisition::fake_moves.total_moves);
+    TEST_ASSERT_EQUAL(0, recorder::stats().records_dropped);
+  }
+
+  output = ReaderOutput();
+  TEST_ASSERT_TRUE(read_image(image_path, &output));
+  TEST_ASSERT_EQUAL(0, output.num_invalid_blocks);
+  TEST_ASSERT_EQUAL(kNumBlocks, output.num_blocks);
+  TEST_ASSERT_TRUE(output.num_snapshots > 0);
+  // The second session follows the first one.
+  TEST_ASSERT_FALSE(output.out_of_order);
+
+  // The older moves were overwritten. The rest are contiguous, up to
+  // the last move of each session.
+  TEST_ASSERT_TRUE(output.num_moves > 60);
+  for (int i = 1; i < output.num_moves; i++) {
+    TEST_ASSERT_EQUAL(output.moves[i - 1].number + 1, output.moves[i].number);
+  }
+  const MoveLine& last = output.moves[output.num_moves - 1];
+  TEST_ASSERT_EQUAL(1, last.session);
+  TEST_ASSERT_EQUAL(460, last.number);
+  const MoveLine& last_of_first_session = output.moves[output.num_moves - 61];
+  TEST_ASSERT_EQUAL(0, last_of_first_session.session);
+  TEST_ASSERT_EQUAL(400, last_of_first_session.number);
+}
+
+void test_throughput() {
+  char image_path[256];
+  project_path(".pio/recorder_throughput.img", image_path,
+               sizeof(image_path));
+  {
+    FileBlockDevice device(image_path, 4096, true);
+    TEST_ASSERT_TRUE(device.is_open());
+    TEST_ASSERT_TRUE(recorder::setup(&device));
+    // A move on each iteration. A block is filled before the previous
+    // one is written, so nothing is dropped.
+    const int kMoves = 100000;
+    const clock_t start = clock();
+    for (int i = 0; i < kMoves; i++) {
+      add_move();
+      recorder::loop();
+    }
+    const double usecs = 1e6 * (clock() - start) / CLOCKS_PER_SEC;
+    char message[100];
+    snprintf(message, sizeof(message),
+             "%d moves, %u blocks, %.2f usecs per move on the host", kMoves,
+             recorder::stats().blocks_written, usecs / kMoves);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL(0, recorder::stats().records_dropped);
+    TEST_ASSERT_TRUE(recorder::stats().blocks_written >= kMoves / 20);
+  }
+  remove(image_path);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_sessions);
+  RUN_TEST(test_throughput);
+  return UNITY_END();
+}
@@ -0,0 +1,95 @@
+// Tests of the channel 2 sampling skew compensation. An ideal pair of
+// coil current signals is sampled like the ADC does, with channel 2
+// one conversion after channel 1, and the angle of each sample pair is
+// compared to the true angle at the sampling time of channel 1.
+
+#include <unity.h>
+
+#include "analyzer/filters.h"
+
+void setUp() {}
+void tearDown() {}
+
+// Same as the acquisition, 714ns conversion time and 10us ticks.
+static constexpr double kSkewSecs = 714e-9;
+static constexpr double kTickSecs = 10e-6;
+static constexpr int32_t kSkewQ16 = (714 << 16) / 10000;
+
+// Scaled samples have 2 fraction bits, e.g. sums of 4 oversampled 12
+// bit samples.
+static constexpr double kScale = 4;
+static constexpr double kOffset = 2048;
+static constexpr double kAmplitude = 1500;
+
+static uint16_t scaled_sample(double value) {
+  return (uint16_t)lround((kOffset + value) * kScale);
+}
+
+static double degrees(double radians) { return radians * 180 / M_PI; }
+
+// Returns the mean absolute angle error in degrees, of a signal with the
+// given electrical frequency, with or without the compensation.
+static double mean_angle_error(double hz, bool compensate) {
+  const int kTicks = 20000;
+  double total_error = 0;
+  uint16_t prev_v2 = 0;
+  for (int i = 0; i <= kTicks; i++) {
+    const double t = i * kTickSecs;
+    const uint16_t v1 = scaled_sample(kAmplitude * cos(2 * M_PI * hz * t));
+    const uint16_t v2 = scaled_sample(kAmplitude *
+                                      sin(2 * M_PI * hz * (t + kSkewSecs)));
+    const uint16_t aligned_v2 =
+        compensate ? filters::interpolate_q16(prev_v2, v2, kSkewQ16) : v2;
+    prev_v2 = v2;
+    if (i == 0) {
+      // No previous sample yet.
+      continue;
+    }
+    const double angle = atan2(aligned_v2 / kScale - kOffset,
+                               v1 / kScale - kOffset);
+    double error = angle - 2 * M_PI * hz * t;
+    error = remainder(error, 2 * M_PI);
+    total_error += fabs(error);
+  }
+  return degrees(total_error / kTicks);
+}
+
+void test_interpolate_q16() {
+  TEST_ASSERT_EQUAL(1000, filters::interpolate_q16(2000, 1000, 0));
+  TEST_ASSERT_EQUAL(1500, filters::interpolate_q16(2000, 1000, 1 << 15));
+  TEST_ASSERT_EQUAL(1500, filters::interpolate_q16(1000, 2000, 1 << 15));
+  // Rounds to the nearest.
+  TEST_ASSERT_EQUAL(1001, filters::interpolate_q16(1003, 1000, 1 << 14));
+  TEST_ASSERT_EQUAL(1002, filters::interpolate_q16(1000, 1003, 1 << 14));
+  // Full scale 14 bit values.
+  TEST_ASSERT_EQUAL(16383 - 1170,
+                    filters::interpolate_q16(0, 16383, kSkewQ16));
+}
+
+void test_angle_error() {
+  const double kHz[] = {250, 500, 1000, 2000, 5000};
+  for (double hz : kHz) {
+    const double before = mean_angle_error(hz, false);
+    const double after = mean_angle_error(hz, true);
+    char message[80];
+    snprintf(message, sizeof(message), "%.0fHz: %.3f -> %.3f deg", hz,
+             before, after);
+    TEST_MESSAGE(message);
+    // Without the compensation, the angle error swings between zero
+    // and the phase of the skew, so its mean is about half of it.
+    const double expected_before = degrees(M_PI * hz * kSkewSecs);
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.01 + expected_before * 0.1,
+                                     expected_before, before, message);
+    // Down to about the quantization level at the lower frequencies.
+    // The linear interpolation error grows with the frequency.
+    TEST_ASSERT_TRUE_MESSAGE(after < before / 4, message);
+    TEST_ASSERT_TRUE_MESSAGE(hz > 2000 || after < 0.02, message);
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_interpolate_q16);
+  RUN_TEST(test_angle_error);
+  return UNITY_END();
+}
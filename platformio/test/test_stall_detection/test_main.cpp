@@ -0,0 +1,356 @@
+// Tests of the stall detection. Synthetic coil current traces, with
+// injected faults, are replayed through the acquisition interrupt
+// routine and the detected events are compared to the faults.
+
+#include <unity.h>
+
+#include "analyzer/acquisition.cpp"
+#include "coil_trace.h"
+
+// Fakes of the hardware that the acquisition uses.
+namespace tim {
+void set_trigger_rate_factor(uint32_t factor) {}
+}  // namespace tim
+
+namespace dma {
+static AdcPoint fake_buffers[2][kDmaAdcPointBufferSize];
+AdcPoint* const kDmaAdcPointBuffer1 = fake_buffers[0];
+AdcPoint* const kDmaAdcPointBuffer2 = fake_buffers[1];
+}  // namespace dma
+
+void setUp() {}
+void tearDown() {}
+
+using acquisition::StallEvent;
+using acquisition::StallEvents;
+using acquisition::StallEventType;
+using coil_trace::Segment;
+
+static constexpr uint16_t kOffsetCounts = 2000;
+
+// 1A at 250 electrical Hz. That's 1000 full steps per second, or 100
+// ticks per step.
+static constexpr double kAmps = 1.0;
+static constexpr double kHz = 250;
+static constexpr uint32_t kTicksPerStep = 100;
+
+// Ticks of the transitions that the signal filters add.
+static constexpr uint32_t kFilterTicks = 10;
+
+// An injected fault. Its events are reported from its first tick
+// until the end of the step that follows it, since a step is checked
+// for distortion when it ends.
+struct Fault {
+  StallEventType type;
+  uint64_t tick;
+  uint64_t end_tick;
+};
+
+// Replays a trace through the acquisition interrupt routine, from a
+// cleared acquisition state, and keeps the injected faults.
+class Replay {
+ public:
+  explicit Replay(double noise_counts) : trace_(noise_counts) {
+    acquisition::isr_data = acquisition::IsrData();
+    acquisition::Settings settings = {};
+    settings.offsets[0] = {kOffsetCounts, kOffsetCounts};
+    settings.adaptive_threshold = true;
+    acquisition::setup(settings);
+    // Let the thresholds adapt to the noise.
+    play({50000, 0, 0});
+  }
+
+  // Each ADC point is passed as a DMA buffer of its own, so the tick
+  // count is exact at any point.
+  void play(const Segment& segment) {
+    for (uint32_t i = 0; i < segment.ticks; i++) {
+      int v1;
+      int v2;
+      trace_.next(segment, &v1, &v2);
+      dma::AdcPoint point;
+      point.axes[0].v1 = clip(kOffsetCounts + v1);
+      point.axes[0].v2 = clip(kOffsetCounts + v2);
+      acquisition::isr_handle_dma_buffer(&point, 1);
+    }
+  }
+
+  // Move forward to the given fraction of a step, e.g. 0.5 for the
+  // middle of a step, with at least one full step on the way.
+  void move_to_step_fraction(double fraction, double amps = kAmps,
+                             double hz = kHz) {
+    const double steps = trace_.phase() * 4;
+    double delta = floor(steps) + fraction - steps;
+    while (delta < 1.25) {
+      delta += 1;
+    }
+    play({(uint32_t)lround(delta / 4 / hz * coil_trace::kTicksPerSecond), amps,
+          hz});
+  }
+
+  // Inject a jump of the current vector by the given number of full
+  // steps, between two ticks.
+  void inject_jump(double steps) {
+    trace_.set_phase(trace_.phase() + steps / 4);
+    add_fault(acquisition::STALL_QUADRANT_JUMP, 0);
+  }
+
+  // Inject a fault by playing a segment.
+  void inject_segment(StallEventType type, const Segment& segment) {
+    add_fault(type, segment.ticks);
+    play(segment);
+  }
+
+  uint64_t tick() const {
+    return acquisition::isr_data.axes[0].state.tick_count;
+  }
+
+  int num_faults() const { return num_faults_; }
+  const Fault& fault(int i) const { return faults_[i]; }
+
+ private:
+  static uint16_t clip(int counts) {
+    return counts < 0 ? 0 : counts > 4095 ? 4095 : counts;
+  }
+
+  void add_fault(StallEventType type, uint32_t ticks) {
+    TEST_ASSERT_TRUE(num_faults_ < kMaxFaults);
+    faults_[num_faults_++] = {type, tick() + 1, tick() + ticks};
+  }
+
+  static constexpr int kMaxFaults = 200;
+  coil_trace::Generator trace_;
+  Fault faults_[kMaxFaults];
+  int num_faults_ = 0;
+};
+
+static const StallEvents& events() {
+  return *acquisition::sample_stall_events();
+}
+
+static void assert_no_events() {
+  const StallEvents& stall_events = events();
+  TEST_ASSERT_EQUAL(0, stall_events.items.size());
+  for (int type = 0; type < acquisition::NUM_STALL_EVENT_TYPES; type++) {
+    TEST_ASSERT_EQUAL(0, stall_events.counts[type]);
+  }
+}
+
+// True if the event is reported during the fault.
+static bool in_window(const StallEvent& event, const Fault& fault) {
+  return event.tick >= fault.tick &&
+         event.tick <= fault.end_tick + kTicksPerStep + kFilterTicks;
+}
+
+void test_clean_traces() {
+  // Starting, moving both ways, holding and stopping, at various
+  // speeds, currents and noise levels.
+  const double kHzs[] = {1, 20, 250, 1000, 2500};
+  const double kAmpsLevels[] = {0.3, 1.0, 2.0};
+  const double kNoiseCounts[] = {2, 5, 10};
+  for (double hz : kHzs) {
+    for (double amps : kAmpsLevels) {
+      for (double noise_counts : kNoiseCounts) {
+        Replay replay(noise_counts);
+        replay.play({20000, amps, 0});
+        replay.play({100000, amps, hz});
+        replay.play({20000, amps, 0});
+        replay.play({100000, amps, -hz});
+        replay.play({20000, amps, 0});
+        // Holding on a coil axis, where the noise flips the quadrant.
+        replay.move_to_step_fraction(0, amps, hz);
+        replay.play({20000, amps, 0});
+        replay.play({50000, 0, 0});
+        char message[80];
+        snprintf(message, sizeof(message), "%.0fHz, %.1fA, noise %.0f", hz,
+                 amps, noise_counts);
+        TEST_ASSERT_EQUAL_MESSAGE(0, events().items.size(), message);
+        TEST_ASSERT_EQUAL_MESSAGE(
+            0, acquisition::isr_data.axes[0].state.quadrature_errors,
+            message);
+      }
+    }
+  }
+}
+
+void test_quadrant_jumps() {
+  Replay replay(5);
+  replay.play({50000, kAmps, 0});
+  // A jump of two steps in the middle of a step, which the filters
+  // pass as two fast steps, and at the start of a step, which they
+  // pass as a current vector that crosses zero.
+  replay.move_to_step_fraction(0.5);
+  replay.inject_jump(2);
+  replay.play({1000, kAmps, kHz});
+  replay.move_to_step_fraction(0);
+  replay.inject_jump(2);
+  replay.play({1000, kAmps, kHz});
+
+  const StallEvents& stall_events = events();
+  TEST_ASSERT_EQUAL(2, stall_events.counts[acquisition::STALL_QUADRANT_JUMP]);
+  TEST_ASSERT_EQUAL(0,
+                    stall_events.counts[acquisition::STALL_CURRENT_COLLAPSE]);
+  TEST_ASSERT_EQUAL(1, stall_events.counts[acquisition::STALL_DISTORTED_STEP]);
+  TEST_ASSERT_EQUAL(3, stall_events.items.size());
+  const StallEvent& jump1 = *stall_events.items.get(0);
+  const StallEvent& distorted = *stall_events.items.get(1);
+  const StallEvent& jump2 = *stall_events.items.get(2);
+  TEST_ASSERT_EQUAL(acquisition::STALL_QUADRANT_JUMP, jump1.type);
+  TEST_ASSERT_EQUAL(acquisition::STALL_DISTORTED_STEP, distorted.type);
+  TEST_ASSERT_EQUAL(acquisition::STALL_QUADRANT_JUMP, jump2.type);
+  // The jumps are reported within a few ticks.
+  TEST_ASSERT_TRUE(jump1.tick >= replay.fault(0).tick);
+  TEST_ASSERT_TRUE(jump1.tick <= replay.fault(0).tick + kFilterTicks);
+  TEST_ASSERT_TRUE(jump2.tick >= replay.fault(1).tick);
+  TEST_ASSERT_TRUE(jump2.tick <= replay.fault(1).tick + kFilterTicks);
+  // The step after the first jump is dented by the fast steps. The
+  // second jump restarts the move, which has no steps to check yet.
+  TEST_ASSERT_TRUE(in_window(distorted, replay.fault(0)));
+  TEST_ASSERT_EQUAL(jump1.full_steps + 1, distorted.full_steps);
+}
+
+void test_current_collapse() {
+  Replay replay(5);
+  replay.play({50000, kAmps, 0});
+  // 10ms of a third of the current, while moving.
+  replay.move_to_step_fraction(0.5);
+  replay.inject_segment(acquisition::STALL_CURRENT_COLLAPSE,
+                        {1000, kAmps / 3, kHz});
+  replay.play({1000, kAmps, kHz});
+
+  // Reported once, after 2ms. The steps where the current collapses
+  // and recovers are distorted too.
+  const Fault& fault = replay.fault(0);
+  const StallEvents& stall_events = events();
+  TEST_ASSERT_EQUAL(1,
+                    stall_events.counts[acquisition::STALL_CURRENT_COLLAPSE]);
+  TEST_ASSERT_EQUAL(0, stall_events.counts[acquisition::STALL_QUADRANT_JUMP]);
+  TEST_ASSERT_EQUAL(2, stall_events.counts[acquisition::STALL_DISTORTED_STEP]);
+  TEST_ASSERT_EQUAL(3, stall_events.items.size());
+  const StallEvent& distorted1 = *stall_events.items.get(0);
+  const StallEvent& collapse = *stall_events.items.get(1);
+  const StallEvent& distorted2 = *stall_events.items.get(2);
+  TEST_ASSERT_EQUAL(acquisition::STALL_DISTORTED_STEP, distorted1.type);
+  TEST_ASSERT_EQUAL(acquisition::STALL_CURRENT_COLLAPSE, collapse.type);
+  TEST_ASSERT_EQUAL(acquisition::STALL_DISTORTED_STEP, distorted2.type);
+  TEST_ASSERT_TRUE(collapse.tick >= fault.tick + acquisition::kCollapseTicks);
+  TEST_ASSERT_TRUE(collapse.tick <=
+                   fault.tick + acquisition::kCollapseTicks + kFilterTicks);
+  // The step in which the current collapsed and the step in which it
+  // recovered.
+  TEST_ASSERT_TRUE(in_window(distorted1, fault));
+  TEST_ASSERT_TRUE(distorted1.tick < collapse.tick);
+  TEST_ASSERT_TRUE(in_window(distorted2, fault));
+  TEST_ASSERT_TRUE(distorted2.tick > fault.end_tick);
+
+  // Without a move, a lower holding current is not a collapse.
+  acquisition::reset_state();
+  replay.play({20000, kAmps, 0});
+  replay.play({20000, kAmps / 3, 0});
+  assert_no_events();
+}
+
+void test_distorted_steps() {
+  Replay replay(5);
+  replay.play({50000, kAmps, 0});
+  // An elliptic current trajectory for 20 steps. Each of these steps
+  // is reported, and the ring keeps the last 16.
+  replay.move_to_step_fraction(0);
+  replay.inject_segment(acquisition::STALL_DISTORTED_STEP,
+                        {20 * kTicksPerStep, kAmps, kHz, 0.4});
+  replay.play({1000, kAmps, kHz});
+
+  const Fault& fault = replay.fault(0);
+  const StallEvents& stall_events = events();
+  TEST_ASSERT_EQUAL(20,
+                    stall_events.counts[acquisition::STALL_DISTORTED_STEP]);
+  TEST_ASSERT_EQUAL(0, stall_events.counts[acquisition::STALL_QUADRANT_JUMP]);
+  TEST_ASSERT_EQUAL(0,
+                    stall_events.counts[acquisition::STALL_CURRENT_COLLAPSE]);
+  TEST_ASSERT_EQUAL(acquisition::kNumStallEvents, stall_events.items.size());
+  for (int i = 0; i < stall_events.items.size(); i++) {
+    const StallEvent& event = *stall_events.items.get(i);
+    TEST_ASSERT_EQUAL(acquisition::STALL_DISTORTED_STEP, event.type);
+    TEST_ASSERT_TRUE(in_window(event, fault));
+    // One per step, in order.
+    if (i > 0) {
+      const StallEvent& prev_event = *stall_events.items.get(i - 1);
+      TEST_ASSERT_EQUAL(prev_event.full_steps + 1, event.full_steps);
+      TEST_ASSERT_UINT32_WITHIN(kFilterTicks, kTicksPerStep,
+                                event.tick - prev_event.tick);
+    }
+  }
+}
+
+// Injects faults of each type at various points of a step, and
+// measures the precision and recall of the detection.
+void test_precision_recall() {
+  Replay replay(5);
+  replay.play({50000, kAmps, 0});
+  constexpr int kPoints = 32;
+  int num_events = 0;
+  int true_positives = 0;
+  int num_faults[acquisition::NUM_STALL_EVENT_TYPES] = {};
+  int detected[acquisition::NUM_STALL_EVENT_TYPES] = {};
+  for (int i = 0; i < kPoints; i++) {
+    for (int type = 0; type < acquisition::NUM_STALL_EVENT_TYPES; type++) {
+      acquisition::reset_state();
+      replay.move_to_step_fraction((double)i / kPoints);
+      switch (type) {
+        case acquisition::STALL_QUADRANT_JUMP:
+          replay.inject_jump(2);
+          break;
+        case acquisition::STALL_CURRENT_COLLAPSE:
+          replay.inject_segment(acquisition::STALL_CURRENT_COLLAPSE,
+                                {500, kAmps / 3, kHz});
+          break;
+        default:
+          replay.inject_segment(acquisition::STALL_DISTORTED_STEP,
+                                {4 * kTicksPerStep, kAmps, kHz, 0.4});
+          break;
+      }
+      replay.play({5000, kAmps, kHz});
+
+      // An event is a true positive if it's reported during a fault of
+      // any type, since a fault can cause events of other types too,
+      // e.g. a collapse distorts its steps. A fault is detected if an
+      // event of its type is reported during it.
+      const Fault& fault = replay.fault(replay.num_faults() - 1);
+      const StallEvents& stall_events = events();
+      TEST_ASSERT_TRUE(stall_events.items.size() <
+                       acquisition::kNumStallEvents);
+      bool is_detected = false;
+      for (int j = 0; j < stall_events.items.size(); j++) {
+        const StallEvent& event = *stall_events.items.get(j);
+        num_events++;
+        if (in_window(event, fault)) {
+          true_positives++;
+          is_detected |= event.type == fault.type;
+        }
+      }
+      num_faults[type]++;
+      detected[type] += is_detected;
+    }
+  }
+
+  char message[120];
+  snprintf(message, sizeof(message),
+           "Precision %d/%d. Recall: jumps %d/%d, collapses %d/%d, "
+           "distorted steps %d/%d",
+           true_positives, num_events, detected[0], num_faults[0],
+           detected[1], num_faults[1], detected[2], num_faults[2]);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_EQUAL(num_events, true_positives);
+  for (int type = 0; type < acquisition::NUM_STALL_EVENT_TYPES; type++) {
+    TEST_ASSERT_EQUAL(num_faults[type], detected[type]);
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_clean_traces);
+  RUN_TEST(test_quadrant_jumps);
+  RUN_TEST(test_current_collapse);
+  RUN_TEST(test_distorted_steps);
+  RUN_TEST(test_precision_recall);
+  return UNITY_END();
+}
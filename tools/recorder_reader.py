@@ -0,0 +1,93 @@
+# Reads an image of a recorder block device, e.g. a raw copy of an SD
+# card, and prints its records as CSV lines, oldest first. See
+# platformio/src/misc/recorder.h for the format.
+#
+# Usage:
+# ------
+# $ sudo dd if=/dev/sdX of=recorder.img bs=1M
+# $ python3 recorder_reader.py recorder.img > records.csv
+#
+# Output lines:
+# SNAPSHOT,session,block_seq,millis,full_steps,quadrature_errors,non_energized_count,total_moves,energized
+# MOVE,session,block_seq,move_number,start_ms,duration_ms,steps,peak_steps_per_sec,avg_peak_ma,quadrature_errors
+#
+# platformio/test/test_recorder writes a test image and checks this
+# reader's output.
+#
+# Invalid blocks, e.g. a block that was written during a power loss,
+# are skipped and counted on stderr.
+
+import struct
+import sys
+import zlib
+
+BLOCK_SIZE = 512
+BLOCK_HEADER_SIZE = 20
+BLOCK_MAGIC = 0x31444352  # "RCD1"
+
+RECORD_SNAPSHOT = 1
+RECORD_MOVE = 2
+
+
+# Returns (sequence, session, payload) of a valid block, else None.
+def parse_block(block, block_number, num_blocks):
+    magic, sequence, session, payload_size, _, crc = struct.unpack_from(
+        "<IIIHHI", block)
+    if magic != BLOCK_MAGIC or payload_size > BLOCK_SIZE - BLOCK_HEADER_SIZE:
+        return None
+    payload = block[BLOCK_HEADER_SIZE:BLOCK_HEADER_SIZE + payload_size]
+    if zlib.crc32(block[:16] + payload) != crc:
+        return None
+    if sequence % num_blocks != block_number:
+        return None
+    return (sequence, session, payload)
+
+
+def print_records(sequence, session, payload):
+    i = 0
+    while i + 2 <= len(payload):
+        record_type, size = payload[i], payload[i + 1]
+        body = payload[i + 2:i + 2 + size]
+        i += 2 + size
+        if record_type == RECORD_SNAPSHOT and size >= 26:
+            millis, full_steps, errors, non_energized, total_moves, energized = \
+                struct.unpack_from("<IqIIIB", body)
+            print("SNAPSHOT,%d,%d,%d,%d,%d,%d,%d,%d" %
+                  (session, sequence, millis, full_steps, errors,
+                   non_energized, total_moves, energized))
+        elif record_type == RECORD_MOVE and size >= 24:
+            number, start, duration, steps, speed, current, errors = \
+                struct.unpack_from("<IIIiIHH", body)
+            print("MOVE,%d,%d,%d,%d,%d,%d,%d,%d,%d" %
+                  (session, sequence, number, start, duration, steps, speed,
+                   current, errors))
+        # Else, a record type of a newer format. Skip.
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit("Usage: python3 recorder_reader.py image_file")
+    with open(sys.argv[1], "rb") as f:
+        image = f.read()
+    num_blocks = len(image) // BLOCK_SIZE
+
+    blocks = []
+    num_invalid = 0
+    for block_number in range(num_blocks):
+        block = image[block_number * BLOCK_SIZE:(block_number + 1) * BLOCK_SIZE]
+        parsed = parse_block(block, block_number, num_blocks)
+        if parsed:
+            blocks.append(parsed)
+        elif block != b"\xff" * BLOCK_SIZE and block != b"\x00" * BLOCK_SIZE:
+            num_invalid += 1
+
+    # The log is circular, the sequence numbers give the order.
+    blocks.sort()
+    for sequence, session, payload in blocks:
+        print_records(sequence, session, payload)
+
+    print("%d blocks, %d invalid blocks" % (len(blocks), num_invalid),
+          file=sys.stderr)
+
+
+main()